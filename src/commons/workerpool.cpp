@@ -0,0 +1,114 @@
+// Copyright (c) 2017-2020 The DragonBallChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "workerpool.h"
+
+#include "commons/util/util.h"
+
+CWorkerPool::CWorkerPool(const std::string &nameIn, uint32_t workerCount) : name(nameIn) {
+    threads.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; i++) {
+        threads.emplace_back(&CWorkerPool::WorkerLoop, this, i);
+    }
+}
+
+CWorkerPool::~CWorkerPool() { Stop(); }
+
+void CWorkerPool::Stop() {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (stopping) return;
+        stopping = true;
+    }
+    workCond.notify_all();
+
+    for (auto &t : threads) {
+        if (t.joinable()) t.join();
+    }
+    threads.clear();
+}
+
+size_t CWorkerPool::RunItems() {
+    size_t processed = 0;
+    while (true) {
+        size_t index = nextIndex.fetch_add(1);
+        if (index >= jobCount) break;
+
+        (*pJobFunc)(index);
+        processed++;
+    }
+    return processed;
+}
+
+void CWorkerPool::ParallelFor(size_t count, const ItemFunc &func) {
+    if (count == 0) return;
+
+    std::unique_lock<std::mutex> jobLock(jobMutex);
+
+    if (threads.empty() || count == 1) {
+        for (size_t i = 0; i < count; i++)
+            func(i);
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        pJobFunc     = &func;
+        jobCount     = count;
+        pendingCount = count;
+        nextIndex    = 0;
+        jobSeq++;
+    }
+    workCond.notify_all();
+
+    size_t processed = RunItems();
+
+    std::unique_lock<std::mutex> lock(mtx);
+    pendingCount -= processed;
+    // wait for the workers to leave the job too, so none of them can pick an item of the next job with
+    // the stale job function
+    doneCond.wait(lock, [this]() { return pendingCount == 0 && activeWorkers == 0; });
+    pJobFunc = nullptr;
+    jobCount = 0;
+}
+
+void CWorkerPool::WorkerLoop(uint32_t id) {
+    RenameThread(strprintf("coin-%s.%u", name, id).c_str());
+
+    uint64_t lastSeq = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            workCond.wait(lock, [&]() { return stopping || jobSeq != lastSeq; });
+            if (stopping) return;
+
+            lastSeq = jobSeq;
+            if (pendingCount == 0) continue;  // job finished before this worker woke up
+            activeWorkers++;
+        }
+
+        size_t processed = RunItems();
+
+        std::unique_lock<std::mutex> lock(mtx);
+        pendingCount -= processed;
+        activeWorkers--;
+        if (pendingCount == 0 && activeWorkers == 0)
+            doneCond.notify_all();
+    }
+}
+
+uint32_t GetWorkerCountFromArg(int64_t parArg, uint32_t maxCount) {
+    int64_t count = parArg;
+    if (count <= 0)
+        count += std::thread::hardware_concurrency();
+
+    // the caller thread always takes part in a job, so it is not counted as a worker
+    count -= 1;
+    if (count < 0)
+        count = 0;
+    if (count > maxCount)
+        count = maxCount;
+
+    return count;
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2017-2020 The DragonBallChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef COIN_COMMONS_WORKERPOOL_H
+#define COIN_COMMONS_WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed-size pool of worker threads for CPU bound batch jobs.
+ *
+ * A job is a range of independent items [0, count) handed out to the workers one index at a time.
+ * The calling thread takes part in the job too and ParallelFor() only returns when every item is done,
+ * so a pool with zero workers simply degrades to a plain loop on the caller.
+ */
+class CWorkerPool {
+public:
+    typedef std::function<void(size_t index)> ItemFunc;
+
+public:
+    CWorkerPool(const std::string &nameIn, uint32_t workerCount);
+    ~CWorkerPool();
+
+    CWorkerPool(const CWorkerPool &) = delete;
+    CWorkerPool &operator=(const CWorkerPool &) = delete;
+
+    /** Run func(i) for every i in [0, count) and wait for all of them to complete.
+     *  Concurrent callers are serialized, one job runs on the pool at a time. */
+    void ParallelFor(size_t count, const ItemFunc &func);
+
+    /** Number of background workers, the caller thread not included */
+    uint32_t GetWorkerCount() const { return threads.size(); }
+
+    void Stop();
+
+private:
+    void WorkerLoop(uint32_t id);
+    // process items of the current job, return the count of processed items
+    size_t RunItems();
+
+private:
+    std::string name;
+    std::vector<std::thread> threads;
+
+    std::mutex jobMutex;  // serializes ParallelFor() callers
+
+    std::mutex mtx;
+    std::condition_variable workCond;
+    std::condition_variable doneCond;
+    const ItemFunc *pJobFunc = nullptr;
+    size_t jobCount          = 0;
+    size_t pendingCount      = 0;
+    uint32_t activeWorkers   = 0;
+    uint64_t jobSeq          = 0;
+    bool stopping            = false;
+    std::atomic<size_t> nextIndex{0};
+};
+
+/** Worker count derived from a "-par" like option: 0 = auto, <0 = leave that many cores free */
+uint32_t GetWorkerCountFromArg(int64_t parArg, uint32_t maxCount);
+
+#endif  // COIN_COMMONS_WORKERPOOL_H
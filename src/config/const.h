@@ -178,6 +178,25 @@ static const int64_t DEFAULT_DB_CACHE = 100;
 static const int64_t MAX_DB_CACHE = sizeof(void *) > 4 ? 4096 : 1024;
 /** min. -dbcache in (MiB) */
 static const int64_t MIN_DB_CACHE = 4;
+/** max. number of keys remembered as absent by each layer of a db cache, all are dropped when exceeded */
+static const size_t DB_CACHE_MAX_ABSENT_KEYS = 100000;
+/** max. bytes of the contract code and abi held by the contract metadata of a view, all are dropped when exceeded */
+static const uint64_t MAX_CONTRACT_METAS_SIZE = 8 << 20;
+/** Min. seconds between two snapshots of the memory-only caches written with the chain state */
+static const int64_t MEM_CACHE_SNAPSHOT_INTERVAL = 10 * 60;
+
+/** max. number of signature verification threads (-par) */
+static const int32_t MAX_SIG_CHECK_THREADS = 64;
+/** number of signatures verified in one batch by the signature verification threads */
+static const size_t SIG_CHECK_BATCH_SIZE = 16;
+
+/** Default for -maxmempool, maximum megabytes of the memory pool */
+static const int64_t DEFAULT_MAX_MEMPOOL_SIZE = 300;
+/** min. number of pool txs to re-execute them on the signature checking threads after a new tip */
+static const size_t MEMPOOL_PARALLEL_RESCAN_MIN_TXS = 1000;
+
+/** Default for -maxrecentblockcache, maximum megabytes of the recently connected blocks kept deserialized */
+static const int64_t DEFAULT_MAX_RECENT_BLOCK_CACHE_SIZE = 64;
 
 /** Coinbase transaction outputs can only be spent after this number of new blocks (network rule) */
 static const int32_t BLOCK_REWARD_MATURITY = 100;
@@ -388,6 +388,30 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdsa_verify(
     const secp256k1_pubkey *pubkey
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
 
+/** Verify a batch of ECDSA signatures with a single context.
+ *
+ *  Returns: 1: all signatures are correct
+ *           0: at least one signature is incorrect
+ *  Args:    ctx:       a secp256k1 context object, initialized for verification.
+ *  Out:     results:   array of n ints, set to 1 for every correct signature and 0 otherwise
+ *  In:      sigs:      array of n pointers to the signatures being verified
+ *           msgs32:    array of n pointers to the 32-byte message hashes being verified
+ *           pubkeys:   array of n pointers to initialized public keys to verify with
+ *           n:         the number of signatures
+ *
+ *  The result of every item is the same as secp256k1_ecdsa_verify on it. Items
+ *  may share the signature or public key objects, consecutive items pointing to
+ *  the same public key object load it only once.
+ */
+SECP256K1_API int secp256k1_ecdsa_verify_batch(
+    const secp256k1_context* ctx,
+    int *results,
+    const secp256k1_ecdsa_signature *const *sigs,
+    const unsigned char *const *msgs32,
+    const secp256k1_pubkey *const *pubkeys,
+    size_t n
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5);
+
 /** Convert a signature to a normalized lower-S form.
  *
  *  Returns: 1 if sigin was not normalized, 0 if it already was.
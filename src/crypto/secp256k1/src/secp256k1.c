@@ -307,6 +307,40 @@ int secp256k1_ecdsa_verify(const secp256k1_context* ctx, const secp256k1_ecdsa_s
             secp256k1_ecdsa_sig_verify(&ctx->ecmult_ctx, &r, &s, &q, &m));
 }
 
+int secp256k1_ecdsa_verify_batch(const secp256k1_context* ctx, int *results, const secp256k1_ecdsa_signature *const *sigs, const unsigned char *const *msgs32, const secp256k1_pubkey *const *pubkeys, size_t n) {
+    secp256k1_ge q;
+    secp256k1_scalar r, s;
+    secp256k1_scalar m;
+    const secp256k1_pubkey *loaded = NULL;
+    int loaded_ok = 0;
+    int all_ok = 1;
+    size_t i;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(results != NULL);
+    ARG_CHECK(sigs != NULL);
+    ARG_CHECK(msgs32 != NULL);
+    ARG_CHECK(pubkeys != NULL);
+
+    for (i = 0; i < n; i++) {
+        ARG_CHECK(sigs[i] != NULL);
+        ARG_CHECK(msgs32[i] != NULL);
+        ARG_CHECK(pubkeys[i] != NULL);
+
+        if (pubkeys[i] != loaded) {
+            loaded = pubkeys[i];
+            loaded_ok = secp256k1_pubkey_load(ctx, &q, loaded);
+        }
+        secp256k1_scalar_set_b32(&m, msgs32[i], NULL);
+        secp256k1_ecdsa_signature_load(ctx, &r, &s, sigs[i]);
+        results[i] = (!secp256k1_scalar_is_high(&s) &&
+                      loaded_ok &&
+                      secp256k1_ecdsa_sig_verify(&ctx->ecmult_ctx, &r, &s, &q, &m));
+        all_ok &= results[i];
+    }
+    return all_ok;
+}
+
 static int nonce_function_rfc6979(unsigned char *nonce32, const unsigned char *msg32, const unsigned char *key32, const unsigned char *algo16, void *data, unsigned int counter) {
    unsigned char keydata[112];
    int keylen = 64;
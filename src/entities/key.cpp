@@ -209,6 +209,128 @@ bool CPubKey::Verify(const uint256 &hash, const vector<uint8_t> &vchSig) const {
     return secp256k1_ecdsa_verify(secp256k1_context_verify, &sig, hash.begin(), &pubkey);
 }
 
+bool CPubKey::VerifyBatch(const vector<CSignatureCheck> &checks, vector<bool> &results) {
+    const size_t count = checks.size();
+    results.assign(count, false);
+    if (count == 0) return true;
+
+    // parse the distinct public keys
+    vector<secp256k1_pubkey> pubkeys;
+    vector<int32_t> pubkeyIndexes(count, -1);
+    map<vector<uint8_t>, int32_t> pubkeyMap;
+    for (size_t i = 0; i < count; i++) {
+        const CPubKey &pubKey = checks[i].pubKey;
+        if (!pubKey.IsValid())
+            continue;
+
+        vector<uint8_t> raw(pubKey.begin(), pubKey.end());
+        auto it = pubkeyMap.find(raw);
+        if (it == pubkeyMap.end()) {
+            secp256k1_pubkey parsed;
+            int32_t index = -1;
+            if (secp256k1_ec_pubkey_parse(secp256k1_context_verify, &parsed, pubKey.begin(), pubKey.size())) {
+                index = pubkeys.size();
+                pubkeys.push_back(parsed);
+            }
+            it = pubkeyMap.emplace(raw, index).first;
+        }
+        pubkeyIndexes[i] = it->second;
+    }
+
+    // parse and normalize the distinct signatures, items of the same (signature, hash) share one group
+    vector<secp256k1_ecdsa_signature> sigs;
+    vector<vector<size_t>> sigGroups;
+    map<pair<vector<uint8_t>, uint256>, int32_t> sigMap;
+    map<vector<uint8_t>, int32_t> parsedSigMap;
+    vector<int32_t> groupSigIndexes;
+    for (size_t i = 0; i < count; i++) {
+        if (pubkeyIndexes[i] < 0)
+            continue;
+
+        const CSignatureCheck &check = checks[i];
+        auto groupIt = sigMap.find(make_pair(check.signature, check.sigHash));
+        if (groupIt == sigMap.end()) {
+            auto sigIt = parsedSigMap.find(check.signature);
+            if (sigIt == parsedSigMap.end()) {
+                secp256k1_ecdsa_signature sig;
+                int32_t index = -1;
+                if (ecdsa_signature_parse_der_lax(secp256k1_context_verify, &sig, check.signature.data(),
+                                                  check.signature.size())) {
+                    secp256k1_ecdsa_signature_normalize(secp256k1_context_verify, &sig, &sig);
+                    index = sigs.size();
+                    sigs.push_back(sig);
+                }
+                sigIt = parsedSigMap.emplace(check.signature, index).first;
+            }
+            if (sigIt->second < 0)
+                continue;
+
+            groupIt = sigMap.emplace(make_pair(check.signature, check.sigHash), sigGroups.size()).first;
+            sigGroups.emplace_back();
+            groupSigIndexes.push_back(sigIt->second);
+        }
+        sigGroups[groupIt->second].push_back(i);
+    }
+
+    vector<const secp256k1_ecdsa_signature *> batchSigs;
+    vector<const uint8_t *> batchMsgs;
+    vector<const secp256k1_pubkey *> batchPubkeys;
+    vector<size_t> batchItems;
+    for (size_t g = 0; g < sigGroups.size(); g++) {
+        const auto &items = sigGroups[g];
+        const secp256k1_ecdsa_signature &sig = sigs[groupSigIndexes[g]];
+        const uint256 &hash = checks[items[0]].sigHash;
+
+        if (items.size() < SIG_RECOVER_FANOUT_MIN) {
+            for (auto i : items) {
+                batchSigs.push_back(&sig);
+                batchMsgs.push_back(hash.begin());
+                batchPubkeys.push_back(&pubkeys[pubkeyIndexes[i]]);
+                batchItems.push_back(i);
+            }
+            continue;
+        }
+
+        // The normalized signature is valid for a public key if and only if the key is one of the keys recovered
+        // with the recovery ids 0..3, so two or so recoveries answer all the items of the group.
+        uint8_t compact[64];
+        secp256k1_ecdsa_signature_serialize_compact(secp256k1_context_verify, compact, &sig);
+        vector<vector<uint8_t>> signers;
+        for (int32_t recid = 0; recid < 4; recid++) {
+            secp256k1_ecdsa_recoverable_signature rsig;
+            secp256k1_pubkey recovered;
+            if (!secp256k1_ecdsa_recoverable_signature_parse_compact(secp256k1_context_verify, &rsig, compact, recid) ||
+                !secp256k1_ecdsa_recover(secp256k1_context_verify, &recovered, &rsig, hash.begin()))
+                continue;
+
+            vector<uint8_t> signer(PUBLIC_KEY_SIZE);
+            size_t len = PUBLIC_KEY_SIZE;
+            secp256k1_ec_pubkey_serialize(secp256k1_context_verify, signer.data(), &len, &recovered,
+                                          SECP256K1_EC_UNCOMPRESSED);
+            signers.push_back(signer);
+        }
+
+        for (auto i : items) {
+            vector<uint8_t> key(PUBLIC_KEY_SIZE);
+            size_t len = PUBLIC_KEY_SIZE;
+            secp256k1_ec_pubkey_serialize(secp256k1_context_verify, key.data(), &len, &pubkeys[pubkeyIndexes[i]],
+                                          SECP256K1_EC_UNCOMPRESSED);
+            results[i] = std::find(signers.begin(), signers.end(), key) != signers.end();
+        }
+    }
+
+    if (!batchItems.empty()) {
+        vector<int> batchResults(batchItems.size(), 0);
+        secp256k1_ecdsa_verify_batch(secp256k1_context_verify, batchResults.data(), batchSigs.data(),
+                                     batchMsgs.data(), batchPubkeys.data(), batchItems.size());
+        for (size_t k = 0; k < batchItems.size(); k++) {
+            results[batchItems[k]] = batchResults[k] != 0;
+        }
+    }
+
+    return std::all_of(results.begin(), results.end(), [](bool valid) { return valid; });
+}
+
 bool CPubKey::RecoverCompact(const uint256 &hash, const vector<uint8_t> &vchSig) {
     if (vchSig.size() != COMPACT_SIGNATURE_SIZE) return false;
 
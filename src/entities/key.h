@@ -22,6 +22,10 @@
 using namespace std;
 
 class CRegID;
+struct CSignatureCheck;
+
+// a signature matched against at least this count of public keys is checked by public key recovery
+static const size_t SIG_RECOVER_FANOUT_MIN = 3;
 
 /** A reference to a CKey: the Hash160 of its serialized public key */
 class CKeyID : public uint160 {
@@ -206,6 +210,13 @@ public:
     // If this public key is not fully valid, the return value will be false.
     bool Verify(const uint256 &hash, const vector<uint8_t> &vchSig) const;
 
+    // Verify a batch of (hash, pubkey, DER signature) triples with the shared verification context. Every
+    // distinct public key and signature is parsed and normalized only once, and a signature checked against
+    // several public keys (multisig matching) is answered by recovering its candidate signers instead of
+    // verifying it against each key. results[i] is the same as checks[i].pubKey.Verify(...).
+    // Return true if all of the signatures are valid.
+    static bool VerifyBatch(const vector<CSignatureCheck> &checks, vector<bool> &results);
+
     // Recover a public key from a compact signature.
     bool RecoverCompact(const uint256 &hash, const vector<uint8_t> &vchSig);
 
@@ -216,6 +227,17 @@ public:
     bool Derive(CPubKey &pubkeyChild, uint8_t ccChild[32], uint32_t nChild, const uint8_t cc[32]) const;
 };
 
+/** A pending signature check: the signed hash, the expected signer and the DER signature */
+struct CSignatureCheck {
+    uint256 sigHash;
+    CPubKey pubKey;
+    vector<uint8_t> signature;
+
+    CSignatureCheck() {}
+    CSignatureCheck(const uint256 &sigHashIn, const CPubKey &pubKeyIn, const vector<uint8_t> &signatureIn)
+        : sigHash(sigHashIn), pubKey(pubKeyIn), signature(signatureIn) {}
+};
+
 // secure_allocator is defined in allocators.h
 // CPrivKey is a serialized private key, with all parameters included (279 bytes)
 typedef vector<uint8_t, secure_allocator<uint8_t> > CPrivKey;
@@ -145,6 +145,7 @@ void Shutdown() {
 
     StopNode();
     UnregisterNodeSignals(GetNodeSignals());
+    StopSigCheckThreads();
 
     {
         LOCK(cs_main);
@@ -220,8 +221,12 @@ string HelpMessage() {
     strUsage += "  -datadir=<dir>         " + _("Specify data directory") + "\n";
     strUsage += "  -dbcache=<n>           " + strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), MIN_DB_CACHE, MAX_DB_CACHE, DEFAULT_DB_CACHE) + "\n";
     strUsage += "  -loadblock=<file>      " + _("Imports blocks from external blk000??.dat file") + " " + _("on startup") + "\n";
+    strUsage += "  -par=<n>               " + strprintf(_("Set the number of signature verification threads (up to %d, 0 = auto, <0 = leave that many cores free, default: 0)"), MAX_SIG_CHECK_THREADS) + "\n";
+    strUsage += "  -maxmempool=<n>        " + strprintf(_("Keep the memory pool below <n> megabytes, evicting the txs with the lowest fee rate (default: %d)"), DEFAULT_MAX_MEMPOOL_SIZE) + "\n";
     strUsage += "  -pid=<file>            " + _("Specify pid file (default: coin.pid)") + "\n";
     strUsage += "  -reindex               " + _("Rebuild block chain index from current blk000??.dat files") + " " + _("on startup") + "\n";
+    strUsage += "  -singlestatedb         " + _("Keep all the chain state databases in one store, committed with one synced write per flush (default: 0, changing it needs -reindex)") + "\n";
+    strUsage += "  -db_<option>_<dbname> " + _("Override the LevelDB tuning of a chain state database (or of \"state\" with -singlestatedb), <option> is one of bloom_bits, block_size, max_open_files, write_buffer_size") + "\n";
     strUsage += "  -txindex               " + _("Maintain a full transaction index (default: 0)") + "\n";
     strUsage += "  -txtrace               " + _("Maintain trace of transaction (default: 1)") + "\n";
     strUsage += "  -logfailures           " + _("Log failures into level db in detail (default: 0)") + "\n";
@@ -232,6 +237,7 @@ string HelpMessage() {
     strUsage += "  -banscore=<n>          " + _("Threshold for disconnecting misbehaving peers (default: 100)") + "\n";
     strUsage += "  -bantime=<n>           " + _("Number of seconds to keep misbehaving peers from reconnecting (default: 86400)") + "\n";
     strUsage += "  -bind=<addr>           " + _("Bind to given address and always listen on it. Use [host]:port notation for IPv6") + "\n";
+    strUsage += "  -cmpctblocks           " + _("Ask the peers to relay the blocks as compact blocks rebuilt from the mempool (default: 1)") + "\n";
     strUsage += "  -connect=<ip>          " + _("Connect only to the specified node(s)") + "\n";
     strUsage += "  -discover              " + _("Discover own IP address (default: 1 when listening and no -externalip)") + "\n";
     strUsage += "  -dns                   " + _("Allow DNS lookups for -addnode, -seednode and -connect") + " " + _("(default: 1)") + "\n";
@@ -249,6 +255,7 @@ string HelpMessage() {
     strUsage += "  -ipserver=<server>     " + _("IP Reporting Service") + "\n";
     strUsage += "  -seednode=<ip>         " + _("Connect to a node to retrieve peer addresses, and disconnect") + "\n";
     strUsage += "  -socks=<n>             " + _("Select SOCKS version for -proxy (4 or 5, default: 5)") + "\n";
+    strUsage += "  -socketevents=<mode>   " + _("Wait for the socket events with <mode> (epoll or select, default: epoll on Linux)") + "\n";
     strUsage += "  -timeout=<n>           " + _("Specify connection timeout in milliseconds (default: 5000)") + "\n";
 #ifdef USE_UPNP
 #if USE_UPNP
@@ -291,7 +298,8 @@ string HelpMessage() {
     strUsage += "  -logtimestamps         " + _("Prepend debug output with timestamp (default: 1)") + "\n";
     if (SysCfg().GetBoolArg("-help-debug", false)) {
         strUsage += "  -limitfreerelay=<n>    " + _("Continuously rate-limit free transactions to <n>*1000 bytes per minute (default:15)") + "\n";
-        strUsage += "  -maxsigcachesize=<n>   " + _("Limit size of signature cache to <n> entries (default: 50000)") + "\n";
+        strUsage += "  -maxsigcachemb=<n>     " + strprintf(_("Limit size of signature cache to <n> MiB (default: %d)"), DEFAULT_MAX_SIG_CACHE_SIZE) + "\n";
+        strUsage += "  -maxrecentblockcache=<n> " + strprintf(_("Keep up to <n> MiB of the recently connected blocks in memory (default: %d)"), DEFAULT_MAX_RECENT_BLOCK_CACHE_SIZE) + "\n";
     }
     strUsage += "  -logprinttoconsole     " + _("Send trace/debug info to console instead of debug.log file") + "\n";
     if (SysCfg().GetBoolArg("-help-debug", false)) {
@@ -528,16 +536,25 @@ bool AppInit(boost::thread_group &threadGroup) {
 
     SysCfg().SetTxTrace(SysCfg().GetBoolArg("-txtrace", true));
 
-    // Make sure enough file descriptors are available
+    // Make sure enough file descriptors are available. select() only waits for the sockets below FD_SETSIZE,
+    // the epoll loop is limited by RLIMIT_NOFILE alone
     int32_t nBind   = max((int32_t)SysCfg().IsArgCount("-bind"), 1);
-    nMaxConnections = SysCfg().GetArg("-maxconnections", 125);
-    nMaxConnections = max(min(nMaxConnections, (int32_t)(FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS)), 0);
-    int32_t nFD     = RaiseFileDescriptorLimit(nMaxConnections + MIN_CORE_FILEDESCRIPTORS);
-    if (nFD < MIN_CORE_FILEDESCRIPTORS)
-        return InitError(_("Not enough file descriptors available."));
+    nMaxConnections = max((int32_t)SysCfg().GetArg("-maxconnections", 125), 0);
+    if (!UseSocketEventsEpoll())
+        nMaxConnections = max(min(nMaxConnections, (int32_t)(FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS)), 0);
+#ifdef WIN32
+    int32_t nCoreFD = MIN_CORE_FILEDESCRIPTORS;
+#else
+    // the LevelDB stores may keep their max_open_files open besides the core descriptors
+    int32_t nCoreFD = MIN_CORE_FILEDESCRIPTORS + CCacheDBManager::GetMaxOpenDbFiles();
+#endif
+    int32_t nFD     = RaiseFileDescriptorLimit(nMaxConnections + nCoreFD);
+    if (nFD < nCoreFD)
+        return InitError(strprintf(_("Not enough file descriptors available, %d needed without the peers. Lower "
+                                     "-db_max_open_files_<dbname> or raise the limit of open files."), nCoreFD));
 
-    if (nFD - MIN_CORE_FILEDESCRIPTORS < nMaxConnections)
-        nMaxConnections = nFD - MIN_CORE_FILEDESCRIPTORS;
+    if (nFD - nCoreFD < nMaxConnections)
+        nMaxConnections = nFD - nCoreFD;
 
     SysCfg().SetBenchMark(SysCfg().GetBoolArg("-benchmark", false));
     mempool.SetSanityCheck(SysCfg().GetBoolArg("-checkmempool", RegTest()));
@@ -695,6 +712,13 @@ bool AppInit(boost::thread_group &threadGroup) {
 
     SysCfg().SetGenReceipt(SysCfg().GetBoolArg("-genreceipt", false));
 
+    InitSignatureCache();
+
+    int64_t recentBlockCacheSize = std::max<int64_t>(0, SysCfg().GetArg("-maxrecentblockcache", DEFAULT_MAX_RECENT_BLOCK_CACHE_SIZE));
+    recentBlockCache.Setup(recentBlockCacheSize << 20, std::max(BLOCK_REWARD_MATURITY, SysCfg().GetTxCacheHeight()));
+
+    StartSigCheckThreads();
+
     filesystem::path blocksDir = GetDataDir() / "blocks";
     if (!filesystem::exists(blocksDir)) {
         filesystem::create_directories(blocksDir);
@@ -816,26 +840,8 @@ bool AppInit(boost::thread_group &threadGroup) {
     if (!ActivateBestChain(state))
         return InitError("Failed to connect best block");
 
-    nStart                   = GetTimeMillis();
-    CBlockIndex *pBlockIndex = chainActive.Tip();
-    int32_t nCacheHeight     = SysCfg().GetTxCacheHeight();
-    int32_t nCount           = 0;
-    CBlock block;
-    while (pBlockIndex && nCacheHeight-- > 0) {
-        if (!ReadBlockFromDisk(pBlockIndex, block))
-            return InitError("Failed to read block from disk");
-
-        if (!pCdMan->pTxCache->AddBlockTx(block))
-            return InitError("Failed to add block to transaction memory cache");
-
-        pBlockIndex = pBlockIndex->pprev;
-        ++nCount;
-    }
-    LogPrint(BCLog::INFO, "Added the latest %d blocks to transaction memory cache (%dms)\n", nCount, GetTimeMillis() - nStart);
-
-    if (!pCdMan->pPpCache->ReleadBlocks(*pCdMan->pSysParamCache, chainActive.Tip())) {
-        return InitError("Init prices of PriceFeedMemCache failed");
-    }
+    if (!pCdMan->LoadMemCaches(chainActive.Tip()))
+        return InitError("Failed to load the memory caches");
 
     vector<boost::filesystem::path> vImportFiles;
     if (SysCfg().IsArgCount("-loadblock")) {
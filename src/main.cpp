@@ -23,14 +23,17 @@
 #include "commons/json/json_spirit_value.h"
 #include "commons/json/json_spirit_writer_template.h"
 #include "p2p/chainmessage.h"
+#include "p2p/compactblock.h"
 #include "p2p/processmessage.hpp"
 #include "p2p/sendmessage.hpp"
 #include "chain/blockdelegates.h"
 #include "persistence/blockundo.h"
 #include "tx/txserializer.h"
+#include "commons/workerpool.h"
 
 #include <sstream>
 #include <algorithm>
+#include <limits>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
@@ -55,6 +58,7 @@ int32_t nSyncTipHeight = 0;
 string publicIp;
 map<uint256/* blockhash */, std::shared_ptr<CCacheWrapper>> mapForkCache;
 CSignatureCache signatureCache;
+static std::unique_ptr<CWorkerPool> pSigCheckPool;
 CChainActive chainActive;
 CChain chainMostWork;
 // may contain all CBlockIndex*'s that have validness >=BLOCK_VALID_TRANSACTIONS, and must contain those who aren't
@@ -176,6 +180,7 @@ bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats) {
 
 void RegisterNodeSignals(CNodeSignals &nodeSignals) {
     nodeSignals.GetHeight.connect(&GetHeight);
+    nodeSignals.PrecheckMessages.connect(&PrecheckMessages);
     nodeSignals.ProcessMessages.connect(&ProcessMessages);
     nodeSignals.SendMessages.connect(&SendMessages);
     nodeSignals.InitializeNode.connect(&InitializeNode);
@@ -184,6 +189,7 @@ void RegisterNodeSignals(CNodeSignals &nodeSignals) {
 
 void UnregisterNodeSignals(CNodeSignals &nodeSignals) {
     nodeSignals.GetHeight.disconnect(&GetHeight);
+    nodeSignals.PrecheckMessages.disconnect(&PrecheckMessages);
     nodeSignals.ProcessMessages.disconnect(&ProcessMessages);
     nodeSignals.SendMessages.disconnect(&SendMessages);
     nodeSignals.InitializeNode.disconnect(&InitializeNode);
@@ -233,6 +239,102 @@ bool VerifySignature(const uint256 &sigHash, const std::vector<uint8_t> &signatu
     return true;
 }
 
+bool VerifySignatures(const vector<CSignatureCheck> &checks, vector<bool> &results) {
+    results.assign(checks.size(), false);
+
+    vector<CSignatureCheck> pendingChecks;
+    vector<size_t> pendingIndexes;
+    for (size_t i = 0; i < checks.size(); i++) {
+        const CSignatureCheck &check = checks[i];
+        if (signatureCache.Get(check.sigHash, check.signature, check.pubKey)) {
+            results[i] = true;
+        } else {
+            pendingChecks.push_back(check);
+            pendingIndexes.push_back(i);
+        }
+    }
+
+    if (!pendingChecks.empty()) {
+        vector<bool> pendingResults;
+        {
+            auto bm = MAKE_BENCHMARK("execute pubkey batch verify");
+            CPubKey::VerifyBatch(pendingChecks, pendingResults);
+        }
+        for (size_t k = 0; k < pendingChecks.size(); k++) {
+            if (!pendingResults[k])
+                continue;
+
+            const CSignatureCheck &check = pendingChecks[k];
+            signatureCache.Set(check.sigHash, check.signature, check.pubKey);
+            results[pendingIndexes[k]] = true;
+        }
+    }
+
+    return std::all_of(results.begin(), results.end(), [](bool valid) { return valid; });
+}
+
+void InitSignatureCache() {
+    // -maxsigcachesize was an entry count, a value of it read as MiB would take far more memory than meant
+    if (SysCfg().IsArgCount("-maxsigcachesize"))
+        LogPrint(BCLog::INFO, "Warning: -maxsigcachesize is an entry count no longer supported and ignored, "
+                 "use -maxsigcachemb to limit the signature cache in MiB\n");
+
+    int64_t sigCacheSize = SysCfg().GetArg("-maxsigcachemb", DEFAULT_MAX_SIG_CACHE_SIZE);
+    sigCacheSize = std::max<int64_t>(0, std::min(sigCacheSize, MAX_MAX_SIG_CACHE_SIZE));
+    signatureCache.Setup(sigCacheSize << 20);
+}
+
+void StartSigCheckThreads() {
+    if (pSigCheckPool) return;
+
+    uint32_t workerCount = GetWorkerCountFromArg(SysCfg().GetArg("-par", 0), MAX_SIG_CHECK_THREADS);
+    pSigCheckPool.reset(new CWorkerPool("sigcheck", workerCount));
+    LogPrint(BCLog::INFO, "Using %u threads for signature verification\n", workerCount + 1);
+}
+
+void StopSigCheckThreads() {
+    if (pSigCheckPool) {
+        pSigCheckPool->Stop();
+        pSigCheckPool.reset();
+    }
+}
+
+CWorkerPool *GetSigCheckPool() {
+    return pSigCheckPool.get();
+}
+
+void PreVerifySignatures(const vector<CSignatureCheck> &checks) {
+    if (!pSigCheckPool || checks.empty())
+        return;
+
+    // verify in batches of adjacent checks, so the checks of one multisig tx mostly share a batch
+    size_t batchCount = (checks.size() + SIG_CHECK_BATCH_SIZE - 1) / SIG_CHECK_BATCH_SIZE;
+    pSigCheckPool->ParallelFor(batchCount, [&checks](size_t batch) {
+        auto begin = checks.begin() + batch * SIG_CHECK_BATCH_SIZE;
+        auto end   = checks.begin() + std::min(checks.size(), (batch + 1) * SIG_CHECK_BATCH_SIZE);
+        vector<bool> results;
+        VerifySignatures(vector<CSignatureCheck>(begin, end), results);
+    });
+}
+
+// Verify all tx signatures of the block on the signature checking threads before the txs are executed one
+// by one. The verified signatures are put into signatureCache, so the sequential CheckAndExecuteTx() only
+// hits the cache. Failures are ignored here, the txs will be rejected by the sequential checking.
+static void PreVerifyBlockSignatures(const CBlock &block, CCacheWrapper &cw, int32_t height) {
+    if (!pSigCheckPool || block.vptx.size() < 2)
+        return;
+
+    auto bm = MAKE_BENCHMARK("pre-verify block signatures");
+
+    vector<CSignatureCheck> checks;
+    checks.reserve(block.vptx.size());
+    for (size_t index = 1; index < block.vptx.size(); ++index) {
+        block.vptx[index]->GetSignatureChecks(cw, height, checks);
+    }
+
+    PreVerifySignatures(checks);
+}
+
 bool AcceptToMemoryPool(CTxMemPool &pool, CValidationState &state, CBaseTx *pBaseTx,
                         bool fLimitFree, bool fRejectInsaneFee) {
     AssertLockHeld(cs_main);
@@ -339,16 +441,8 @@ bool GetTransaction(std::shared_ptr<CBaseTx> &pBaseTx, const uint256 &hash, CBlo
         if (SysCfg().IsTxIndex()) {
             CDiskTxPos diskTxPos;
             if (blockCache.ReadTxIndex(hash, diskTxPos)) {
-                CAutoFile file(OpenBlockFile(diskTxPos, true), SER_DISK, CLIENT_VERSION);
                 CBlockHeader header;
-                try {
-                    file >> header;
-                    fseek(file, diskTxPos.nTxOffset, SEEK_CUR);
-                    file >> pBaseTx;
-                } catch (std::exception &e) {
-                    return ERRORMSG("Deserialize or I/O error - %s", e.what());
-                }
-                return true;
+                return ReadBaseTxFromDisk(diskTxPos, header, pBaseTx);
             }
         }
     }
@@ -652,7 +746,7 @@ bool DisconnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CVal
     cw.blockCache.SetBestBlock(pIndex->pprev->GetBlockHash());
 
     // Delete the disconnected block's transactions from transaction memory cache.
-    if (!cw.txCache.RemoveBlockTx(block)) {
+    if (!cw.txCache.RemoveBlockTx(block.GetHeight())) {
         return state.Abort(_("DisconnectBlock() : failed to delete block from transaction memory cache"));
     }
 
@@ -664,12 +758,12 @@ bool DisconnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CVal
             pReLoadBlockIndex = pReLoadBlockIndex->pprev;
         }
 
-        CBlock reLoadblock;
-        if (!ReadBlockFromDisk(pReLoadBlockIndex, reLoadblock)) {
+        std::shared_ptr<const CBlock> spReLoadBlock;
+        if (!ReadRecentBlock(pReLoadBlockIndex, spReLoadBlock)) {
             return state.Abort(_("DisconnectBlock() : failed to read block"));
         }
 
-        if (!cw.txCache.AddBlockTx(reLoadblock)) {
+        if (!cw.txCache.AddBlockTx(*spReLoadBlock)) {
             return state.Abort(_("DisconnectBlock() : failed to add block into transaction memory cache"));
         }
     }
@@ -989,6 +1083,7 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
     AssertLockHeld(cs_main);
 
     auto bm = MAKE_BENCHMARK("ConnectBlock");
+    const CDbCacheCowTotals cowStart = CDbCacheCowTotals::Now();
     bool isGensisBlock = (block.GetHeight() == 0) && (block.GetHash() == SysCfg().GetGenesisBlockHash());
 
     // Check it again in case a previous version let a bad block in
@@ -1052,6 +1147,8 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
     const auto &bpRegid = GetBlockBpRegid(block);
 
     if (block.vptx.size() > 1) {
+        PreVerifyBlockSignatures(block, cw, pIndex->height);
+
         assert(mapBlockIndex.count(cw.blockCache.GetBestBlockHash()));
         int32_t curHeight     = mapBlockIndex[cw.blockCache.GetBestBlockHash()]->height;
         int32_t validHeight   = SysCfg().GetTxCacheHeight();
@@ -1185,16 +1282,18 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
         }
 
         if (nullptr != pMatureIndex) {
-            CBlock matureBlock;
-            if (!ReadBlockFromDisk(pMatureIndex, matureBlock)) {
+            std::shared_ptr<const CBlock> spMatureBlock;
+            if (!ReadRecentBlock(pMatureIndex, spMatureBlock)) {
                 return state.Abort(_("ConnectBlock() : read mature block error"));
             }
+            // execute a copy of the reward tx, the block may be shared by recentBlockCache
+            auto spMatureRewardTx = spMatureBlock->vptx[0]->GetNewInstance();
 
             uint32_t prevBlockTime = pIndex->pprev != nullptr ? pIndex->pprev->GetBlockTime() : pIndex->GetBlockTime();
             CTxExecuteContext context(pIndex->height, -1, pIndex->nFuelRate, pIndex->nTime, prevBlockTime, bpRegid,  &cw, &state);
             CTxUndoOpLogger rewardOpLogger(cw, block.vptx[0]->GetHash(), blockUndo);
-            if (!matureBlock.vptx[0]->ExecuteFullTx(context)) {
-                pCdMan->pLogCache->SetExecuteFail(pIndex->height, matureBlock.vptx[0]->GetHash(), state.GetRejectCode(),
+            if (!spMatureRewardTx->ExecuteFullTx(context)) {
+                pCdMan->pLogCache->SetExecuteFail(pIndex->height, spMatureRewardTx->GetHash(), state.GetRejectCode(),
                                                   state.GetRejectReason());
                 return state.DoS(100, ERRORMSG("execute mature block reward tx error"));
             }
@@ -1245,18 +1344,7 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
     }
 
     if (pIndex->height > SysCfg().GetTxCacheHeight()) {
-        CBlockIndex *pDeleteBlockIndex = pIndex;
-        int32_t nCacheHeight           = SysCfg().GetTxCacheHeight();
-        while (pDeleteBlockIndex && nCacheHeight-- > 0) {
-            pDeleteBlockIndex = pDeleteBlockIndex->pprev;
-        }
-
-        CBlock deleteBlock;
-        if (!ReadBlockFromDisk(pDeleteBlockIndex, deleteBlock)) {
-            return state.Abort(_("ConnectBlock() : failed to read block"));
-        }
-
-        if (!cw.txCache.RemoveBlockTx(deleteBlock)) {
+        if (!cw.txCache.RemoveBlockTx(pIndex->height - SysCfg().GetTxCacheHeight())) {
             return state.Abort(_("ConnectBlock() : failed delete block from transaction memory cache"));
         }
     }
@@ -1267,6 +1355,10 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
     // Set best block to current account cache.
     cw.blockCache.SetBestBlock(pIndex->GetBlockHash());
 
+    // the stats are global, the views of other threads add to them
+    LogPrint(BCLog::BENCHMARK, "[%d] ConnectBlock db cache cow: %s\n", pIndex->height,
+             (CDbCacheCowTotals::Now() - cowStart).ToString());
+
     return true;
 }
 
@@ -1298,7 +1390,9 @@ bool static WriteChainState(CValidationState &state) {
 
         FlushBlockFile();
         // pCdMan->pBlockCache->Sync();
-        pCdMan->Flush();
+        // only the freezing of the caches holds cs_main, they are written in the background
+        if (!pCdMan->FlushAsync())
+            return state.Abort(_("Failed to write chain state"));
         mapForkCache.clear();
         nLastWrite = GetTimeMicros();
     }
@@ -1397,11 +1491,15 @@ bool static ConnectTip(CValidationState &state, CBlockIndex *pIndexNew) {
     if (!ReadBlockFromDisk(pIndexNew, block))
         return state.Abort(strprintf("Failed to read block hash: %s", pIndexNew->GetBlockHash().GetHex()));
 
+    // Keep the block for the look-back reads of the later blocks, before its txs are changed by the execution
+    recentBlockCache.Add(pIndexNew, block);
+
     // Apply the block automatically to the chain state.
     CInv inv(MSG_BLOCK, pIndexNew->GetBlockHash());
 
     auto spCW = std::make_shared<CCacheWrapper>(pCdMan);
     if (!ConnectBlock(block, *spCW, pIndexNew, state)) {
+        recentBlockCache.Erase(pIndexNew->GetBlockHash());
         if (state.IsInvalid()) {
             InvalidBlockFound(pIndexNew, block, state);
         }
@@ -1425,7 +1523,7 @@ bool static ConnectTip(CValidationState &state, CBlockIndex *pIndexNew) {
     UpdateTip(pIndexNew, block);
 
     for (auto &pTxItem : block.vptx) {
-        mempool.memPoolTxs.erase(pTxItem->GetHash());
+        mempool.EraseConfirmedTx(pTxItem->GetHash());
     }
     return true;
 }
@@ -1960,11 +2058,19 @@ bool AcceptBlock(CBlock &block, CValidationState &state, CDiskBlockPos *dbp, boo
     CBlockIndex* pTip = chainActive.Tip();
     if (pTip->GetBlockHash() == blockHash) {
         {
+            // the peers supporting it rebuild the block from their mempools
+            std::unique_ptr<CBlockHeaderAndShortTxIDs> pCmpctBlock;
+            if (mining)
+                pCmpctBlock.reset(new CBlockHeaderAndShortTxIDs(block, GetRand(std::numeric_limits<uint64_t>::max())));
+
             LOCK(cs_vNodes);
             for (auto pNode : vNodes) {
                 //p2p_xiaoyu_20191116
                 if (mining) {
-                    pNode->PushMessage(NetMsgType::BLOCK, block);
+                    if (pNode->fCmpctBlocks)
+                        pNode->PushMessage(NetMsgType::CMPCTBLOCK, *pCmpctBlock);
+                    else
+                        pNode->PushMessage(NetMsgType::BLOCK, block);
                     continue;
                 }
                 if (chainActive.Height() > (pNode->nStartingHeight != -1 ? pNode->nStartingHeight - 2000 : 0))
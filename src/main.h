@@ -36,6 +36,7 @@
 class CBloomFilter;
 class CChain;
 class CInv;
+class CWorkerPool;
 
 extern CCriticalSection cs_main;
 /** The currently-connected chain of blocks. */
@@ -98,6 +99,18 @@ bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats);
 void Misbehaving(NodeId nodeid, int32_t howmuch);
 
 bool VerifySignature(const uint256 &sigHash, const std::vector<uint8_t> &signature, const CPubKey &pubKey);
+/** Verify the signatures in one batch, going through signatureCache like VerifySignature(). results[i] is
+ *  the result of checks[i], return true if all of them are valid */
+bool VerifySignatures(const std::vector<CSignatureCheck> &checks, std::vector<bool> &results);
+/** Salt signatureCache and size it by -maxsigcachemb */
+void InitSignatureCache();
+/** Start/stop the threads pre-verifying the tx signatures of connecting blocks (-par) */
+void StartSigCheckThreads();
+void StopSigCheckThreads();
+/** The pool of the signature checking threads, shared by the other CPU bound validation jobs, nullptr if not started */
+CWorkerPool *GetSigCheckPool();
+/** Verify the signatures on the signature checking threads into signatureCache, ignoring the failures */
+void PreVerifySignatures(const std::vector<CSignatureCheck> &checks);
 
 /** (try to) add transaction to memory pool **/
 bool AcceptToMemoryPool(CTxMemPool &pool, CValidationState &state, CBaseTx *pBaseTx,
@@ -109,6 +109,32 @@ void GetPriorityTx(CCacheWrapper &cw, int32_t height, set<TxPriority> &txPriorit
     }
 }
 
+// Walk the priority index of mempool and the txs created by the producer as one sequence, from the highest priority
+// to the lowest, instead of copying the whole index to merge them.
+class CPriorityTxCursor {
+public:
+    CPriorityTxCursor(const set<TxPriority> &poolTxsIn, const set<TxPriority> &producedTxsIn)
+        : poolTxs(poolTxsIn), producedTxs(producedTxsIn), poolIt(poolTxsIn.rbegin()),
+          producedIt(producedTxsIn.rbegin()) {}
+
+    // return nullptr at the end, isPoolTx tells whether the item comes from the mempool index
+    const TxPriority *Next(bool &isPoolTx) {
+        bool hasPoolTx     = poolIt != poolTxs.rend();
+        bool hasProducedTx = producedIt != producedTxs.rend();
+        if (!hasPoolTx && !hasProducedTx)
+            return nullptr;
+
+        isPoolTx = hasPoolTx && (!hasProducedTx || !(*poolIt < *producedIt));
+        return isPoolTx ? &*poolIt++ : &*producedIt++;
+    }
+
+private:
+    const set<TxPriority> &poolTxs;
+    const set<TxPriority> &producedTxs;
+    set<TxPriority>::const_reverse_iterator poolIt;
+    set<TxPriority>::const_reverse_iterator producedIt;
+};
+
 
 bool GetCurrentDelegate(const int64_t currentTime, const int32_t currHeight, const VoteDelegateVector &delegates,
                                VoteDelegate &delegate) {
@@ -318,16 +344,23 @@ static bool CreateNewBlockForPreStableCoinRelease(Miner &miner, CCacheWrapper &c
         uint64_t totalFuelFee   = 0;
         uint64_t reward         = 0;
 
-        // Calculate && sort transactions from memory pool.
+        // Use the priority index of mempool, sort the whole pool only when the index is built for another fuel rate.
         set<TxPriority> txPriorities;
-        GetPriorityTx(cwIn, height, txPriorities, fuelRate);
+        const set<TxPriority> *pPoolTxs = mempool.GetPriorityTxs(fuelRate);
+        if (pPoolTxs == nullptr)
+            GetPriorityTx(cwIn, height, txPriorities, fuelRate);
 
         LogPrint(BCLog::MINER, "got %lu transaction(s) sorted by priority rules\n",
-                 txPriorities.size());
+                 txPriorities.size() + (pPoolTxs != nullptr ? pPoolTxs->size() : 0));
 
         // Collect transactions into the block.
-        for (auto itor = txPriorities.rbegin(); itor != txPriorities.rend(); ++itor) {
-            CBaseTx *pBaseTx = itor->baseTx.get();
+        const set<TxPriority> emptyTxs;
+        CPriorityTxCursor cursor(pPoolTxs != nullptr ? *pPoolTxs : emptyTxs, txPriorities);
+        bool isPoolTx = false;
+        while (const TxPriority *pItem = cursor.Next(isPoolTx)) {
+            CBaseTx *pBaseTx = pItem->baseTx.get();
+            if (isPoolTx && pCdMan->pTxCache->HasTx(pBaseTx->GetHash()))
+                continue;
 
             uint32_t txSize = pBaseTx->GetSerializeSize(SER_NETWORK, PROTOCOL_VERSION);
             if (totalBlockSize + txSize >= nBlockMaxSize) {
@@ -381,7 +414,7 @@ static bool CreateNewBlockForPreStableCoinRelease(Miner &miner, CCacheWrapper &c
 
             ++index;
 
-            pBlock->vptx.push_back(itor->baseTx);
+            pBlock->vptx.push_back(pItem->baseTx);
 
             LogPrint(BCLog::DEBUG, "miner's total fuel fee:%d, tx fuel fee:%d, fuel:%d, fuelRate:%d, txid:%s\n",
                     totalFuelFee, fuelFee, pBaseTx->fuel, fuelRate, pBaseTx->GetHash().GetHex());
@@ -429,6 +462,7 @@ static bool CreateStableCoinGenesisBlock(std::unique_ptr<CBlock> &pBlock) {
 }
 
 static bool CreateNewBlockForStableCoinRelease(int64_t startMiningMs, Miner &miner, CCacheWrapper &cwIn, std::unique_ptr<CBlock> &pBlock) {
+    const CDbCacheCowTotals cowStart = CDbCacheCowTotals::Now();
     pBlock->vptx.push_back(std::make_shared<CUCoinBlockRewardTx>());
 
     // Largest block you're willing to create:
@@ -451,9 +485,11 @@ static bool CreateNewBlockForStableCoinRelease(int64_t startMiningMs, Miner &min
         uint64_t totalFuelFee              = 0;
         map<TokenSymbol, uint64_t> rewards = { {SYMB::WICC, 0}, {SYMB::WUSD, 0} };
 
-        // Calculate && sort transactions from memory pool.
+        // Use the priority index of mempool, sort the whole pool only when the index is built for another fuel rate.
         set<TxPriority> txPriorities;
-        GetPriorityTx(cwIn, height, txPriorities, fuelRate);
+        const set<TxPriority> *pPoolTxs = mempool.GetPriorityTxs(fuelRate);
+        if (pPoolTxs == nullptr)
+            GetPriorityTx(cwIn, height, txPriorities, fuelRate);
 
         // Push block price median transaction into queue.
         txPriorities.emplace(TxPriority(PRICE_MEDIAN_TRANSACTION_PRIORITY, 0, std::make_shared<CBlockPriceMedianTx>(height)));
@@ -471,10 +507,14 @@ static bool CreateNewBlockForStableCoinRelease(int64_t startMiningMs, Miner &min
             }
         }
 
-        LogPrint(BCLog::MINER, "Got %lu trx(s), sorted by priority\n", txPriorities.size());
+        LogPrint(BCLog::MINER, "Got %lu trx(s), sorted by priority\n",
+                 txPriorities.size() + (pPoolTxs != nullptr ? pPoolTxs->size() : 0));
 
         // Collect transactions into the block.
-        for (auto itor = txPriorities.rbegin(); itor != txPriorities.rend(); ++itor) {
+        const set<TxPriority> emptyTxs;
+        CPriorityTxCursor cursor(pPoolTxs != nullptr ? *pPoolTxs : emptyTxs, txPriorities);
+        bool isPoolTx = false;
+        while (const TxPriority *pItem = cursor.Next(isPoolTx)) {
 
             if (!CheckPackBlockTime(startMiningMs, height)) {
                 LogPrint(BCLog::MINER, "[%d] no time left to pack more tx, ignore! start_ms=%lld, tx_count=%u\n",
@@ -482,7 +522,9 @@ static bool CreateNewBlockForStableCoinRelease(int64_t startMiningMs, Miner &min
                 break;
             }
 
-            CBaseTx *pBaseTx = itor->baseTx.get();
+            CBaseTx *pBaseTx = pItem->baseTx.get();
+            if (isPoolTx && pCdMan->pTxCache->HasTx(pBaseTx->GetHash()))
+                continue;
 
             uint32_t txSize = pBaseTx->GetSerializeSize(SER_NETWORK, PROTOCOL_VERSION);
             if (totalBlockSize + txSize >= nBlockMaxSize) {
@@ -501,7 +543,7 @@ static bool CreateNewBlockForStableCoinRelease(int64_t startMiningMs, Miner &min
 
                 // Special case for price median tx,
                 if (pBaseTx->IsPriceMedianTx()) {
-                    CBlockPriceMedianTx *pPriceMedianTx = (CBlockPriceMedianTx *)itor->baseTx.get();
+                    CBlockPriceMedianTx *pPriceMedianTx = (CBlockPriceMedianTx *)pItem->baseTx.get();
                     if (!spCW->ppCache.CalcMedianPrices(*spCW, height, pPriceMedianTx->median_prices))
                         return ERRORMSG("calculate block median prices error");
                 }
@@ -547,7 +589,7 @@ static bool CreateNewBlockForStableCoinRelease(int64_t startMiningMs, Miner &min
 
             ++index;
 
-            pBlock->vptx.push_back(itor->baseTx);
+            pBlock->vptx.push_back(pItem->baseTx);
 
             LogPrint(BCLog::DEBUG, "miner total_fuel_fee=%d, tx_fuel_fee=%d, fuel=%d, fuelRate:%d, txid:%s\n",
                     totalFuelFee, fuelFee, pBaseTx->fuel, fuelRate, pBaseTx->GetHash().GetHex());
@@ -567,6 +609,8 @@ static bool CreateNewBlockForStableCoinRelease(int64_t startMiningMs, Miner &min
         pBlock->SetFuelRate(fuelRate);
 
         LogPrint(BCLog::INFO, "[%d] tx=%d, totalBlockSize=%llu\n", height, index + 1, totalBlockSize);
+        LogPrint(BCLog::BENCHMARK, "[%d] CreateNewBlock db cache cow: %s\n", height,
+                 (CDbCacheCowTotals::Now() - cowStart).ToString());
     }
 
     return true;
@@ -22,6 +22,11 @@
 #include <fcntl.h>
 #endif
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#define USE_EPOLL
+#endif
+
 #ifdef USE_UPNP
 #include <miniupnpc/miniupnpc.h>
 #include <miniupnpc/miniwget.h>
@@ -33,7 +38,9 @@
 #include <sys/sysinfo.h>
 #include <sys/utsname.h>
 
+#include <condition_variable>
 #include <fstream>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <thread>
@@ -422,6 +429,60 @@ CNode* FindNode(const CService& addr) {
     return nullptr;
 }
 
+#ifdef USE_EPOLL
+// the event loop of the sockets, -1 when the sockets are polled by select()
+static int32_t epollFd = -1;
+// the nodes registered in epollFd by id, requires cs_vNodes
+static map<NodeId, CNode*> mapEpollNodes;
+
+static const int32_t MAX_EPOLL_EVENTS = 256;
+// the tag of the listen sockets in the epoll data, the peer sockets hold the node ids
+static const uint64_t EPOLL_LISTEN_TAG = 1ULL << 63;
+#endif
+
+bool UseSocketEventsEpoll() {
+#ifdef USE_EPOLL
+    return SysCfg().GetArg("-socketevents", "epoll") == "epoll";
+#else
+    return false;
+#endif
+}
+
+// select() only waits for the sockets below FD_SETSIZE, the epoll loop takes any socket
+static bool IsSelectableSocket(SOCKET hSocket) {
+#ifdef USE_EPOLL
+    if (epollFd != -1)
+        return true;
+#endif
+#ifdef WIN32
+    return true;
+#else
+    return hSocket < FD_SETSIZE;
+#endif
+}
+
+// requires cs_vNodes
+static void AddNode(CNode* pNode) {
+    AssertLockHeld(cs_vNodes);
+    vNodes.push_back(pNode);
+
+#ifdef USE_EPOLL
+    if (epollFd != -1) {
+        // edge triggered: the socket is read until it would block, the writable edge sends the pending messages
+        struct epoll_event event;
+        event.events   = EPOLLIN | EPOLLOUT | EPOLLET;
+        event.data.u64 = (uint64_t)pNode->GetId();
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, pNode->hSocket, &event) == SOCKET_ERROR) {
+            LogPrint(BCLog::INFO, "socket[%s] epoll_ctl add failed: %s\n", pNode->addr.ToString(),
+                     NetworkErrorString(errno));
+            pNode->CloseSocketDisconnect();
+            return;
+        }
+        mapEpollNodes[pNode->GetId()] = pNode;
+    }
+#endif
+}
+
 CNode* ConnectNode(CAddress addrConnect, const char* pszDest) {
     if (pszDest == nullptr) {
         if (IsLocal(addrConnect))
@@ -464,7 +525,7 @@ CNode* ConnectNode(CAddress addrConnect, const char* pszDest) {
 
         {
             LOCK(cs_vNodes);
-            vNodes.push_back(pNode);
+            AddNode(pNode);
         }
 
         pNode->nTimeConnected = GetTime();
@@ -477,305 +538,528 @@ CNode* ConnectNode(CAddress addrConnect, const char* pszDest) {
 
 static list<CNode*> vNodesDisconnected;
 
-void ThreadSocketHandler() {
-    uint32_t nPrevNodeCount = 0;
-    while (true) {
-        //
-        // Disconnect nodes
-        //
-        {
-            LOCK(cs_vNodes);
-            // Disconnect unused nodes
-            vector<CNode*> vNodesCopy = vNodes;
-            for (auto pNode : vNodesCopy) {
-                if (pNode->fDisconnect || (pNode->GetRefCount() <= 0 && pNode->vRecvMsg.empty() &&
-                                           pNode->nSendSize == 0 && pNode->ssSend.empty())) {
-                    // remove from vNodes
-                    vNodes.erase(remove(vNodes.begin(), vNodes.end(), pNode), vNodes.end());
-
-                    // release outbound grant (if any)
-                    pNode->grantOutbound.Release();
-
-                    // close socket and cleanup
-                    pNode->CloseSocketDisconnect();
-                    pNode->Cleanup();
-
-                    // hold in disconnected pool until all refs are released
-                    if (pNode->fNetworkNode || pNode->fInbound)
-                        pNode->Release();
-                    vNodesDisconnected.push_back(pNode);
-                }
+// wakes up the message handler before its 100ms polling interval
+static std::mutex mutexMsgProc;
+static std::condition_variable condMsgProc;
+static bool fMsgProcWake = false;
+
+static void WakeMessageHandler() {
+    {
+        std::unique_lock<std::mutex> lock(mutexMsgProc);
+        fMsgProcWake = true;
+    }
+    condMsgProc.notify_one();
+}
+
+// send the pending messages, requires LOCK(pNode->cs_vSend)
+static void SocketSendData(CNode* pNode) {
+    bool fSendBufferFull = pNode->nSendSize >= SendBufferSize();
+    pNode->SocketSendData();
+    // the handler stops processing the messages of a node with a full send buffer
+    if (fSendBufferFull && pNode->nSendSize < SendBufferSize())
+        WakeMessageHandler();
+}
+
+static void DisconnectNodes(uint32_t& nPrevNodeCount) {
+    {
+        LOCK(cs_vNodes);
+        // Disconnect unused nodes
+        vector<CNode*> vNodesCopy = vNodes;
+        for (auto pNode : vNodesCopy) {
+            if (pNode->fDisconnect || (pNode->GetRefCount() <= 0 && pNode->vRecvMsg.empty() &&
+                                       pNode->nSendSize == 0 && pNode->ssSend.empty())) {
+                // remove from vNodes
+                vNodes.erase(remove(vNodes.begin(), vNodes.end(), pNode), vNodes.end());
+#ifdef USE_EPOLL
+                mapEpollNodes.erase(pNode->GetId());
+#endif
+
+                // release outbound grant (if any)
+                pNode->grantOutbound.Release();
+
+                // close socket and cleanup
+                pNode->CloseSocketDisconnect();
+                pNode->Cleanup();
+
+                // hold in disconnected pool until all refs are released
+                if (pNode->fNetworkNode || pNode->fInbound)
+                    pNode->Release();
+                vNodesDisconnected.push_back(pNode);
             }
         }
-        {
-            // Delete disconnected nodes
-            list<CNode*> vNodesDisconnectedCopy = vNodesDisconnected;
-            for (auto pNode : vNodesDisconnectedCopy) {
-                // wait until threads are done using it
-                if (pNode->GetRefCount() <= 0) {
-                    bool fDelete = false;
-                    {
-                        TRY_LOCK(pNode->cs_vSend, lockSend);
-                        if (lockSend) {
-                            TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
-                            if (lockRecv) {
-                                TRY_LOCK(pNode->cs_inventory, lockInv);
-                                if (lockInv)
-                                    fDelete = true;
-                            }
+    }
+    {
+        // Delete disconnected nodes
+        list<CNode*> vNodesDisconnectedCopy = vNodesDisconnected;
+        for (auto pNode : vNodesDisconnectedCopy) {
+            // wait until threads are done using it
+            if (pNode->GetRefCount() <= 0) {
+                bool fDelete = false;
+                {
+                    TRY_LOCK(pNode->cs_vSend, lockSend);
+                    if (lockSend) {
+                        TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
+                        if (lockRecv) {
+                            TRY_LOCK(pNode->cs_inventory, lockInv);
+                            if (lockInv)
+                                fDelete = true;
                         }
                     }
-                    if (fDelete) {
-                        vNodesDisconnected.remove(pNode);
-                        delete pNode;
-                    }
+                }
+                if (fDelete) {
+                    vNodesDisconnected.remove(pNode);
+                    delete pNode;
                 }
             }
         }
-        if (vNodes.size() != nPrevNodeCount) {
-            nPrevNodeCount = vNodes.size();
+    }
+    if (vNodes.size() != nPrevNodeCount) {
+        nPrevNodeCount = vNodes.size();
 
-            LogPrint(BCLog::INFO, "Connections number changed, %d -> %d\n", nPrevNodeCount, vNodes.size());
-        }
+        LogPrint(BCLog::INFO, "Connections number changed, %d -> %d\n", nPrevNodeCount, vNodes.size());
+    }
+}
 
-        //
-        // Find which sockets have data to receive
-        //
-        struct timeval timeout;
-        timeout.tv_sec  = 0;
-        timeout.tv_usec = 50000;  // frequency to poll pNode->vSend
-
-        fd_set fdsetRecv;
-        fd_set fdsetSend;
-        fd_set fdsetError;
-        FD_ZERO(&fdsetRecv);
-        FD_ZERO(&fdsetSend);
-        FD_ZERO(&fdsetError);
-        SOCKET hSocketMax = 0;
-        bool have_fds     = false;
+static void AcceptConnection(SOCKET hListenSocket) {
+    struct sockaddr_storage sockaddr;
+    socklen_t len  = sizeof(sockaddr);
+    SOCKET hSocket = accept(hListenSocket, (struct sockaddr*)&sockaddr, &len);
+    CAddress addr;
+    int32_t nInbound = 0;
 
-        for (auto hListenSocket : vhListenSocket) {
-            FD_SET(hListenSocket, &fdsetRecv);
-            hSocketMax = max(hSocketMax, hListenSocket);
-            have_fds   = true;
-        }
+    if (hSocket != INVALID_SOCKET)
+        if (!addr.SetSockAddr((const struct sockaddr*)&sockaddr))
+            LogPrint(BCLog::INFO, "Warning: Unknown socket family\n");
 
+    {
+        LOCK(cs_vNodes);
+        for (auto pNode : vNodes)
+            if (pNode->fInbound)
+                nInbound++;
+    }
+
+    if (hSocket == INVALID_SOCKET) {
+        int32_t nErr = WSAGetLastError();
+        if (nErr != WSAEWOULDBLOCK)
+            LogPrint(BCLog::INFO, "socket[%s] error accept failed: %s\n", addr.ToString(), NetworkErrorString(nErr));
+    } else if (nInbound >= nMaxConnections - MAX_OUTBOUND_CONNECTIONS) {
+        closesocket(hSocket);
+    } else if (!IsSelectableSocket(hSocket)) {
+        LogPrint(BCLog::INFO, "connection from %s dropped (socket above FD_SETSIZE)\n", addr.ToString());
+        closesocket(hSocket);
+    } else if (CNode::IsBanned(addr)) {
+        LogPrint(BCLog::INFO, "connection from %s dropped (banned)\n", addr.ToString());
+        closesocket(hSocket);
+    } else {
+        LogPrint(BCLog::NET, "accepted connection %s\n", addr.ToString());
+        CNode* pNode = new CNode(hSocket, addr, "", true);
+        pNode->AddRef();
         {
             LOCK(cs_vNodes);
-            for (auto pNode : vNodes) {
-                if (pNode->hSocket == INVALID_SOCKET)
-                    continue;
+            AddNode(pNode);
+        }
+    }
+}
 
-                FD_SET(pNode->hSocket, &fdsetError);
-                hSocketMax = max(hSocketMax, pNode->hSocket);
-                have_fds   = true;
-
-                // Implement the following logic:
-                // * If there is data to send, select() for sending data. As this only
-                //   happens when optimistic write failed, we choose to first drain the
-                //   write buffer in this case before receiving more. This avoids
-                //   needlessly queueing received data, if the remote peer is not themselves
-                //   receiving data. This means properly utilizing TCP flow control signalling.
-                // * Otherwise, if there is no (complete) message in the receive buffer,
-                //   or there is space left in the buffer, select() for receiving data.
-                // * (if neither of the above applies, there is certainly one message
-                //   in the receiver buffer ready to be processed).
-                // Together, that means that at least one of the following is always possible,
-                // so we don't deadlock:
-                // * We send some data.
-                // * We wait for data to be received (and disconnect after timeout).
-                // * We process a message in the buffer (message handler thread).
-                {
-                    TRY_LOCK(pNode->cs_vSend, lockSend);
-                    if (lockSend && !pNode->vSendMsg.empty()) {
-                        FD_SET(pNode->hSocket, &fdsetSend);
-                        continue;
-                    }
-                }
-                {
-                    TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
-                    if (lockRecv && (pNode->vRecvMsg.empty() || !pNode->vRecvMsg.front().complete() ||
-                                     pNode->GetTotalRecvSize() <= ReceiveFloodSize()))
-                        FD_SET(pNode->hSocket, &fdsetRecv);
+// Receive once from the socket, requires LOCK(pNode->cs_vRecvMsg).
+// Return true if some bytes were received and the socket may have more.
+static bool SocketRecvData(CNode* pNode) {
+    // typical socket buffer is 8K-64K
+    char pchBuf[0x10000];
+    int32_t nBytes = recv(pNode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+    if (nBytes > 0) {
+        if (!pNode->ReceiveMsgBytes(pchBuf, nBytes))
+            pNode->CloseSocketDisconnect();
+        pNode->nLastRecv = GetTime();
+        pNode->nRecvBytes += nBytes;
+        pNode->RecordBytesRecv(nBytes);
+        if (!pNode->vRecvMsg.empty() && pNode->vRecvMsg.front().complete())
+            WakeMessageHandler();
+        return pNode->hSocket != INVALID_SOCKET;
+    } else if (nBytes == 0) {
+        // socket closed gracefully
+        if (!pNode->fDisconnect)
+            LogPrint(BCLog::NET, "socket[%s] closed\n", pNode->addr.ToString());
+        pNode->CloseSocketDisconnect();
+    } else if (nBytes < 0) {
+        // error
+        int32_t nErr = WSAGetLastError();
+        if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS) {
+            if (!pNode->fDisconnect)
+                LogPrint(BCLog::INFO, "socket[%s] recv error %s\n", pNode->addr.ToString(), NetworkErrorString(nErr));
+            pNode->CloseSocketDisconnect();
+        }
+    }
+    return false;
+}
+
+// requires LOCK(pNode->cs_vRecvMsg)
+static bool IsRecvBufferAvailable(CNode* pNode) {
+    return pNode->vRecvMsg.empty() || !pNode->vRecvMsg.front().complete() ||
+           pNode->GetTotalRecvSize() <= ReceiveFloodSize();
+}
+
+static void InactivityCheck(CNode* pNode) {
+    if (pNode->vSendMsg.empty())
+        pNode->nLastSendEmpty = GetTime();
+    // p2p_xiaoyu_20191126
+    // if (GetTime() - pNode->nTimeConnected > 60) {
+    //     if (pNode->nLastRecv == 0 || pNode->nLastSend == 0) {
+    //         LogPrint(BCLog::NET, "socket no message in first 60 seconds, %d %d\n", pNode->nLastRecv != 0,
+    //                  pNode->nLastSend != 0);
+    //         pNode->fDisconnect = true;
+    //     } else if (GetTime() - pNode->nLastSend > 90 * 60 && GetTime() - pNode->nLastSendEmpty > 90 * 60) {
+    //         LogPrint(BCLog::INFO, "socket not sending\n");
+    //         pNode->fDisconnect = true;
+    //     } else if (GetTime() - pNode->nLastRecv > 90 * 60) {
+    //         LogPrint(BCLog::INFO, "socket inactivity timeout\n");
+    //         pNode->fDisconnect = true;
+    //     }
+    // }
+    int64_t nTime = GetSystemTimeInSeconds();
+    if (nTime - pNode->nTimeConnected > DEFAULT_PEER_CONNECT_TIMEOUT)
+    {
+        if (pNode->nLastRecv == 0 || pNode->nLastSend == 0)
+        {
+            LogPrint(BCLog::NET, "socket no message in first %i seconds, %d %d from %d\n", DEFAULT_PEER_CONNECT_TIMEOUT, pNode->nLastRecv != 0, pNode->nLastSend != 0, pNode->GetId());
+            pNode->fDisconnect = true;
+        }
+        else if (nTime - pNode->nLastSend > TIMEOUT_INTERVAL)
+        {
+            LogPrint(BCLog::NET, "socket sending timeout: %is\n", nTime - pNode->nLastSend);
+            pNode->fDisconnect = true;
+        }
+        else if (nTime - pNode->nLastRecv > TIMEOUT_INTERVAL )
+        {
+            LogPrint(BCLog::NET, "socket receive timeout: %is\n", nTime - pNode->nLastRecv);
+            pNode->fDisconnect = true;
+        }
+        else if (pNode->nPingNonceSent && pNode->nPingUsecStart + TIMEOUT_INTERVAL * 1000000 < GetTimeMicros())
+        {
+            LogPrint(BCLog::NET, "ping timeout: %fs\n", 0.000001 * (GetTimeMicros() - pNode->nPingUsecStart));
+            pNode->fDisconnect = true;
+        }
+        else if (!pNode->fSuccessfullyConnected)
+        {
+            LogPrint(BCLog::NET, "version handshake timeout from %d\n", pNode->GetId());
+            pNode->fDisconnect = true;
+        }
+    }
+}
+
+static void ServiceSocketsSelect() {
+    //
+    // Find which sockets have data to receive
+    //
+    struct timeval timeout;
+    timeout.tv_sec  = 0;
+    timeout.tv_usec = 50000;  // frequency to poll pNode->vSend
+
+    fd_set fdsetRecv;
+    fd_set fdsetSend;
+    fd_set fdsetError;
+    FD_ZERO(&fdsetRecv);
+    FD_ZERO(&fdsetSend);
+    FD_ZERO(&fdsetError);
+    SOCKET hSocketMax = 0;
+    bool have_fds     = false;
+
+    for (auto hListenSocket : vhListenSocket) {
+        FD_SET(hListenSocket, &fdsetRecv);
+        hSocketMax = max(hSocketMax, hListenSocket);
+        have_fds   = true;
+    }
+
+    {
+        LOCK(cs_vNodes);
+        for (auto pNode : vNodes) {
+            if (pNode->hSocket == INVALID_SOCKET)
+                continue;
+
+            FD_SET(pNode->hSocket, &fdsetError);
+            hSocketMax = max(hSocketMax, pNode->hSocket);
+            have_fds   = true;
+
+            // Implement the following logic:
+            // * If there is data to send, select() for sending data. As this only
+            //   happens when optimistic write failed, we choose to first drain the
+            //   write buffer in this case before receiving more. This avoids
+            //   needlessly queueing received data, if the remote peer is not themselves
+            //   receiving data. This means properly utilizing TCP flow control signalling.
+            // * Otherwise, if there is no (complete) message in the receive buffer,
+            //   or there is space left in the buffer, select() for receiving data.
+            // * (if neither of the above applies, there is certainly one message
+            //   in the receiver buffer ready to be processed).
+            // Together, that means that at least one of the following is always possible,
+            // so we don't deadlock:
+            // * We send some data.
+            // * We wait for data to be received (and disconnect after timeout).
+            // * We process a message in the buffer (message handler thread).
+            {
+                TRY_LOCK(pNode->cs_vSend, lockSend);
+                if (lockSend && !pNode->vSendMsg.empty()) {
+                    FD_SET(pNode->hSocket, &fdsetSend);
+                    continue;
                 }
             }
+            {
+                TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
+                if (lockRecv && IsRecvBufferAvailable(pNode))
+                    FD_SET(pNode->hSocket, &fdsetRecv);
+            }
+        }
+    }
+
+    int32_t nSelect = select(have_fds ? hSocketMax + 1 : 0, &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
+    boost::this_thread::interruption_point();
+
+    if (nSelect == SOCKET_ERROR) {
+        if (have_fds) {
+            int32_t nErr = WSAGetLastError();
+            LogPrint(BCLog::INFO, "socket select error %s\n", NetworkErrorString(nErr));
+            for (uint32_t i = 0; i <= hSocketMax; i++)
+                FD_SET(i, &fdsetRecv);
         }
+        FD_ZERO(&fdsetSend);
+        FD_ZERO(&fdsetError);
+        MilliSleep(timeout.tv_usec / 1000);
+    }
+
+    //
+    // Accept new connections
+    //
+    for (auto hListenSocket : vhListenSocket)
+        if (hListenSocket != INVALID_SOCKET && FD_ISSET(hListenSocket, &fdsetRecv))
+            AcceptConnection(hListenSocket);
 
-        int32_t nSelect = select(have_fds ? hSocketMax + 1 : 0, &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
+    //
+    // Service each socket
+    //
+    vector<CNode*> vNodesCopy;
+    {
+        LOCK(cs_vNodes);
+        vNodesCopy = vNodes;
+        for (auto pNode : vNodesCopy)
+            pNode->AddRef();
+    }
+    for (auto pNode : vNodesCopy) {
         boost::this_thread::interruption_point();
 
-        if (nSelect == SOCKET_ERROR) {
-            if (have_fds) {
-                int32_t nErr = WSAGetLastError();
-                LogPrint(BCLog::INFO, "socket select error %s\n", NetworkErrorString(nErr));
-                for (uint32_t i = 0; i <= hSocketMax; i++)
-                    FD_SET(i, &fdsetRecv);
-            }
-            FD_ZERO(&fdsetSend);
-            FD_ZERO(&fdsetError);
-            MilliSleep(timeout.tv_usec / 1000);
+        //
+        // Receive
+        //
+        if (pNode->hSocket == INVALID_SOCKET)
+            continue;
+        if (FD_ISSET(pNode->hSocket, &fdsetRecv) || FD_ISSET(pNode->hSocket, &fdsetError)) {
+            TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
+            if (lockRecv)
+                SocketRecvData(pNode);
         }
 
         //
-        // Accept new connections
+        // Send
         //
-        for (auto hListenSocket : vhListenSocket)
-            if (hListenSocket != INVALID_SOCKET && FD_ISSET(hListenSocket, &fdsetRecv)) {
-                struct sockaddr_storage sockaddr;
-                socklen_t len  = sizeof(sockaddr);
-                SOCKET hSocket = accept(hListenSocket, (struct sockaddr*)&sockaddr, &len);
-                CAddress addr;
-                int32_t nInbound = 0;
+        if (pNode->hSocket == INVALID_SOCKET)
+            continue;
+        if (FD_ISSET(pNode->hSocket, &fdsetSend)) {
+            TRY_LOCK(pNode->cs_vSend, lockSend);
+            if (lockSend)
+                SocketSendData(pNode);
+        }
 
-                if (hSocket != INVALID_SOCKET)
-                    if (!addr.SetSockAddr((const struct sockaddr*)&sockaddr))
-                        LogPrint(BCLog::INFO, "Warning: Unknown socket family\n");
+        //
+        // Inactivity checking
+        //
+        InactivityCheck(pNode);
+    }
 
-                {
-                    LOCK(cs_vNodes);
-                    for (auto pNode : vNodes)
-                        if (pNode->fInbound)
-                            nInbound++;
-                }
+    {
+        LOCK(cs_vNodes);
+        for (auto pNode : vNodesCopy)
+            pNode->Release();
+    }
+}
 
-                if (hSocket == INVALID_SOCKET) {
-                    int32_t nErr = WSAGetLastError();
-                    if (nErr != WSAEWOULDBLOCK)
-                        LogPrint(BCLog::INFO, "socket[%s] error accept failed: %s\n", addr.ToString(), NetworkErrorString(nErr));
-                } else if (nInbound >= nMaxConnections - MAX_OUTBOUND_CONNECTIONS) {
-                    closesocket(hSocket);
-                } else if (CNode::IsBanned(addr)) {
-                    LogPrint(BCLog::INFO, "connection from %s dropped (banned)\n", addr.ToString());
-                    closesocket(hSocket);
-                } else {
-                    LogPrint(BCLog::NET, "accepted connection %s\n", addr.ToString());
-                    CNode* pNode = new CNode(hSocket, addr, "", true);
-                    pNode->AddRef();
-                    {
-                        LOCK(cs_vNodes);
-                        vNodes.push_back(pNode);
-                    }
+#ifdef USE_EPOLL
+/**
+ * Service the sockets with the events of epollFd. The peer sockets are edge triggered, a readable or writable
+ * node stays in setRecvReady/setSendReady until its socket would block, so the sockets held back by the flood
+ * control or a busy lock are served again in the next rounds without another event.
+ */
+static void ServiceSocketsEpoll(set<NodeId>& setRecvReady, set<NodeId>& setSendReady, int64_t& nLastInactivityCheck) {
+    struct epoll_event events[MAX_EPOLL_EVENTS];
+    // frequency to serve the held back sockets, disconnect nodes and check the inactivity
+    int32_t nEvents = epoll_wait(epollFd, events, MAX_EPOLL_EVENTS, 50);
+    boost::this_thread::interruption_point();
+
+    if (nEvents == SOCKET_ERROR) {
+        if (errno != EINTR) {
+            LogPrint(BCLog::INFO, "socket epoll_wait error %s\n", NetworkErrorString(errno));
+            MilliSleep(50);
+        }
+        nEvents = 0;
+    }
+
+    for (int32_t i = 0; i < nEvents; i++) {
+        uint64_t data = events[i].data.u64;
+        if (data & EPOLL_LISTEN_TAG) {
+            // level triggered, the pending connections are accepted in the next rounds
+            AcceptConnection(vhListenSocket[data & ~EPOLL_LISTEN_TAG]);
+            continue;
+        }
+
+        if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+            setRecvReady.insert((NodeId)data);
+        if (events[i].events & EPOLLOUT)
+            setSendReady.insert((NodeId)data);
+    }
+
+    vector<CNode*> vNodesReady;
+    {
+        LOCK(cs_vNodes);
+        for (auto readySet : {&setRecvReady, &setSendReady}) {
+            for (auto it = readySet->begin(); it != readySet->end();) {
+                auto nodeIt = mapEpollNodes.find(*it);
+                if (nodeIt == mapEpollNodes.end()) {
+                    // disconnected
+                    it = readySet->erase(it);
+                    continue;
                 }
+                if (readySet == &setRecvReady || !setRecvReady.count(*it))
+                    vNodesReady.push_back(nodeIt->second->AddRef());
+                ++it;
             }
+        }
+    }
+
+    for (auto pNode : vNodesReady) {
+        boost::this_thread::interruption_point();
+
+        NodeId id = pNode->GetId();
+        if (pNode->hSocket == INVALID_SOCKET) {
+            setRecvReady.erase(id);
+            setSendReady.erase(id);
+            continue;
+        }
 
         //
-        // Service each socket
+        // Send, the pending messages are sent before receiving more like the select() loop
         //
-        vector<CNode*> vNodesCopy;
+        bool fSendPending = false;
         {
-            LOCK(cs_vNodes);
+            TRY_LOCK(pNode->cs_vSend, lockSend);
+            if (!lockSend) {
+                fSendPending = true;
+            } else {
+                if (setSendReady.count(id)) {
+                    if (!pNode->vSendMsg.empty())
+                        SocketSendData(pNode);
+                    // all sent, or the socket is full and the next writable edge will come
+                    setSendReady.erase(id);
+                }
+                fSendPending = !pNode->vSendMsg.empty();
+            }
+        }
+
+        //
+        // Receive
+        //
+        if (fSendPending || pNode->hSocket == INVALID_SOCKET || !setRecvReady.count(id))
+            continue;
+
+        TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
+        if (!lockRecv)
+            continue;
+
+        while (IsRecvBufferAvailable(pNode)) {
+            if (!SocketRecvData(pNode)) {
+                // would block, closed or failed
+                setRecvReady.erase(id);
+                break;
+            }
+        }
+    }
+
+    //
+    // Inactivity checking
+    //
+    int64_t nTime = GetTime();
+    bool fCheckInactivity = nTime != nLastInactivityCheck;
+    nLastInactivityCheck = nTime;
+
+    vector<CNode*> vNodesCopy;
+    {
+        LOCK(cs_vNodes);
+        if (fCheckInactivity) {
             vNodesCopy = vNodes;
             for (auto pNode : vNodesCopy)
                 pNode->AddRef();
         }
-        for (auto pNode : vNodesCopy) {
-            boost::this_thread::interruption_point();
 
-            //
-            // Receive
-            //
-            if (pNode->hSocket == INVALID_SOCKET)
-                continue;
-            if (FD_ISSET(pNode->hSocket, &fdsetRecv) || FD_ISSET(pNode->hSocket, &fdsetError)) {
-                TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
-                if (lockRecv) {
-                    {
-                        // typical socket buffer is 8K-64K
-                        char pchBuf[0x10000];
-                        int32_t nBytes = recv(pNode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
-                        if (nBytes > 0) {
-                            if (!pNode->ReceiveMsgBytes(pchBuf, nBytes))
-                                pNode->CloseSocketDisconnect();
-                            pNode->nLastRecv = GetTime();
-                            pNode->nRecvBytes += nBytes;
-                            pNode->RecordBytesRecv(nBytes);
-                        } else if (nBytes == 0) {
-                            // socket closed gracefully
-                            if (!pNode->fDisconnect)
-                                LogPrint(BCLog::NET, "socket[%s] closed\n", pNode->addr.ToString());
-                            pNode->CloseSocketDisconnect();
-                        } else if (nBytes < 0) {
-                            // error
-                            int32_t nErr = WSAGetLastError();
-                            if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR &&
-                                nErr != WSAEINPROGRESS) {
-                                if (!pNode->fDisconnect)
-                                    LogPrint(BCLog::INFO, "socket[%s] recv error %s\n", pNode->addr.ToString(), NetworkErrorString(nErr));
-                                pNode->CloseSocketDisconnect();
-                            }
-                        }
-                    }
-                }
-            }
+        for (auto pNode : vNodesReady)
+            pNode->Release();
+    }
 
-            //
-            // Send
-            //
-            if (pNode->hSocket == INVALID_SOCKET)
-                continue;
-            if (FD_ISSET(pNode->hSocket, &fdsetSend)) {
-                TRY_LOCK(pNode->cs_vSend, lockSend);
-                if (lockSend)
-                    pNode->SocketSendData();
-            }
+    for (auto pNode : vNodesCopy)
+        InactivityCheck(pNode);
 
-            //
-            // Inactivity checking
-            //
-            if (pNode->vSendMsg.empty())
-                pNode->nLastSendEmpty = GetTime();
-            // p2p_xiaoyu_20191126
-            // if (GetTime() - pNode->nTimeConnected > 60) {
-            //     if (pNode->nLastRecv == 0 || pNode->nLastSend == 0) {
-            //         LogPrint(BCLog::NET, "socket no message in first 60 seconds, %d %d\n", pNode->nLastRecv != 0,
-            //                  pNode->nLastSend != 0);
-            //         pNode->fDisconnect = true;
-            //     } else if (GetTime() - pNode->nLastSend > 90 * 60 && GetTime() - pNode->nLastSendEmpty > 90 * 60) {
-            //         LogPrint(BCLog::INFO, "socket not sending\n");
-            //         pNode->fDisconnect = true;
-            //     } else if (GetTime() - pNode->nLastRecv > 90 * 60) {
-            //         LogPrint(BCLog::INFO, "socket inactivity timeout\n");
-            //         pNode->fDisconnect = true;
-            //     }
-            // }
-            int64_t nTime = GetSystemTimeInSeconds();
-            if (nTime - pNode->nTimeConnected > DEFAULT_PEER_CONNECT_TIMEOUT)
-            {
-                if (pNode->nLastRecv == 0 || pNode->nLastSend == 0)
-                {
-                    LogPrint(BCLog::NET, "socket no message in first %i seconds, %d %d from %d\n", DEFAULT_PEER_CONNECT_TIMEOUT, pNode->nLastRecv != 0, pNode->nLastSend != 0, pNode->GetId());
-                    pNode->fDisconnect = true;
-                }
-                else if (nTime - pNode->nLastSend > TIMEOUT_INTERVAL)
-                {
-                    LogPrint(BCLog::NET, "socket sending timeout: %is\n", nTime - pNode->nLastSend);
-                    pNode->fDisconnect = true;
-                }
-                else if (nTime - pNode->nLastRecv > TIMEOUT_INTERVAL )
-                {
-                    LogPrint(BCLog::NET, "socket receive timeout: %is\n", nTime - pNode->nLastRecv);
-                    pNode->fDisconnect = true;
-                }
-                else if (pNode->nPingNonceSent && pNode->nPingUsecStart + TIMEOUT_INTERVAL * 1000000 < GetTimeMicros())
-                {
-                    LogPrint(BCLog::NET, "ping timeout: %fs\n", 0.000001 * (GetTimeMicros() - pNode->nPingUsecStart));
-                    pNode->fDisconnect = true;
-                }
-                else if (!pNode->fSuccessfullyConnected)
-                {
-                    LogPrint(BCLog::NET, "version handshake timeout from %d\n", pNode->GetId());
-                    pNode->fDisconnect = true;
-                }
-            }
+    {
+        LOCK(cs_vNodes);
+        for (auto pNode : vNodesCopy)
+            pNode->Release();
+    }
+}
 
+// create the event loop of the sockets, fall back to select() if it fails
+static void InitSocketEvents() {
+    if (!UseSocketEventsEpoll()) {
+        string mode = SysCfg().GetArg("-socketevents", "epoll");
+        LogPrint(BCLog::INFO, "socket events: %s\n", mode == "select" ? "select" : "unknown mode, use select");
+        return;
+    }
 
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd == SOCKET_ERROR) {
+        LogPrint(BCLog::INFO, "epoll_create1 failed: %s, use select\n", NetworkErrorString(errno));
+        epollFd = -1;
+        return;
+    }
+
+    for (size_t i = 0; i < vhListenSocket.size(); i++) {
+        struct epoll_event event;
+        event.events   = EPOLLIN;
+        event.data.u64 = EPOLL_LISTEN_TAG | i;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, vhListenSocket[i], &event) == SOCKET_ERROR) {
+            LogPrint(BCLog::INFO, "epoll_ctl add listen socket failed: %s, use select\n", NetworkErrorString(errno));
+            close(epollFd);
+            epollFd = -1;
+            return;
         }
+    }
+    LogPrint(BCLog::INFO, "socket events: epoll\n");
+}
+#endif
 
-        {
-            LOCK(cs_vNodes);
-            for (auto pNode : vNodesCopy)
-                pNode->Release();
+void ThreadSocketHandler() {
+    uint32_t nPrevNodeCount = 0;
+#ifdef USE_EPOLL
+    set<NodeId> setRecvReady;
+    set<NodeId> setSendReady;
+    int64_t nLastInactivityCheck = 0;
+#endif
+    while (true) {
+        //
+        // Disconnect nodes
+        //
+        DisconnectNodes(nPrevNodeCount);
+
+#ifdef USE_EPOLL
+        if (epollFd != -1) {
+            ServiceSocketsEpoll(setRecvReady, setSendReady, nLastInactivityCheck);
+            continue;
         }
+#endif
+        ServiceSocketsSelect();
     }
 }
 
@@ -1189,6 +1473,9 @@ void ThreadMessageHandler() {
         if (!fHaveSyncNode)
             StartSync(vNodesCopy);
 
+        // verify and decode the received messages in parallel before processing them one by one
+        GetNodeSignals().PrecheckMessages(vNodesCopy);
+
         // Poll the connected nodes for messages
         CNode* pnodeTrickle = nullptr;
         if (!vNodesCopy.empty())
@@ -1233,8 +1520,13 @@ void ThreadMessageHandler() {
                 pNode->Release();
         }
 
-        if (fSleep)
-            MilliSleep(100);
+        {
+            std::unique_lock<std::mutex> lock(mutexMsgProc);
+            if (fSleep)
+                condMsgProc.wait_for(lock, std::chrono::milliseconds(100), [] { return fMsgProcWake; });
+            fMsgProcWake = false;
+        }
+        boost::this_thread::interruption_point();
     }
 }
 
@@ -1391,6 +1683,10 @@ void StartNode(boost::thread_group& threadGroup) {
 
     Discover(threadGroup);
 
+#ifdef USE_EPOLL
+    InitSocketEvents();
+#endif
+
     //
     // Start threads
     //
@@ -1457,6 +1753,11 @@ public:
             delete pNode;
         vNodes.clear();
         vNodesDisconnected.clear();
+#ifdef USE_EPOLL
+        mapEpollNodes.clear();
+        if (epollFd != -1)
+            close(epollFd);
+#endif
         delete semOutbound;
         semOutbound = nullptr;
         delete pnodeLocalHost;
@@ -52,6 +52,8 @@ uint16_t GetListenPort();
 bool BindListenPort(const CService& bindAddr, string& strError = REF(string()));
 void StartNode(boost::thread_group& threadGroup);
 bool StopNode();
+// whether -socketevents picks the epoll loop, which is not limited to the sockets below FD_SETSIZE
+bool UseSocketEventsEpoll();
 
 enum {
     LOCAL_NONE,    // unknown
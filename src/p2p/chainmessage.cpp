@@ -4,14 +4,17 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "chainmessage.h"
+#include "compactblock.h"
 #include "commons/uint256.h"
 #include "commons/util/util.h"
 #include "main.h"
 #include "net.h"
 #include "node.h"
+#include "miner/miner.h"
 #include "miner/pbftcontext.h"
 #include "miner/pbftmanager.h"
 
+#include <limits>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -71,13 +74,89 @@ void MarkBlockAsInFlight(const uint256 &hash, NodeId nodeId) {
     mapBlocksInFlight[hash] = std::make_tuple(nodeId, it, GetTimeMicros());
 }
 
+// Send the block as it is stored in the block file, saves deserializing and serializing it again
+static bool PushRawBlock(CNode *pFrom, const CDiskBlockPos &pos, const uint256 &hash, int32_t height) {
+    std::vector<char> data;
+    CBlockFileSpan span = blockFileMapper.GetBlockSpan(pos);
+    if (span.IsNull()) {
+        if (!ReadRawBlockFromDisk(pos, data) || data.empty())
+            return false;
+
+        span.pBegin = data.data();
+        span.pEnd   = data.data() + data.size();
+    }
+
+    CBlockHeader header;
+    try {
+        CBlockFileReader reader(span, SER_DISK, CLIENT_VERSION);
+        reader >> header;
+    } catch (std::exception &) {
+        return false;
+    }
+    if (header.GetHash() != hash)
+        return false;
+
+    LogPrint(BCLog::NET, "send block[%u]: %s to peer %s\n", height, hash.GetHex(), pFrom->addr.ToString());
+
+    pFrom->PushMessage(NetMsgType::BLOCK, CFlatData((void *)span.pBegin, (void *)span.pEnd));
+    return true;
+}
+
+// the block is sent decoded when it is asked compact or filtered, or when its raw bytes can not be pushed
+static bool PushBlock(CNode *pFrom, const CInv &inv, const CDiskBlockPos &blockPos, bool fCmpct) {
+    // the recent blocks are asked right after they are relayed compact, serve them from memory
+    std::shared_ptr<const CBlock> spBlock;
+    if (fCmpct)
+        spBlock = recentBlockCache.Get(inv.hash);
+    if (!spBlock) {
+        // Load block from disk and send it
+        auto spNewBlock = std::make_shared<CBlock>();
+        if (!ReadBlockFromDisk(blockPos, *spNewBlock) || spNewBlock->GetHash() != inv.hash)
+            return ERRORMSG("read block %s from disk failed", inv.hash.GetHex());
+
+        spBlock = spNewBlock;
+    }
+    const CBlock &block = *spBlock;
+    if (fCmpct) {
+        LogPrint(BCLog::NET, "send compact block[%u]: %s to peer %s\n", block.GetHeight(),
+                 block.GetHash().GetHex(), pFrom->addr.ToString());
+
+        pFrom->PushMessage(NetMsgType::CMPCTBLOCK,
+                           CBlockHeaderAndShortTxIDs(block, GetRand(std::numeric_limits<uint64_t>::max())));
+
+    } else if (inv.type != MSG_FILTERED_BLOCK) {
+        LogPrint(BCLog::NET, "send block[%u]: %s to peer %s\n", block.GetHeight(), block.GetHash().GetHex(),
+                 pFrom->addr.ToString());
+
+        pFrom->PushMessage(NetMsgType::BLOCK, block);
+
+    } else  {// MSG_FILTERED_BLOCK)
+        LOCK(pFrom->cs_filter);
+        if (pFrom->pFilter) {
+            // only the compact blocks are shared with recentBlockCache, this one is our own copy
+            CMerkleBlock merkleBlock(const_cast<CBlock &>(block), *pFrom->pFilter);
+            pFrom->PushMessage("merkleblock", merkleBlock);
+            // CMerkleBlock just contains hashes, so also push any transactions in the block the client
+            // did not see This avoids hurting performance by pointlessly requiring a round-trip Note
+            // that there is currently no way for a node to request any single transactions we didnt
+            // send here - they must either disconnect and retry or request the full block. Thus, the
+            // protocol spec specified allows for us to provide duplicate txn here, however we MUST
+            // always provide at least what the remote peer needs
+            for (auto &pair : merkleBlock.vMatchedTxn)
+                if (!pFrom->setInventoryKnown.count(CInv(MSG_TX, pair.second)))
+                    pFrom->PushMessage(NetMsgType::TX, block.vptx[pair.first]);
+        }
+        // else
+        // no response
+    }
+    return true;
+}
+
 void ProcessGetData(CNode *pFrom) {
     deque<CInv>::iterator it = pFrom->vRecvGetData.begin();
 
     vector<CInv> vNotFound;
 
-    LOCK(cs_main);
-
     while (it != pFrom->vRecvGetData.end()) {
         // Don't bother if send buffer is too full to respond anyway
         if (pFrom->nSendSize >= SendBufferSize()) {
@@ -90,46 +169,40 @@ void ProcessGetData(CNode *pFrom) {
             boost::this_thread::interruption_point();
             it++;
 
-            if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK) {
-                auto mi = mapBlockIndex.find(inv.hash);
-                if (mi == mapBlockIndex.end()) {
+            if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK || inv.type == MSG_CMPCT_BLOCK) {
+                // only the lookup needs cs_main, the block is read and sent without holding it
+                CDiskBlockPos blockPos;
+                int32_t height = 0;
+                int32_t tipHeight = 0;
+                uint256 tipHash;
+                {
+                    LOCK(cs_main);
+                    auto mi = mapBlockIndex.find(inv.hash);
+                    if (mi != mapBlockIndex.end()) {
+                        blockPos = mi->second->GetBlockPos();
+                        height   = mi->second->height;
+                    }
+                    tipHash   = chainActive.Tip()->GetBlockHash();
+                    tipHeight = chainActive.Height();
+                }
+
+                if (blockPos.IsNull()) {
                     LogPrint(BCLog::NET, "block %s not found\n", inv.hash.GetHex());
 
-                } else { // Load block from disk and send it
-                    CBlock block;
-                    ReadBlockFromDisk((*mi).second, block);
-                    if (inv.type == MSG_BLOCK) {
-                        LogPrint(BCLog::NET, "send block[%u]: %s to peer %s\n", block.GetHeight(), block.GetHash().GetHex(),
-                                 pFrom->addr.ToString());
-
-                        pFrom->PushMessage(NetMsgType::BLOCK, block);
-
-                    } else  {// MSG_FILTERED_BLOCK)
-                        LOCK(pFrom->cs_filter);
-                        if (pFrom->pFilter) {
-                            CMerkleBlock merkleBlock(block, *pFrom->pFilter);
-                            pFrom->PushMessage("merkleblock", merkleBlock);
-                            // CMerkleBlock just contains hashes, so also push any transactions in the block the client
-                            // did not see This avoids hurting performance by pointlessly requiring a round-trip Note
-                            // that there is currently no way for a node to request any single transactions we didnt
-                            // send here - they must either disconnect and retry or request the full block. Thus, the
-                            // protocol spec specified allows for us to provide duplicate txn here, however we MUST
-                            // always provide at least what the remote peer needs
-                            for (auto &pair : merkleBlock.vMatchedTxn)
-                                if (!pFrom->setInventoryKnown.count(CInv(MSG_TX, pair.second)))
-                                    pFrom->PushMessage(NetMsgType::TX, block.vptx[pair.first]);
-                        }
-                        // else
-                        // no response
-                    }
+                } else {
+                    bool fCmpct = inv.type == MSG_CMPCT_BLOCK && height + MAX_CMPCT_BLOCK_DEPTH >= tipHeight;
+                    bool fWhole = inv.type == MSG_BLOCK || (inv.type == MSG_CMPCT_BLOCK && !fCmpct);
+                    if (!fWhole || !PushRawBlock(pFrom, blockPos, inv.hash, height))
+                        PushBlock(pFrom, inv, blockPos, fCmpct);
 
-                    // Trigger them to send a getblocks request for the next batch of inventory
+                    // Trigger them to send a getblocks request for the next batch of inventory, also when the block
+                    // could not be read, or the peer would wait for it forever
                     if (inv.hash == pFrom->hashContinue) {
                         // Bypass PushInventory, this must send even if redundant,
                         // and we want it right after the last block so they don't
                         // wait for other stuff first.
                         vector<CInv> vInv;
-                        vInv.push_back(CInv(MSG_BLOCK, chainActive.Tip()->GetBlockHash()));
+                        vInv.push_back(CInv(MSG_BLOCK, tipHash));
                         pFrom->PushMessage(NetMsgType::INV, vInv);
                         pFrom->hashContinue.SetNull();
                         LogPrint(BCLog::NET, "reset node hashcontinue\n");
@@ -302,6 +375,10 @@ int32_t ProcessVersionMessage(CNode *pFrom, string strCommand, CDataStream &vRec
     pFrom->PushMessage(NetMsgType::VERACK);
     pFrom->ssSend.SetVersion(min(pFrom->nVersion, PROTOCOL_VERSION));
 
+    // the peers not knowing it ignore the command
+    if (SysCfg().GetBoolArg("-cmpctblocks", true))
+        pFrom->PushMessage(NetMsgType::SENDCMPCT, true, CMPCT_BLOCK_VERSION);
+
     if (!pFrom->fInbound) {
         // Advertise our address
         if (!fNoListen && !IsInitialBlockDownload()) {
@@ -461,13 +538,14 @@ bool ProcessAddrMessage(CNode *pFrom, CDataStream &vRecv) {
     return true;
 }
 
-bool ProcessTxMessage(CNode *pFrom, string strCommand, CDataStream &vRecv) {
-    std::shared_ptr<CBaseTx> pBaseTx;
-    try {
-        vRecv >> pBaseTx;
-    } catch(const runtime_error &e) {
-        // TODO: record the misebehaving or ban the peer node.
-        return ERRORMSG("Unknown transaction type from peer %s, ignore! %s", pFrom->addr.ToString(), e.what());
+bool ProcessTxMessage(CNode *pFrom, string strCommand, CDataStream &vRecv, std::shared_ptr<CBaseTx> pBaseTx) {
+    if (!pBaseTx) {
+        try {
+            vRecv >> pBaseTx;
+        } catch(const runtime_error &e) {
+            // TODO: record the misebehaving or ban the peer node.
+            return ERRORMSG("Unknown transaction type from peer %s, ignore! %s", pFrom->addr.ToString(), e.what());
+        }
     }
 
     if (pBaseTx->IsRelayForbidden()) {
@@ -694,14 +772,8 @@ bool ProcessGetDataMessage(CNode *pFrom, CDataStream &vRecv) {
     return true;
 }
 
-void ProcessBlockMessage(CNode *pFrom, CDataStream &vRecv) {
-    CBlock block;
-    vRecv >> block;
-
-    LogPrint(BCLog::NET, "recv block! time_ms=%lld, hash=%s, peer=%s\n", GetTimeMillis(),
-        block.GetHash().ToString(), pFrom->addr.ToString());
-    // block.Print();
-
+// Process the block received whole or reconstructed from a compact block
+static void ProcessReceivedBlock(CNode *pFrom, CBlock &block) {
     CInv inv(MSG_BLOCK, block.GetHash());
     pFrom->AddInventoryKnown(inv);
 
@@ -726,6 +798,269 @@ void ProcessBlockMessage(CNode *pFrom, CDataStream &vRecv) {
 
 }
 
+void ProcessBlockMessage(CNode *pFrom, CDataStream &vRecv) {
+    CBlock block;
+    vRecv >> block;
+
+    LogPrint(BCLog::NET, "recv block! time_ms=%lld, hash=%s, peer=%s\n", GetTimeMillis(),
+        block.GetHash().ToString(), pFrom->addr.ToString());
+    // block.Print();
+
+    ProcessReceivedBlock(pFrom, block);
+}
+
+// Ask the peer for the whole block, when its compact block can not be reconstructed
+static void RequestWholeBlock(CNode *pFrom, const uint256 &hash) {
+    {
+        LOCK(cs_main);
+        if (mapBlockIndex.count(hash))
+            return;
+    }
+
+    {
+        LOCK(cs_mapNodeState);
+        MarkBlockAsInFlight(hash, pFrom->GetId());
+    }
+
+    LogPrint(BCLog::NET, "request whole block %s from peer %s\n", hash.GetHex(), pFrom->addr.ToString());
+    pFrom->PushMessage(NetMsgType::GETDATA, vector<CInv>(1, CInv(MSG_BLOCK, hash)));
+}
+
+/**
+ * The cheap checks of a compact block before the mempool is scanned or any tx is requested: it extends a known
+ * recent block and is signed by the delegate scheduled for its slot, like VerifyRewardTx() checks the whole block.
+ * The schedule is only known for the blocks on top of the tip, the others are asked whole by setting fWhole.
+ */
+static bool CheckCmpctBlockHeader(const CBlockHeaderAndShortTxIDs &cmpctBlock, const uint256 &hash, int32_t &nDoS,
+                                  bool &fWhole) {
+    const CBlockHeader &header = cmpctBlock.header;
+    const auto &signature      = header.GetSignature();
+    if (signature.empty() || signature.size() > MAX_SIGNATURE_SIZE) {
+        nDoS = 100;
+        return ERRORMSG("invalid signature size of compact block %s", hash.GetHex());
+    }
+
+    // the block reward tx is always prefilled, its sender is the producer
+    if (cmpctBlock.prefilledTxs.empty() || cmpctBlock.prefilledTxs[0].index != 0) {
+        nDoS = 100;
+        return ERRORMSG("compact block %s without its reward tx", hash.GetHex());
+    }
+
+    LOCK(cs_main);
+    auto mi = mapBlockIndex.find(header.GetPrevBlockHash());
+    if (mi == mapBlockIndex.end())
+        return ERRORMSG("previous block %s of compact block %s not found", header.GetPrevBlockHash().GetHex(),
+                        hash.GetHex());
+
+    if ((int32_t)header.GetHeight() != mi->second->height + 1) {
+        nDoS = 100;
+        return ERRORMSG("height %u of compact block %s does not follow its previous block", header.GetHeight(),
+                        hash.GetHex());
+    }
+
+    if (mi->second->height + MAX_CMPCT_BLOCK_DEPTH < chainActive.Height())
+        return ERRORMSG("compact block %s at height %u is too deep", hash.GetHex(), header.GetHeight());
+
+    // the active delegates of the cache are the ones of the tip, a fork block may be scheduled from others
+    fWhole = mi->second != chainActive.Tip();
+    if (fWhole)
+        return true;
+
+    VoteDelegateVector delegates;
+    if (!pCdMan->pDelegateCache->GetActiveDelegates(delegates) || delegates.empty())
+        return ERRORMSG("get active delegates failed");
+
+    VoteDelegate curDelegate;
+    ShuffleDelegates(header.GetHeight(), header.GetTime(), delegates);
+    if (!GetCurrentDelegate(header.GetTime(), header.GetHeight(), delegates, curDelegate))
+        return ERRORMSG("failed to get current delegate");
+
+    CAccount account;
+    if (!pCdMan->pAccountCache->GetAccount(cmpctBlock.prefilledTxs[0].pTx->txUid, account))
+        return ERRORMSG("producer %s of compact block %s not found",
+                        cmpctBlock.prefilledTxs[0].pTx->txUid.ToString(), hash.GetHex());
+
+    if (account.regid != curDelegate.regid) {
+        nDoS = 100;
+        return ERRORMSG("[%u] delegate of compact block %s should be (%s) vs what we got (%s)", header.GetHeight(),
+                        hash.GetHex(), curDelegate.regid.ToString(), account.regid.ToString());
+    }
+
+    if (!VerifySignature(hash, signature, account.owner_pubkey) &&
+        !VerifySignature(hash, signature, account.miner_pubkey))
+        return ERRORMSG("invalid producer signature of compact block %s", hash.GetHex());
+
+    return true;
+}
+
+void ProcessSendCmpctMessage(CNode *pFrom, CDataStream &vRecv) {
+    bool fAnnounce   = false;
+    uint64_t version = 0;
+    vRecv >> fAnnounce >> version;
+
+    if (version == CMPCT_BLOCK_VERSION)
+        pFrom->fCmpctBlocks = fAnnounce;
+}
+
+bool ProcessCmpctBlockMessage(CNode *pFrom, CDataStream &vRecv) {
+    CBlockHeaderAndShortTxIDs cmpctBlock;
+    vRecv >> cmpctBlock;
+
+    auto pPartialBlock = std::make_shared<CPartialBlock>();
+    CPartialBlock::Status status = pPartialBlock->Init(cmpctBlock);
+    if (status == CPartialBlock::READ_INVALID) {
+        Misbehaving(pFrom->GetId(), 100);
+        return ERRORMSG("invalid compact block from peer %s", pFrom->addr.ToString());
+    }
+
+    const uint256 &hash = pPartialBlock->GetBlockHash();
+    LogPrint(BCLog::NET, "recv compact block! time_ms=%lld, hash=%s, txs=%u, prefilled=%u, peer=%s\n",
+             GetTimeMillis(), hash.ToString(), cmpctBlock.GetTxCount(), cmpctBlock.prefilledTxs.size(),
+             pFrom->addr.ToString());
+
+    pFrom->AddInventoryKnown(CInv(MSG_BLOCK, hash));
+
+    bool fAlreadyHave = false;
+    {
+        LOCK(cs_main);
+        fAlreadyHave = mapBlockIndex.count(hash) || mapOrphanBlocks.count(hash);
+    }
+    if (fAlreadyHave) {
+        LOCK(cs_mapNodeState);
+        MarkBlockAsReceived(hash, pFrom->GetId());
+        return true;
+    }
+
+    int32_t nDoS = 0;
+    bool fWhole  = false;
+    if (!CheckCmpctBlockHeader(cmpctBlock, hash, nDoS, fWhole)) {
+        if (nDoS > 0)
+            Misbehaving(pFrom->GetId(), nDoS);
+        LogPrint(BCLog::NET, "drop compact block %s from peer %s\n", hash.GetHex(), pFrom->addr.ToString());
+        return true;
+    }
+
+    if (fWhole || status == CPartialBlock::READ_FAILED) {
+        RequestWholeBlock(pFrom, hash);
+        return true;
+    }
+
+    pPartialBlock->AddMempoolTxs(mempool);
+    vector<uint32_t> missingIndexes = pPartialBlock->GetMissingIndexes();
+    if (missingIndexes.empty()) {
+        CBlock block;
+        if (!pPartialBlock->FillBlock(block, {})) {
+            RequestWholeBlock(pFrom, hash);
+            return true;
+        }
+
+        ProcessReceivedBlock(pFrom, block);
+        return true;
+    }
+
+    // the peer sends a block after the other, the one still waiting for its txs is asked whole
+    if (pFrom->pPartialBlock && pFrom->pPartialBlock->GetBlockHash() != hash)
+        RequestWholeBlock(pFrom, pFrom->pPartialBlock->GetBlockHash());
+
+    pFrom->pPartialBlock = pPartialBlock;
+
+    LogPrint(BCLog::NET, "request %u of %u txs of compact block %s from peer %s\n", missingIndexes.size(),
+             cmpctBlock.GetTxCount(), hash.ToString(), pFrom->addr.ToString());
+
+    CBlockTxnRequest request;
+    request.blockHash = hash;
+    request.indexes   = std::move(missingIndexes);
+    pFrom->PushMessage(NetMsgType::GETBLOCKTXN, request);
+    return true;
+}
+
+bool ProcessGetBlockTxnMessage(CNode *pFrom, CDataStream &vRecv) {
+    CBlockTxnRequest request;
+    vRecv >> request;
+
+    // the indexes are in the block order, the repeated ones would make the answer grow without bound
+    for (size_t i = 1; i < request.indexes.size(); i++) {
+        if (request.indexes[i] <= request.indexes[i - 1]) {
+            Misbehaving(pFrom->GetId(), 100);
+            return ERRORMSG("getblocktxn indexes of block %s not increasing from peer %s",
+                            request.blockHash.GetHex(), pFrom->addr.ToString());
+        }
+    }
+
+    CDiskBlockPos blockPos;
+    int32_t height    = 0;
+    int32_t tipHeight = 0;
+    {
+        LOCK(cs_main);
+        auto mi = mapBlockIndex.find(request.blockHash);
+        if (mi != mapBlockIndex.end()) {
+            blockPos = mi->second->GetBlockPos();
+            height   = mi->second->height;
+        }
+        tipHeight = chainActive.Height();
+    }
+    if (blockPos.IsNull()) {
+        LogPrint(BCLog::NET, "getblocktxn block %s not found\n", request.blockHash.GetHex());
+        return true;
+    }
+
+    // the deep blocks are not relayed compact, answer with the whole block like ProcessGetData()
+    if (height + MAX_CMPCT_BLOCK_DEPTH < tipHeight) {
+        LogPrint(BCLog::NET, "getblocktxn block %s too deep, send it whole to peer %s\n",
+                 request.blockHash.GetHex(), pFrom->addr.ToString());
+        pFrom->vRecvGetData.push_back(CInv(MSG_BLOCK, request.blockHash));
+        ProcessGetData(pFrom);
+        return true;
+    }
+
+    std::shared_ptr<const CBlock> spBlock = recentBlockCache.Get(request.blockHash);
+    if (!spBlock) {
+        auto spNewBlock = std::make_shared<CBlock>();
+        if (!ReadBlockFromDisk(blockPos, *spNewBlock))
+            return ERRORMSG("read block %s from disk failed", request.blockHash.GetHex());
+
+        spBlock = spNewBlock;
+    }
+
+    CBlockTxn blockTxn;
+    blockTxn.blockHash = request.blockHash;
+    blockTxn.txs.reserve(request.indexes.size());
+    for (uint32_t index : request.indexes) {
+        if (index >= spBlock->vptx.size()) {
+            Misbehaving(pFrom->GetId(), 100);
+            return ERRORMSG("getblocktxn index %u out of block %s from peer %s", index,
+                            request.blockHash.GetHex(), pFrom->addr.ToString());
+        }
+        blockTxn.txs.push_back(spBlock->vptx[index]);
+    }
+
+    pFrom->PushMessage(NetMsgType::BLOCKTXN, blockTxn);
+    return true;
+}
+
+void ProcessBlockTxnMessage(CNode *pFrom, CDataStream &vRecv) {
+    CBlockTxn blockTxn;
+    vRecv >> blockTxn;
+
+    std::shared_ptr<CPartialBlock> pPartialBlock = pFrom->pPartialBlock;
+    if (!pPartialBlock || pPartialBlock->GetBlockHash() != blockTxn.blockHash) {
+        LogPrint(BCLog::NET, "recv unexpected blocktxn of block %s from peer %s\n", blockTxn.blockHash.GetHex(),
+                 pFrom->addr.ToString());
+        return;
+    }
+    pFrom->pPartialBlock.reset();
+
+    CBlock block;
+    if (!pPartialBlock->FillBlock(block, blockTxn.txs)) {
+        LogPrint(BCLog::NET, "compact block %s does not match its txs from peer %s\n", blockTxn.blockHash.GetHex(),
+                 pFrom->addr.ToString());
+        RequestWholeBlock(pFrom, blockTxn.blockHash);
+        return;
+    }
+
+    ProcessReceivedBlock(pFrom, block);
+}
+
 void ProcessMempoolMessage(CNode *pFrom, CDataStream &vRecv) {
     LOCK2(cs_main, pFrom->cs_filter);
 
@@ -65,7 +65,8 @@ void ProcessPongMessage(CNode *pFrom, CDataStream &vRecv);
 
 bool ProcessAddrMessage(CNode *pFrom, CDataStream &vRecv);
 
-bool ProcessTxMessage(CNode *pFrom, string strCommand, CDataStream &vRecv);
+// pBaseTx is the tx decoded by the precheck, nullptr to decode it from vRecv
+bool ProcessTxMessage(CNode *pFrom, string strCommand, CDataStream &vRecv, std::shared_ptr<CBaseTx> pBaseTx);
 
 bool ProcessGetHeadersMessage(CNode *pFrom, CDataStream &vRecv);
 
@@ -77,6 +78,14 @@ bool ProcessGetDataMessage(CNode *pFrom, CDataStream &vRecv);
 
 void ProcessBlockMessage(CNode *pFrom, CDataStream &vRecv);
 
+void ProcessSendCmpctMessage(CNode *pFrom, CDataStream &vRecv);
+
+bool ProcessCmpctBlockMessage(CNode *pFrom, CDataStream &vRecv);
+
+bool ProcessGetBlockTxnMessage(CNode *pFrom, CDataStream &vRecv);
+
+void ProcessBlockTxnMessage(CNode *pFrom, CDataStream &vRecv);
+
 void ProcessMempoolMessage(CNode *pFrom, CDataStream &vRecv);
 
 void ProcessAlertMessage(CNode *pFrom, CDataStream &vRecv);
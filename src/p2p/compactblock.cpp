@@ -0,0 +1,145 @@
+// Copyright (c) 2017-2020 The DragonBallChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "compactblock.h"
+
+#include "config/version.h"
+#include "crypto/hash.h"
+#include "crypto/siphash.h"
+#include "tx/txmempool.h"
+
+CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock &block, uint64_t nonceIn)
+    : header(block), nonce(nonceIn) {
+    uint64_t k0, k1;
+    GetShortTxIDKeys(k0, k1);
+
+    shortTxIds.reserve(block.vptx.size());
+    for (uint32_t i = 0; i < block.vptx.size(); i++) {
+        const std::shared_ptr<CBaseTx> &pTx = block.vptx[i];
+        if (i == 0 || pTx->IsBlockRewardTx() || pTx->IsPriceMedianTx()) {
+            CPrefilledTx prefilledTx;
+            prefilledTx.index = i;
+            prefilledTx.pTx   = pTx;
+            prefilledTxs.push_back(prefilledTx);
+        } else {
+            shortTxIds.push_back(GetShortTxID(k0, k1, pTx->GetHash()));
+        }
+    }
+}
+
+void CBlockHeaderAndShortTxIDs::GetShortTxIDKeys(uint64_t &k0, uint64_t &k1) const {
+    CHashWriter ss(SER_GETHASH, CLIENT_VERSION);
+    ss << header << nonce;
+    uint256 keyHash = ss.GetHash();
+    k0 = keyHash.GetUint64(0);
+    k1 = keyHash.GetUint64(1);
+}
+
+uint64_t CBlockHeaderAndShortTxIDs::GetShortTxID(uint64_t k0, uint64_t k1, const uint256 &txid) {
+    return SipHashUint256(k0, k1, txid) & 0xffffffffffffULL;
+}
+
+CPartialBlock::Status CPartialBlock::Init(const CBlockHeaderAndShortTxIDs &cmpctBlock) {
+    // every tx takes more bytes in a block than its short txid in the compact block
+    size_t txCount = cmpctBlock.GetTxCount();
+    if (txCount == 0 || txCount > MAX_BLOCK_SIZE / SHORT_TXID_BYTES)
+        return READ_INVALID;
+
+    header    = cmpctBlock.header;
+    blockHash = header.GetHash();
+    cmpctBlock.GetShortTxIDKeys(k0, k1);
+
+    txs.assign(txCount, nullptr);
+    txids.assign(txCount, uint256());
+    collisions.assign(txCount, false);
+    shortTxIdIndexes.clear();
+    shortTxIdIndexes.reserve(cmpctBlock.shortTxIds.size());
+
+    int64_t lastIndex = -1;
+    for (const auto &prefilledTx : cmpctBlock.prefilledTxs) {
+        if (prefilledTx.index <= lastIndex || prefilledTx.index >= txCount || !prefilledTx.pTx)
+            return READ_INVALID;
+
+        txs[prefilledTx.index] = prefilledTx.pTx;
+        lastIndex              = prefilledTx.index;
+    }
+
+    // the short txids take the slots left by the prefilled txs in order
+    uint32_t index = 0;
+    for (const auto &shortTxId : cmpctBlock.shortTxIds) {
+        while (txs[index])
+            index++;
+
+        if (!shortTxIdIndexes.emplace(shortTxId.id, index).second)
+            return READ_FAILED;
+
+        index++;
+    }
+
+    missingCount = cmpctBlock.shortTxIds.size();
+    return READ_OK;
+}
+
+void CPartialBlock::AddAvailableTx(const uint256 &txid, const std::shared_ptr<CBaseTx> &pTx) {
+    auto it = shortTxIdIndexes.find(CBlockHeaderAndShortTxIDs::GetShortTxID(k0, k1, txid));
+    if (it == shortTxIdIndexes.end())
+        return;
+
+    uint32_t index = it->second;
+    if (collisions[index] || txids[index] == txid)
+        return;
+
+    if (txs[index]) {
+        txs[index]        = nullptr;
+        collisions[index] = true;
+        missingCount++;
+        return;
+    }
+
+    // the block txs are executed, they must not be the mempool objects
+    txs[index]   = pTx->GetNewInstance();
+    txids[index] = txid;
+    missingCount--;
+}
+
+void CPartialBlock::AddMempoolTxs(CTxMemPool &pool) {
+    LOCK(pool.cs);
+    for (const auto &item : pool.memPoolTxs) {
+        if (missingCount == 0)
+            break;
+
+        AddAvailableTx(item.first, item.second.GetTransaction());
+    }
+}
+
+std::vector<uint32_t> CPartialBlock::GetMissingIndexes() const {
+    std::vector<uint32_t> indexes;
+    indexes.reserve(missingCount);
+    for (uint32_t i = 0; i < txs.size(); i++) {
+        if (!txs[i])
+            indexes.push_back(i);
+    }
+    return indexes;
+}
+
+bool CPartialBlock::FillBlock(CBlock &block, const std::vector<std::shared_ptr<CBaseTx>> &missingTxs) const {
+    if (missingTxs.size() != missingCount)
+        return false;
+
+    block = CBlock(header);
+    block.vptx.reserve(txs.size());
+    auto missingIt = missingTxs.begin();
+    for (const auto &pTx : txs) {
+        if (pTx) {
+            block.vptx.push_back(pTx);
+        } else {
+            if (!*missingIt)
+                return false;
+
+            block.vptx.push_back(*missingIt++);
+        }
+    }
+
+    return block.BuildMerkleTree() == header.GetMerkleRootHash();
+}
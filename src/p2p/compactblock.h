@@ -0,0 +1,153 @@
+// Copyright (c) 2017-2020 The DragonBallChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef P2P_COMPACTBLOCK_H
+#define P2P_COMPACTBLOCK_H
+
+#include "commons/serialize.h"
+#include "commons/uint256.h"
+#include "persistence/block.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class CTxMemPool;
+
+static const int32_t SHORT_TXID_BYTES = 6;
+// the version of the compact block relay announced in a sendcmpct
+static const uint64_t CMPCT_BLOCK_VERSION = 1;
+// the blocks deeper than this are sent whole, their txs have left the mempools long ago
+static const int32_t MAX_CMPCT_BLOCK_DEPTH = 10;
+
+/** The low 6 bytes of the SipHash-2-4 of a txid, keyed by the hash of the block header and the nonce */
+class CShortTxID {
+public:
+    uint64_t id = 0;
+
+    CShortTxID() {}
+    CShortTxID(uint64_t idIn) : id(idIn) {}
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const { return SHORT_TXID_BYTES; }
+
+    template <typename Stream>
+    void Serialize(Stream &s, int nType, int nVersion) const {
+        uint8_t bytes[SHORT_TXID_BYTES];
+        for (int32_t i = 0; i < SHORT_TXID_BYTES; i++)
+            bytes[i] = (uint8_t)(id >> (8 * i));
+        s.write((char *)bytes, sizeof(bytes));
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream &s, int nType, int nVersion) {
+        uint8_t bytes[SHORT_TXID_BYTES];
+        s.read((char *)bytes, sizeof(bytes));
+        id = 0;
+        for (int32_t i = 0; i < SHORT_TXID_BYTES; i++)
+            id |= (uint64_t)bytes[i] << (8 * i);
+    }
+};
+
+/** A tx sent whole in the compact block, the block reward and price median txs are never in a mempool */
+class CPrefilledTx {
+public:
+    uint32_t index = 0;  // position in the block
+    std::shared_ptr<CBaseTx> pTx;
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(VARINT(index));
+        READWRITE(pTx);
+    )
+};
+
+/** The "cmpctblock" message: the block header, the short txids of the txs and the prefilled txs */
+class CBlockHeaderAndShortTxIDs {
+public:
+    CBlockHeader header;
+    uint64_t nonce = 0;
+    std::vector<CShortTxID> shortTxIds;  // the txs not prefilled, in the block order
+    std::vector<CPrefilledTx> prefilledTxs;  // in the block order
+
+public:
+    CBlockHeaderAndShortTxIDs() {}
+    CBlockHeaderAndShortTxIDs(const CBlock &block, uint64_t nonceIn);
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(header);
+        READWRITE(nonce);
+        READWRITE(shortTxIds);
+        READWRITE(prefilledTxs);
+    )
+
+    void GetShortTxIDKeys(uint64_t &k0, uint64_t &k1) const;
+    static uint64_t GetShortTxID(uint64_t k0, uint64_t k1, const uint256 &txid);
+
+    size_t GetTxCount() const { return shortTxIds.size() + prefilledTxs.size(); }
+};
+
+/** The "getblocktxn" message, the block indexes of the txs missing to reconstruct a compact block */
+class CBlockTxnRequest {
+public:
+    uint256 blockHash;
+    std::vector<uint32_t> indexes;
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(blockHash);
+        READWRITE(indexes);
+    )
+};
+
+/** The "blocktxn" message, the txs asked by a getblocktxn in the order of the request */
+class CBlockTxn {
+public:
+    uint256 blockHash;
+    std::vector<std::shared_ptr<CBaseTx>> txs;
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(blockHash);
+        READWRITE(txs);
+    )
+};
+
+/**
+ * A block being reconstructed from a compact block. The prefilled txs and the available txs matching the short
+ * txids are placed first, the missing ones come with a getblocktxn round-trip. The merkle root is checked when
+ * the block is filled, so a short txid matching the wrong tx only costs a request of the whole block.
+ */
+class CPartialBlock {
+public:
+    enum Status {
+        READ_OK,
+        READ_INVALID,  // the compact block is malformed
+        READ_FAILED,   // the short txids collide, the whole block must be requested
+    };
+
+public:
+    Status Init(const CBlockHeaderAndShortTxIDs &cmpctBlock);
+
+    // place a copy of the tx if its short txid is in the block, two txs of one short txid leave the slot missing
+    void AddAvailableTx(const uint256 &txid, const std::shared_ptr<CBaseTx> &pTx);
+    void AddMempoolTxs(CTxMemPool &pool);
+
+    std::vector<uint32_t> GetMissingIndexes() const;
+
+    // build the block with the missing txs in the order of GetMissingIndexes, false if they do not match the block
+    bool FillBlock(CBlock &block, const std::vector<std::shared_ptr<CBaseTx>> &missingTxs) const;
+
+    const uint256 &GetBlockHash() const { return blockHash; }
+    const CBlockHeader &GetHeader() const { return header; }
+
+private:
+    CBlockHeader header;
+    uint256 blockHash;
+    uint64_t k0 = 0;
+    uint64_t k1 = 0;
+    std::vector<std::shared_ptr<CBaseTx>> txs;
+    std::vector<uint256> txids;    // the txids of the available txs placed in the slots
+    std::vector<bool> collisions;  // the slots matched by more than one available tx
+    std::unordered_map<uint64_t, uint32_t> shortTxIdIndexes;
+    uint32_t missingCount = 0;
+};
+
+#endif  // P2P_COMPACTBLOCK_H
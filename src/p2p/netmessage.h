@@ -9,6 +9,16 @@
 #include "commons/serialize.h"
 #include "p2p/protocol.h"
 
+#include <memory>
+
+class CBaseTx;
+
+// results of the parallel precheck of a complete message, see PrecheckMessages()
+struct CNetMessagePrecheck {
+    bool fChecksumOk = false;
+    std::shared_ptr<CBaseTx> pTx;  // the decoded tx of a tx message
+};
+
 class CNetMessage {
 public:
     bool in_data;  // parsing header (false) or data (true)
@@ -20,11 +30,14 @@ public:
     CDataStream vRecv;  // received message data
     uint32_t nDataPos;
 
+    // shared with the precheck of a copy of the message, which may outlive the message
+    std::shared_ptr<CNetMessagePrecheck> spPrecheck;
+
     CNetMessage(int32_t nTypeIn, int32_t nVersionIn) : hdrbuf(nTypeIn, nVersionIn), vRecv(nTypeIn, nVersionIn) {
         hdrbuf.resize(24);
-        in_data  = false;
-        nHdrPos  = 0;
-        nDataPos = 0;
+        in_data     = false;
+        nHdrPos     = 0;
+        nDataPos    = 0;
     }
 
     bool complete() const {
@@ -19,6 +19,7 @@
 #include "p2p/netmessage.h"
 
 class CNode;
+class CPartialBlock;
 struct CNodeSignals;
 struct CNodeState;
 
@@ -49,6 +50,7 @@ struct LocalServiceInfo {
 // Signals for message handling
 struct CNodeSignals {
     boost::signals2::signal<int32_t()> GetHeight;
+    boost::signals2::signal<void(const vector<CNode*>&)> PrecheckMessages;
     boost::signals2::signal<bool(CNode*)> ProcessMessages;
     boost::signals2::signal<bool(CNode*, bool)> SendMessages;
     boost::signals2::signal<void(NodeId, const CNode*)> InitializeNode;
@@ -157,6 +159,8 @@ public:
     // b) the peer may tell us in their version message that we should not relay tx invs
     //    until they have initialized their bloom filter.
     bool fRelayTxes;
+    // the peer sent a sendcmpct, the blocks are sent to and asked from it as compact blocks
+    bool fCmpctBlocks;
     CSemaphoreGrant grantOutbound;
     CCriticalSection cs_filter;
     CBloomFilter* pFilter;
@@ -200,6 +204,9 @@ public:
     mruset<CBlockFinalityMessage> setBlockFinalityMsgKnown;
     CCriticalSection cs_blockFinality;
 
+    // the compact block from the peer waiting for its blocktxn, only touched by the message handler thread
+    std::shared_ptr<CPartialBlock> pPartialBlock;
+
     // Ping time measurement
     uint64_t nPingNonceSent;
     int64_t nPingUsecStart;
@@ -237,6 +244,7 @@ public:
         fStartSync               = false;
         fGetAddr                 = false;
         fRelayTxes               = false;
+        fCmpctBlocks             = false;
         setInventoryKnown.max_size(SendBufferSize() / 1000);
         auto maxPbftMsgSize = MaxPbftMsgSize();
         setBlockConfirmMsgKnown.max_size(maxPbftMsgSize);
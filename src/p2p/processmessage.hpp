@@ -7,8 +7,9 @@
 #define PROCESSMESSAGE_HPP
 
 #include "main.h"
+#include "commons/workerpool.h"
 
-bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv) {
+bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv, std::shared_ptr<CBaseTx> pTx) {
     LogPrint(BCLog::NET, "received: %s (%u bytes) from peer %s\n", strCommand, vRecv.size(), pFrom->addr.ToString());
     // RandAddSeedPerfmon();
     // if (GetRand(atoi(SysCfg().GetArg("-dropmessagestest", "0"))) == 0) {
@@ -59,7 +60,7 @@ bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv)
     }
 
     else if (strCommand == NetMsgType::TX) {
-        if (!ProcessTxMessage(pFrom, strCommand, vRecv))
+        if (!ProcessTxMessage(pFrom, strCommand, vRecv, pTx))
             return false;
     }
 
@@ -69,6 +70,24 @@ bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv)
         ProcessBlockMessage(pFrom, vRecv);
     }
 
+    else if (strCommand == NetMsgType::SENDCMPCT) {
+        ProcessSendCmpctMessage(pFrom, vRecv);
+    }
+
+    else if (strCommand == NetMsgType::CMPCTBLOCK && !SysCfg().IsImporting() && !SysCfg().IsReindex()) {
+        if (!ProcessCmpctBlockMessage(pFrom, vRecv))
+            return false;
+    }
+
+    else if (strCommand == NetMsgType::GETBLOCKTXN) {
+        if (!ProcessGetBlockTxnMessage(pFrom, vRecv))
+            return false;
+    }
+
+    else if (strCommand == NetMsgType::BLOCKTXN && !SysCfg().IsImporting() && !SysCfg().IsReindex()) {
+        ProcessBlockTxnMessage(pFrom, vRecv);
+    }
+
     else if (strCommand == NetMsgType::GETADDR) {
         pFrom->vAddrToSend.clear();
         vector<CAddress> vAddr = addrman.GetAddr();
@@ -148,6 +167,101 @@ bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv)
     return true;
 }
 
+static bool VerifyMessageChecksum(const CMessageHeader &hdr, const CDataStream &vRecv) {
+    uint256 hash       = Hash(vRecv.begin(), vRecv.begin() + hdr.nMessageSize);
+    uint32_t nChecksum = 0;
+    memcpy(&nChecksum, &hash, sizeof(nChecksum));
+    return nChecksum == hdr.nChecksum;
+}
+
+// a complete message copied out of the receive queue of its node
+struct CMessageSnapshot {
+    CMessageHeader hdr;
+    CDataStream vRecv;
+    std::shared_ptr<CNetMessagePrecheck> spPrecheck;
+
+    explicit CMessageSnapshot(const CNetMessage &msg)
+        : hdr(msg.hdr), vRecv(msg.vRecv), spPrecheck(msg.spPrecheck) {}
+};
+
+static void PrecheckMessage(CMessageSnapshot &snapshot) {
+    CNetMessagePrecheck &precheck = *snapshot.spPrecheck;
+    precheck.fChecksumOk = VerifyMessageChecksum(snapshot.hdr, snapshot.vRecv);
+    if (!precheck.fChecksumOk || !snapshot.hdr.IsValid() || snapshot.hdr.GetCommand() != NetMsgType::TX)
+        return;
+
+    // a malformed tx is decoded again from the message and rejected by ProcessTxMessage()
+    try {
+        snapshot.vRecv >> precheck.pTx;
+    } catch (...) {
+        precheck.pTx = nullptr;
+    }
+}
+
+/**
+ * Precheck the complete messages of the nodes on the signature checking threads before the message handler
+ * processes them one by one: verify the checksums, decode the txs and verify their signatures into
+ * signatureCache. The messages stay in the receive queues of their nodes, so every node's messages are still
+ * processed in order, and only the state changing part of ProcessMessage() is left to the handler thread.
+ */
+void PrecheckMessages(const vector<CNode *> &vNodes) {
+    CWorkerPool *pPool = GetSigCheckPool();
+    if (pPool == nullptr || pPool->GetWorkerCount() == 0)
+        return;
+
+    // copy the messages under the lock of each receive queue, so the socket thread is only held for the copy
+    vector<CMessageSnapshot> vSnapshots;
+    for (auto pNode : vNodes) {
+        // the messages are decoded with the version settled by the handshake
+        if (pNode->fDisconnect || !pNode->fSuccessfullyConnected || pNode->nRecvVersion == INIT_PROTO_VERSION)
+            continue;
+
+        TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
+        if (!lockRecv)
+            continue;
+
+        for (auto &msg : pNode->vRecvMsg) {
+            if (!msg.complete())
+                break;
+            if (!msg.spPrecheck) {
+                msg.spPrecheck = std::make_shared<CNetMessagePrecheck>();
+                vSnapshots.emplace_back(msg);
+            }
+        }
+    }
+    if (vSnapshots.empty())
+        return;
+
+    // the results are only read by ProcessMessages() on this thread once the precheck is done
+    pPool->ParallelFor(vSnapshots.size(), [&vSnapshots](size_t index) { PrecheckMessage(vSnapshots[index]); });
+
+    vector<std::shared_ptr<CBaseTx>> vTxs;
+    for (const auto &snapshot : vSnapshots) {
+        const auto &pTx = snapshot.spPrecheck->pTx;
+        if (pTx && !pTx->IsRelayForbidden())
+            vTxs.push_back(pTx);
+    }
+    vSnapshots.clear();
+
+    if (vTxs.empty())
+        return;
+
+    // collect the signatures against the mempool state like AcceptToMemoryPool(), then verify them unlocked
+    vector<CSignatureCheck> checks;
+    {
+        LOCK(cs_main);
+        if (IsInitialBlockDownload())
+            return;
+
+        int32_t height = chainActive.Height() + 1;
+        for (const auto &pTx : vTxs) {
+            if (!mempool.Exists(pTx->GetHash()))
+                pTx->GetSignatureChecks(*mempool.cw, height, checks);
+        }
+    }
+    PreVerifySignatures(checks);
+}
+
 // requires LOCK(cs_vRecvMsg)
 bool ProcessMessages(CNode *pFrom) {
     //if (fDebug)
@@ -211,21 +325,19 @@ bool ProcessMessages(CNode *pFrom) {
         // Message size
         uint32_t nMessageSize = hdr.nMessageSize;
 
-        // Checksum
+        // Checksum, verified by the precheck if done
         CDataStream &vRecv = msg.vRecv;
-        uint256 hash       = Hash(vRecv.begin(), vRecv.begin() + nMessageSize);
-        uint32_t nChecksum = 0;
-        memcpy(&nChecksum, &hash, sizeof(nChecksum));
-        if (nChecksum != hdr.nChecksum) {
-            LogPrint(BCLog::INFO, "(%s, %u bytes) : CHECKSUM ERROR nChecksum=%08x hdr.nChecksum=%08x\n",
-                     strCommand, nMessageSize, nChecksum, hdr.nChecksum);
+        bool fChecksumOk   = msg.spPrecheck ? msg.spPrecheck->fChecksumOk : VerifyMessageChecksum(hdr, vRecv);
+        if (!fChecksumOk) {
+            LogPrint(BCLog::INFO, "(%s, %u bytes) : CHECKSUM ERROR hdr.nChecksum=%08x\n",
+                     strCommand, nMessageSize, hdr.nChecksum);
             continue;
         }
 
         // Process message
         bool fRet = false;
         try {
-            fRet = ProcessMessage(pFrom, strCommand, vRecv);
+            fRet = ProcessMessage(pFrom, strCommand, vRecv, msg.spPrecheck ? msg.spPrecheck->pTx : nullptr);
             boost::this_thread::interruption_point();
         } catch (std::ios_base::failure &e) {
             pFrom->PushMessage(NetMsgType::REJECT, strCommand, REJECT_MALFORMED, string("error parsing message"));
@@ -388,6 +388,9 @@ enum
     // Nodes may always request a MSG_FILTERED_BLOCK in a getdata, however,
     // MSG_FILTERED_BLOCK should not appear in any invs except as a part of getdata.
     MSG_FILTERED_BLOCK,
+    // Requested in a getdata from the peers sent "sendcmpct", answered with a "cmpctblock" for the recent blocks
+    // and a "block" for the others. It should not appear in any invs.
+    MSG_CMPCT_BLOCK,
 };
 
 #endif // __INCLUDED_PROTOCOL_H__
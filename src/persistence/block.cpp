@@ -161,6 +161,17 @@ bool WriteBlockToDisk(CBlock &block, CDiskBlockPos &pos) {
 bool ReadBlockFromDisk(const CDiskBlockPos &pos, CBlock &block) {
     block.SetNull();
 
+    CBlockFileSpan span = blockFileMapper.GetBlockSpan(pos);
+    if (!span.IsNull()) {
+        try {
+            CBlockFileReader reader(span, SER_DISK, CLIENT_VERSION);
+            reader >> block;
+        } catch (std::exception &e) {
+            return ERRORMSG("Deserialize or I/O error - %s", e.what());
+        }
+        return true;
+    }
+
     // Open history file to read
     CAutoFile filein = CAutoFile(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
     if (!filein)
@@ -186,6 +197,30 @@ bool ReadBlockFromDisk(const CBlockIndex *pIndex, CBlock &block) {
     return true;
 }
 
+bool ReadRawBlockFromDisk(const CDiskBlockPos &pos, std::vector<char> &data) {
+    if (pos.IsNull() || pos.nPos < 4)
+        return ERRORMSG("ReadRawBlockFromDisk : invalid block pos %s", pos.ToString());
+
+    // Open history file at the size of the block
+    CAutoFile filein = CAutoFile(OpenBlockFile(CDiskBlockPos(pos.nFile, pos.nPos - 4), true), SER_DISK, CLIENT_VERSION);
+    if (!filein)
+        return ERRORMSG("ReadRawBlockFromDisk : OpenBlockFile failed");
+
+    try {
+        uint32_t nSize;
+        filein >> nSize;
+        if (nSize > MAX_BLOCK_SIZE)
+            return ERRORMSG("ReadRawBlockFromDisk : invalid block size %u at %s", nSize, pos.ToString());
+
+        data.resize(nSize);
+        filein.read(data.data(), nSize);
+    } catch (std::exception &e) {
+        return ERRORMSG("Deserialize or I/O error - %s", e.what());
+    }
+
+    return true;
+}
+
 bool ReadBaseTxFromDisk(const CTxCord txCord, std::shared_ptr<CBaseTx> &pTx) {
     auto pBlock = std::make_shared<CBlock>();
     const CBlockIndex* pBlockIndex = chainActive[ txCord.GetHeight() ];
@@ -202,6 +237,33 @@ bool ReadBaseTxFromDisk(const CTxCord txCord, std::shared_ptr<CBaseTx> &pTx) {
     return true;
 }
 
+bool ReadBaseTxFromDisk(const CDiskTxPos &pos, CBlockHeader &header, std::shared_ptr<CBaseTx> &pTx) {
+    CBlockFileSpan span = blockFileMapper.GetBlockSpan(pos);
+    try {
+        if (!span.IsNull()) {
+            CBlockFileReader reader(span, SER_DISK, CLIENT_VERSION);
+            reader >> header;
+            reader.Skip(pos.nTxOffset);
+            reader >> pTx;
+        } else {
+            CAutoFile file(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+            if (!file)
+                return ERRORMSG("ReadBaseTxFromDisk : OpenBlockFile failed");
+
+            file >> header;
+            fseek(file, pos.nTxOffset, SEEK_CUR);
+            file >> pTx;
+        }
+    } catch (std::exception &e) {
+        return ERRORMSG("Deserialize or I/O error - %s", e.what());
+    }
+
+    if (!pTx)
+        return ERRORMSG("ReadBaseTxFromDisk : null tx at %s", pos.ToString());
+
+    return true;
+}
+
 bool GetBlockHeader(CBlockIndex *pBlockIndex, CBlockHeader &header) {
     // TODO: need to use map pool of block header?
     CDiskBlockIndex diskBlockIndex;
@@ -210,4 +272,109 @@ bool GetBlockHeader(CBlockIndex *pBlockIndex, CBlockHeader &header) {
     }
     diskBlockIndex.GetBlockHeader(header);
     return true;
-}
\ No newline at end of file
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// class CRecentBlockCache
+
+CRecentBlockCache recentBlockCache;
+
+// estimated memory of a deserialized tx besides its serialized bytes: the object of its tx type, the shared_ptr
+// control block and the allocator overhead of its members
+static const uint64_t RECENT_BLOCK_TX_OVERHEAD = 512;
+
+// estimated memory of a deserialized block, the serialized size alone misses most of the object overhead of the
+// many small txs
+static uint64_t GetBlockMemUsage(const CBlock &block) {
+    uint64_t usage = sizeof(CBlock) + block.GetSignature().capacity() + block.vMerkleTree.capacity() * sizeof(uint256) +
+                     block.vptx.capacity() * sizeof(std::shared_ptr<CBaseTx>);
+    for (const auto &spTx : block.vptx)
+        usage += ::GetSerializeSize(spTx, SER_DISK, CLIENT_VERSION) + RECENT_BLOCK_TX_OVERHEAD;
+    return usage;
+}
+
+void CRecentBlockCache::Setup(uint64_t maxBytesIn, int32_t windowSizeIn) {
+    std::unique_lock<std::mutex> lock(mtx);
+    blocks.clear();
+    heightIndex.clear();
+    totalBytes = 0;
+    maxBytes   = maxBytesIn;
+    windowSize = windowSizeIn;
+}
+
+void CRecentBlockCache::Add(const CBlockIndex *pIndex, const CBlock &block) {
+    uint64_t size = GetBlockMemUsage(block);
+
+    std::unique_lock<std::mutex> lock(mtx);
+    if (size > maxBytes || blocks.count(pIndex->GetBlockHash()))
+        return;
+
+    auto spBlock = std::make_shared<CBlock>(block);
+    for (auto &spTx : spBlock->vptx) {
+        spTx = spTx->GetNewInstance();
+    }
+
+    // the blocks falling out of the window will not be looked back at by the later blocks
+    while (!heightIndex.empty() && heightIndex.begin()->first + windowSize < pIndex->height) {
+        EraseEntry(blocks.find(heightIndex.begin()->second));
+    }
+    while (!heightIndex.empty() && totalBytes + size > maxBytes) {
+        EraseEntry(blocks.find(heightIndex.begin()->second));
+    }
+
+    Entry &entry  = blocks[pIndex->GetBlockHash()];
+    entry.spBlock = spBlock;
+    entry.height  = pIndex->height;
+    entry.size    = size;
+    heightIndex.emplace(pIndex->height, pIndex->GetBlockHash());
+    totalBytes += size;
+}
+
+void CRecentBlockCache::Erase(const uint256 &blockHash) {
+    std::unique_lock<std::mutex> lock(mtx);
+    auto it = blocks.find(blockHash);
+    if (it != blocks.end())
+        EraseEntry(it);
+}
+
+std::shared_ptr<const CBlock> CRecentBlockCache::Get(const uint256 &blockHash) {
+    std::unique_lock<std::mutex> lock(mtx);
+    auto it = blocks.find(blockHash);
+    if (it == blocks.end()) {
+        misses++;
+        return nullptr;
+    }
+
+    hits++;
+    return it->second.spBlock;
+}
+
+CRecentBlockCache::Stats CRecentBlockCache::GetStats() {
+    std::unique_lock<std::mutex> lock(mtx);
+    Stats stats;
+    stats.count    = blocks.size();
+    stats.bytes    = totalBytes;
+    stats.maxBytes = maxBytes;
+    stats.hits     = hits;
+    stats.misses   = misses;
+    return stats;
+}
+
+void CRecentBlockCache::EraseEntry(std::map<uint256, Entry>::iterator it) {
+    heightIndex.erase(make_pair(it->second.height, it->first));
+    totalBytes -= it->second.size;
+    blocks.erase(it);
+}
+
+bool ReadRecentBlock(const CBlockIndex *pIndex, std::shared_ptr<const CBlock> &spBlock) {
+    spBlock = recentBlockCache.Get(pIndex->GetBlockHash());
+    if (spBlock)
+        return true;
+
+    auto spNewBlock = std::make_shared<CBlock>();
+    if (!ReadBlockFromDisk(pIndex, *spNewBlock))
+        return false;
+
+    spBlock = spNewBlock;
+    return true;
+}
@@ -22,7 +22,10 @@
 
 
 #include <stdint.h>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 
 class CBlockDBCache;
 class CDiskBlockPos;
@@ -451,9 +454,13 @@ struct CBlockLocator {
 bool WriteBlockToDisk(CBlock &block, CDiskBlockPos &pos);
 bool ReadBlockFromDisk(const CDiskBlockPos &pos, CBlock &block);
 bool ReadBlockFromDisk(const CBlockIndex *pIndex, CBlock &block);
+/** Read the serialized block at pos as it is stored, for relaying it without deserializing */
+bool ReadRawBlockFromDisk(const CDiskBlockPos &pos, std::vector<char> &data);
 
 
 bool ReadBaseTxFromDisk(const CTxCord txCord, std::shared_ptr<CBaseTx> &pTx);
+/** Read the tx at the tx index position and the header of its block, without reading the other txs */
+bool ReadBaseTxFromDisk(const CDiskTxPos &pos, CBlockHeader &header, std::shared_ptr<CBaseTx> &pTx);
 
 template<typename TxType>
 bool ReadTxFromDisk(const CTxCord txCord, std::shared_ptr<TxType> &pTx) {
@@ -472,4 +479,58 @@ bool ReadTxFromDisk(const CTxCord txCord, std::shared_ptr<TxType> &pTx) {
 
 bool GetBlockHeader(CBlockIndex *pBlockIndex, CBlockHeader &header);
 
+/**
+ * Deserialized blocks of the recent active chain, so that connecting a block reads the blocks it looks back at
+ * from memory: the mature block reward BLOCK_REWARD_MATURITY back and the tx cache eviction GetTxCacheHeight()
+ * back. The blocks falling out of that window below the newest added one are dropped, and the oldest ones go
+ * first when the estimated memory of the cached blocks exceeds the budget.
+ *
+ * The cached blocks are shared, the callers must not change them, copy the txs to execute them.
+ */
+class CRecentBlockCache {
+public:
+    struct Stats {
+        uint64_t count    = 0;
+        uint64_t bytes    = 0;
+        uint64_t maxBytes = 0;
+        uint64_t hits     = 0;
+        uint64_t misses   = 0;
+    };
+
+public:
+    // Reset the cache with the memory budget of maxBytes and the look-back window of windowSize blocks
+    void Setup(uint64_t maxBytes, int32_t windowSize);
+
+    // Add a copy of the block, taken before its txs are executed
+    void Add(const CBlockIndex *pIndex, const CBlock &block);
+    void Erase(const uint256 &blockHash);
+    std::shared_ptr<const CBlock> Get(const uint256 &blockHash);
+
+    Stats GetStats();
+
+private:
+    struct Entry {
+        std::shared_ptr<const CBlock> spBlock;
+        int32_t height = 0;
+        uint64_t size  = 0;  // estimated memory of the block
+    };
+
+    void EraseEntry(std::map<uint256, Entry>::iterator it);
+
+private:
+    std::mutex mtx;
+    std::map<uint256, Entry> blocks;
+    std::set<std::pair<int32_t, uint256>> heightIndex;  // eviction order, the lowest first
+    uint64_t totalBytes = 0;
+    uint64_t maxBytes   = 0;
+    int32_t windowSize  = 0;
+    uint64_t hits       = 0;
+    uint64_t misses     = 0;
+};
+
+extern CRecentBlockCache recentBlockCache;
+
+/** Get the block from recentBlockCache, or read it from disk on a miss */
+bool ReadRecentBlock(const CBlockIndex *pIndex, std::shared_ptr<const CBlock> &spBlock);
+
 #endif  // PERSIST_BLOCK_H
\ No newline at end of file
@@ -161,10 +161,124 @@ UndoDataFuncMap CCacheWrapper::GetUndoDataFuncMap() {
     return undoDataFuncMap;
 }
 
+bool CCacheWrapper::ApplyRedoLogs(const CDBOpLogMap &dbOpLogMap) {
+    UndoDataFuncMap undoDataFuncMap = GetUndoDataFuncMap();
+    for (const auto &redoLogPair : dbOpLogMap.GetRedoMap()) {
+        dbk::PrefixType prefixType = dbk::ParseKeyPrefixType(redoLogPair.first);
+        auto funcMapIt = undoDataFuncMap.find(prefixType);
+        if (funcMapIt == undoDataFuncMap.end())
+            return ERRORMSG("%s(), unfound prefix in db! prefix_type=%s", __FUNCTION__, redoLogPair.first);
+
+        // the undo functions apply the logs backwards, reverse them so that the latest value of a key wins
+        funcMapIt->second(CDbOpLogs(redoLogPair.second.rbegin(), redoLogPair.second.rend()));
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class CMemCacheSnapshot
+
+// the memory-only caches at the best block of the chain state
+struct CMemCacheSnapshot {
+    uint256 best_block_hash;
+    int32_t tx_cache_height = 0;
+    uint64_t slide_window   = 0;
+    CTxMemCache::BlockTxIdsMap tx_blocks;
+    map<PriceCoinPair, BlockUserPriceMap> prices;
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(best_block_hash);
+        READWRITE(tx_cache_height);
+        READWRITE(VARINT(slide_window));
+        READWRITE(tx_blocks);
+        READWRITE(prices);
+    )
+};
+
+static boost::filesystem::path GetMemCacheSnapshotPath() {
+    return GetDataDir() / "memcaches.dat";
+}
+
+static bool WriteMemCacheSnapshot(const CMemCacheSnapshot &snapshot) {
+    int64_t beginTime = GetTimeMillis();
+    // serialize the snapshot, checksum data up to that point, then append csum
+    CDataStream ssSnapshot(SER_DISK, CLIENT_VERSION);
+    ssSnapshot << FLATDATA(SysCfg().MessageStart());
+    ssSnapshot << snapshot;
+    uint256 hash = Hash(ssSnapshot.begin(), ssSnapshot.end());
+    ssSnapshot << hash;
+
+    boost::filesystem::path path    = GetMemCacheSnapshotPath();
+    boost::filesystem::path pathTmp = path.string() + ".new";
+    FILE *file                      = fopen(pathTmp.string().c_str(), "wb");
+    CAutoFile fileout               = CAutoFile(file, SER_DISK, CLIENT_VERSION);
+    if (!fileout)
+        return ERRORMSG("Failed to open file %s", pathTmp.string());
+
+    try {
+        fileout << ssSnapshot;
+    } catch (std::exception &e) {
+        return ERRORMSG("Serialize or I/O error - %s", e.what());
+    }
+    FileCommit(fileout);
+    fileout.fclose();
+
+    if (!RenameOver(pathTmp, path))
+        return ERRORMSG("Rename-into-path failed");
+
+    LogPrint(BCLog::BENCHMARK, "wrote the memory cache snapshot at %s: %u tx blocks, %u bytes, %lld ms\n",
+             snapshot.best_block_hash.ToString(), snapshot.tx_blocks.size(), ssSnapshot.size(),
+             GetTimeMillis() - beginTime);
+    return true;
+}
+
+static bool ReadMemCacheSnapshot(CMemCacheSnapshot &snapshot) {
+    boost::filesystem::path path = GetMemCacheSnapshotPath();
+    if (!boost::filesystem::exists(path))
+        return false;
+
+    FILE *file       = fopen(path.string().c_str(), "rb");
+    CAutoFile filein = CAutoFile(file, SER_DISK, CLIENT_VERSION);
+    if (!filein)
+        return ERRORMSG("Failed to open file %s", path.string());
+
+    int64_t dataSize = (int64_t)boost::filesystem::file_size(path) - sizeof(uint256);
+    if (dataSize < 0)
+        return ERRORMSG("Invalid file size of %s", path.string());
+
+    vector<uint8_t> vchData(dataSize);
+    uint256 hashIn;
+    try {
+        filein.read((char *)vchData.data(), dataSize);
+        filein >> hashIn;
+    } catch (std::exception &e) {
+        return ERRORMSG("Deserialize or I/O error - %s", e.what());
+    }
+    filein.fclose();
+
+    CDataStream ssSnapshot(vchData, SER_DISK, CLIENT_VERSION);
+    if (hashIn != Hash(ssSnapshot.begin(), ssSnapshot.end()))
+        return ERRORMSG("Checksum mismatch of %s, data corrupted", path.string());
+
+    uint8_t pchMsgTmp[4];
+    try {
+        ssSnapshot >> FLATDATA(pchMsgTmp);
+        if (memcmp(pchMsgTmp, SysCfg().MessageStart(), sizeof(pchMsgTmp)))
+            return ERRORMSG("Invalid network magic number of %s", path.string());
+
+        ssSnapshot >> snapshot;
+    } catch (std::exception &e) {
+        return ERRORMSG("Deserialize or I/O error - %s", e.what());
+    }
+    return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CCacheDBManager
 
 CCacheDBManager::CCacheDBManager(bool isReindex, bool isMemory): is_reindex(isReindex), is_memory(isMemory) {
+    is_single_store = SysCfg().GetBoolArg("-singlestatedb", false);
+    OpenStateStore();
 
     pSysParamDb     = CreateDbAccess(DBNameType::SYSPARAM);
     pSysParamCache  = new CSysParamDBCache(pSysParamDb);
@@ -221,6 +335,8 @@ CCacheDBManager::CCacheDBManager(bool isReindex, bool isMemory): is_reindex(isRe
 }
 
 CCacheDBManager::~CCacheDBManager() {
+    WaitForFlush();
+
     delete pSysParamCache;  pSysParamCache = nullptr;
     delete pAccountCache;   pAccountCache = nullptr;
     delete pAssetCache;     pAssetCache = nullptr;
@@ -259,6 +375,238 @@ CCacheDBManager::~CCacheDBManager() {
 }
 
 bool CCacheDBManager::Flush() {
+    // the db misses the frozen data of a failed background flush, the caches must not be written over it
+    if (!WaitForFlush())
+        return ERRORMSG("the background flush of the chain state failed, refuse to write the caches");
+
+    // in the single store mode the caches write into one batch, committed at the end with one synced write
+    CLevelDBBatch stateBatch;
+    if (spStateDb) {
+        for (auto pDbAccess : dbAccesses)
+            pDbAccess->SetPendingBatch(&stateBatch);
+    }
+
+    try {
+        FlushCaches();
+    } catch (...) {
+        for (auto pDbAccess : dbAccesses)
+            pDbAccess->SetPendingBatch(nullptr);
+        throw;
+    }
+
+    if (spStateDb) {
+        for (auto pDbAccess : dbAccesses)
+            pDbAccess->SetPendingBatch(nullptr);
+        spStateDb->WriteBatch(stateBatch, true);
+    }
+
+    if (memCachesLoaded && !is_memory)
+        WriteMemCacheSnapshot(*TakeMemCacheSnapshot());
+
+    return true;
+}
+
+bool CCacheDBManager::FlushAsync() {
+    if (!WaitForFlush())
+        return false;
+
+    std::vector<std::vector<DbFlushJob>> jobGroups(dbAccesses.size());
+    for (size_t i = 0; i < dbAccesses.size(); i++)
+        dbAccesses[i]->BeginBackgroundFlush(&jobGroups[i]);
+
+    try {
+        FlushCaches();
+    } catch (...) {
+        for (auto pDbAccess : dbAccesses) {
+            pDbAccess->SetFlushJobs(nullptr);
+            pDbAccess->EndBackgroundFlush();
+        }
+        throw;
+    }
+
+    for (auto pDbAccess : dbAccesses)
+        pDbAccess->SetFlushJobs(nullptr);
+
+    // the memory-only caches are written now and then with the chain state, see LoadMemCaches()
+    std::shared_ptr<CMemCacheSnapshot> spSnapshot;
+    if (memCachesLoaded && !is_memory && GetTime() >= lastSnapshotTime + MEM_CACHE_SNAPSHOT_INTERVAL) {
+        spSnapshot       = TakeMemCacheSnapshot();
+        lastSnapshotTime = GetTime();
+    }
+
+    flushThread = std::thread(&CCacheDBManager::WriteFrozen, this, std::move(jobGroups), spSnapshot);
+    return true;
+}
+
+bool CCacheDBManager::WaitForFlush() {
+    if (flushThread.joinable())
+        flushThread.join();
+
+    return !flushFailed;
+}
+
+void CCacheDBManager::SetSharedRead(bool sharedRead) {
+    for (auto pDbAccess : dbAccesses)
+        pDbAccess->SetSharedRead(sharedRead);
+}
+
+void CCacheDBManager::WriteFrozen(std::vector<std::vector<DbFlushJob>> jobGroups,
+                                  std::shared_ptr<CMemCacheSnapshot> spSnapshot) {
+    RenameThread("coin-dbflush");
+    int64_t beginTime = GetTimeMillis();
+
+    // serialize the db names in parallel, each into its own batch
+    std::vector<CLevelDBBatch> batches(jobGroups.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < jobGroups.size(); i++) {
+        if (jobGroups[i].empty())
+            continue;
+
+        threads.emplace_back([&, i]() {
+            try {
+                for (auto &job : jobGroups[i])
+                    job(batches[i]);
+
+                if (!spStateDb)
+                    dbAccesses[i]->CommitBackgroundBatch(batches[i]);
+            } catch (std::exception &e) {
+                LogPrint(BCLog::ERROR, "background flush of %s failed: %s\n",
+                         ::GetDbName(dbAccesses[i]->GetDbNameType()), e.what());
+                flushFailed = true;
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    if (spStateDb && !flushFailed) {
+        try {
+            CLevelDBBatch stateBatch;
+            for (size_t i = 0; i < batches.size(); i++) {
+                if (!jobGroups[i].empty())
+                    stateBatch.Append(batches[i]);
+            }
+            spStateDb->WriteBatch(stateBatch, true);
+        } catch (std::exception &e) {
+            LogPrint(BCLog::ERROR, "background flush of %s failed: %s\n", STATE_DB_NAME, e.what());
+            flushFailed = true;
+        }
+    }
+
+    LogPrint(BCLog::BENCHMARK, "background flush of the chain state: %lld ms%s\n", GetTimeMillis() - beginTime,
+             flushFailed ? ", failed" : "");
+
+    if (flushFailed) {
+        // the caches keep reading the frozen data, it is not in the db. Stop before a block is connected on it
+        for (auto pDbAccess : dbAccesses)
+            pDbAccess->FailBackgroundFlush();
+        AbortNode(_("Error: failed to write chain state"));
+        return;
+    }
+
+    for (auto pDbAccess : dbAccesses)
+        pDbAccess->EndBackgroundFlush();
+
+    // the snapshot must not be ahead of the chain state, it is dropped if the chain state is not written
+    if (spSnapshot)
+        WriteMemCacheSnapshot(*spSnapshot);
+}
+
+std::shared_ptr<CMemCacheSnapshot> CCacheDBManager::TakeMemCacheSnapshot() {
+    auto spSnapshot             = std::make_shared<CMemCacheSnapshot>();
+    spSnapshot->best_block_hash = pBlockCache->GetBestBlockHash();
+    spSnapshot->tx_cache_height = SysCfg().GetTxCacheHeight();
+    pSysParamCache->GetParam(SysParamType::MEDIAN_PRICE_SLIDE_WINDOW_BLOCKCOUNT, spSnapshot->slide_window);
+    spSnapshot->tx_blocks = pTxCache->GetSnapshot();
+    spSnapshot->prices    = pPpCache->GetSnapshot();
+    return spSnapshot;
+}
+
+bool CCacheDBManager::LoadMemCaches(CBlockIndex *pTipIndex) {
+    int64_t beginTime     = GetTimeMillis();
+    int32_t txCacheHeight = SysCfg().GetTxCacheHeight();
+    uint64_t slideWindow  = 0;
+    if (!pSysParamCache->GetParam(SysParamType::MEDIAN_PRICE_SLIDE_WINDOW_BLOCKCOUNT, slideWindow))
+        return ERRORMSG("read sys param MEDIAN_PRICE_SLIDE_WINDOW_BLOCKCOUNT error");
+
+    // the snapshot must be in the active chain, and replaying the blocks after it must read less than reloading
+    CMemCacheSnapshot snapshot;
+    CBlockIndex *pSnapshotIndex = nullptr;
+    if (pTipIndex != nullptr && !is_reindex && !is_memory && ReadMemCacheSnapshot(snapshot)) {
+        auto it = mapBlockIndex.find(snapshot.best_block_hash);
+        if (it != mapBlockIndex.end() && chainActive.Contains(it->second) &&
+            pTipIndex->height - it->second->height <= txCacheHeight &&
+            snapshot.tx_cache_height == txCacheHeight && snapshot.slide_window == slideWindow) {
+            pSnapshotIndex = it->second;
+        } else {
+            LogPrint(BCLog::INFO, "the memory cache snapshot at %s is not usable, reload the latest blocks\n",
+                     snapshot.best_block_hash.ToString());
+        }
+    }
+
+    if (pSnapshotIndex == nullptr) {
+        if (!ReloadMemCaches(pTipIndex))
+            return false;
+
+        memCachesLoaded = true;
+        return true;
+    }
+
+    pTxCache->LoadSnapshot(snapshot.tx_blocks);
+    pPpCache->LoadSnapshot(snapshot.prices);
+
+    vector<CBlockIndex *> replayIndexes;
+    for (CBlockIndex *pIndex = pTipIndex; pIndex != pSnapshotIndex; pIndex = pIndex->pprev)
+        replayIndexes.push_back(pIndex);
+
+    for (auto it = replayIndexes.rbegin(); it != replayIndexes.rend(); it++) {
+        CBlockIndex *pIndex = *it;
+        std::shared_ptr<const CBlock> spBlock;
+        if (!ReadRecentBlock(pIndex, spBlock))
+            return ERRORMSG("read block=[%d]%s failed", pIndex->height, pIndex->GetBlockHash().ToString());
+
+        // the same as connecting the block does
+        pTxCache->AddBlockTx(*spBlock);
+        if (pIndex->height > txCacheHeight)
+            pTxCache->RemoveBlockTx(pIndex->height - txCacheHeight);
+
+        if (!pPpCache->ReplayBlock(*pSysParamCache, pIndex, *spBlock))
+            return false;
+    }
+
+    LogPrint(BCLog::INFO, "Loaded the memory cache snapshot at [%d]%s and replayed %u blocks (%dms)\n",
+             pSnapshotIndex->height, pSnapshotIndex->GetBlockHash().ToString(), replayIndexes.size(),
+             GetTimeMillis() - beginTime);
+
+    memCachesLoaded = true;
+    return true;
+}
+
+bool CCacheDBManager::ReloadMemCaches(CBlockIndex *pTipIndex) {
+    int64_t nStart           = GetTimeMillis();
+    CBlockIndex *pBlockIndex = pTipIndex;
+    int32_t nCacheHeight     = SysCfg().GetTxCacheHeight();
+    int32_t nCount           = 0;
+    CBlock block;
+    while (pBlockIndex && nCacheHeight-- > 0) {
+        if (!ReadBlockFromDisk(pBlockIndex, block))
+            return ERRORMSG("Failed to read block from disk");
+
+        if (!pTxCache->AddBlockTx(block))
+            return ERRORMSG("Failed to add block to transaction memory cache");
+
+        pBlockIndex = pBlockIndex->pprev;
+        ++nCount;
+    }
+    LogPrint(BCLog::INFO, "Added the latest %d blocks to transaction memory cache (%dms)\n", nCount, GetTimeMillis() - nStart);
+
+    if (!pPpCache->ReleadBlocks(*pSysParamCache, pTipIndex))
+        return ERRORMSG("Init prices of PriceFeedMemCache failed");
+
+    return true;
+}
+
+void CCacheDBManager::FlushCaches() {
     if (pSysParamCache) pSysParamCache->Flush();
 
     if (pAccountCache) pAccountCache->Flush();
@@ -296,13 +644,59 @@ bool CCacheDBManager::Flush() {
     //     pTxCache->Flush();
     // if (pPpCache)
     //     pPpCache->Flush();
+}
 
-    return true;
+void CCacheDBManager::OpenStateStore() {
+    const boost::filesystem::path blocksDir = GetDataDir() / "blocks";
+    const boost::filesystem::path statePath = blocksDir / STATE_DB_NAME;
+
+    // the stores of the other mode must not be left behind, switching the mode rebuilds the state
+    if (!is_memory) {
+        vector<boost::filesystem::path> otherPaths;
+        if (is_single_store) {
+            for (int32_t i = 0; i < DBNameType::DB_NAME_COUNT; i++)
+                otherPaths.push_back(blocksDir / ::GetDbName((DBNameType)i));
+        } else {
+            otherPaths.push_back(statePath);
+        }
+
+        for (const auto &path : otherPaths) {
+            if (!boost::filesystem::exists(path))
+                continue;
+            if (!is_reindex)
+                throw runtime_error(strprintf("%s belongs to the other -singlestatedb mode, need to reindex",
+                                              path.string()));
+
+            LogPrint(BCLog::INFO, "Removing %s of the other -singlestatedb mode\n", path.string());
+            boost::filesystem::remove_all(path);
+        }
+    }
+
+    if (is_single_store) {
+        int64_t cacheSize = 0;
+        for (int32_t i = 0; i < DBNameType::DB_NAME_COUNT; i++)
+            cacheSize += GetDbCacheSize((DBNameType)i);
+
+        spStateDb = std::make_shared<CLevelDBWrapper>(statePath, std::min<int64_t>(cacheSize, MAX_DB_CACHE_SIZE),
+                                                      is_memory, is_reindex, GetDbProfile(STATE_DB_NAME, CDbProfile()));
+    }
 }
 
 CDBAccess* CCacheDBManager::CreateDbAccess(DBNameType dbNameTypeIn) {
+    CDBAccess *pDbAccess;
+    if (spStateDb) {
+        pDbAccess = new CDBAccess(dbNameTypeIn, spStateDb);
+    } else {
+        const boost::filesystem::path& path = GetDataDir() / "blocks" / ::GetDbName(dbNameTypeIn);
+        const string &dbName = ::GetDbName(dbNameTypeIn);
+        pDbAccess = new CDBAccess(dbNameTypeIn, path, GetDbCacheSize(dbNameTypeIn), is_memory, is_reindex,
+                                  GetDbProfile(dbName, kDbProfileMap.at(dbNameTypeIn)));
+    }
+    dbAccesses.push_back(pDbAccess);
+    return pDbAccess;
+}
 
-    const boost::filesystem::path& path = GetDataDir() / "blocks" / ::GetDbName(dbNameTypeIn);
+int64_t CCacheDBManager::GetDbCacheSize(DBNameType dbNameTypeIn) {
     uint32_t defaultCacheSize = kDBCacheSizeMap.at(dbNameTypeIn);
     // db cache config
     string configName = "-cache_size_" + ::GetDbName(dbNameTypeIn);
@@ -317,7 +711,49 @@ CDBAccess* CCacheDBManager::CreateDbAccess(DBNameType dbNameTypeIn) {
 
     }
 
-    return new CDBAccess(dbNameTypeIn, path, cacheSize, is_memory, is_reindex);
+    return cacheSize;
+}
+
+static uint32_t GetDbProfileArg(const string &configName, uint32_t defaultValue, uint32_t minValue,
+                                uint32_t maxValue) {
+    int64_t value = SysCfg().GetArg(configName, defaultValue);
+    if (value < minValue || value > maxValue) {
+        LogPrint(BCLog::ERROR, "%s=%d is out or range [%u, %u], use default value=%u instead\n",
+            configName, value, minValue, maxValue, defaultValue);
+        return defaultValue;
+    }
+    return value;
+}
+
+static CDbProfile ReadDbProfile(const string &dbName, const CDbProfile &defaultProfile) {
+    CDbProfile profile;
+    profile.bloom_bits        = GetDbProfileArg("-db_bloom_bits_" + dbName, defaultProfile.bloom_bits, 0, 64);
+    profile.block_size        = GetDbProfileArg("-db_block_size_" + dbName, defaultProfile.block_size,
+                                                (1 << 10), (4 << 20));
+    profile.max_open_files    = GetDbProfileArg("-db_max_open_files_" + dbName, defaultProfile.max_open_files,
+                                                64, 50000);
+    profile.write_buffer_size = GetDbProfileArg("-db_write_buffer_size_" + dbName, defaultProfile.write_buffer_size,
+                                                0, MAX_DB_CACHE_SIZE);
+    return profile;
+}
+
+CDbProfile CCacheDBManager::GetDbProfile(const string &dbName, const CDbProfile &defaultProfile) {
+    CDbProfile profile = ReadDbProfile(dbName, defaultProfile);
+    LogPrint(BCLog::INFO, "db profile of %s: bloom_bits=%u, block_size=%u, max_open_files=%u, "
+        "write_buffer_size=%u\n", dbName, profile.bloom_bits, profile.block_size, profile.max_open_files,
+        profile.write_buffer_size);
+    return profile;
+}
+
+uint32_t CCacheDBManager::GetMaxOpenDbFiles() {
+    // the block index store keeps the default profile
+    uint32_t files = CDbProfile().max_open_files;
+    if (SysCfg().GetBoolArg("-singlestatedb", false))
+        return files + ReadDbProfile(STATE_DB_NAME, CDbProfile()).max_open_files;
+
+    for (int32_t i = 0; i < DBNameType::DB_NAME_COUNT; i++)
+        files += ReadDbProfile(::GetDbName((DBNameType)i), kDbProfileMap.at((DBNameType)i)).max_open_files;
+    return files;
 }
 
 const CRegID&  GetBlockBpRegid(const CBlock &block) {
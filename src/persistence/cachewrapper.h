@@ -23,7 +23,11 @@
 #include "sysgoverndb.h"
 #include "logdb.h"
 
+#include <atomic>
+#include <thread>
+
 class CCacheDBManager;
+struct CMemCacheSnapshot;
 
 class CCacheWrapper {
 public:
@@ -61,6 +65,8 @@ public:
     void Flush();
 
     UndoDataFuncMap GetUndoDataFuncMap();
+    /** Set the new values recorded in the redo logs of dbOpLogMap to this cache */
+    bool ApplyRedoLogs(const CDBOpLogMap &dbOpLogMap);
 
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMap);
 
@@ -128,11 +134,50 @@ public:
     ~CCacheDBManager();
 
     bool Flush();
+    /**
+     * Freeze the data of the db level caches and write it on a background thread, the db names in parallel.
+     * Waits for the previous background flush first. Returns false if that one failed.
+     */
+    bool FlushAsync();
+    /** Wait for the background flush, returns false if it failed */
+    bool WaitForFlush();
+
+    const std::vector<CDBAccess*> &GetDbAccesses() const { return dbAccesses; }
+
+    /** Let the views of several threads read through the db level caches, see CDBAccess::SetSharedRead() */
+    void SetSharedRead(bool sharedRead);
+
+    /** The files the LevelDB stores may keep open with the configured db profiles */
+    static uint32_t GetMaxOpenDbFiles();
+
+    /**
+     * Load the memory-only caches at pTipIndex. They are restored from the snapshot written with the chain
+     * state, and the blocks connected after it are replayed. The latest blocks are read if no usable snapshot.
+     */
+    bool LoadMemCaches(CBlockIndex *pTipIndex);
 private:
+    void FlushCaches();
+    void WriteFrozen(std::vector<std::vector<DbFlushJob>> jobGroups, std::shared_ptr<CMemCacheSnapshot> spSnapshot);
+    std::shared_ptr<CMemCacheSnapshot> TakeMemCacheSnapshot();
+    bool ReloadMemCaches(CBlockIndex *pTipIndex);
+    void OpenStateStore();
     CDBAccess* CreateDbAccess(DBNameType dbNameTypeIn);
+    int64_t GetDbCacheSize(DBNameType dbNameTypeIn);
+    CDbProfile GetDbProfile(const std::string &dbName, const CDbProfile &defaultProfile);
 private:
     bool is_reindex = false;
     bool is_memory = false;
+    // -singlestatedb: all the db names are kept in spStateDb, and a flush commits them in one synced batch
+    bool is_single_store = false;
+    std::shared_ptr<CLevelDBWrapper> spStateDb;
+    std::vector<CDBAccess*> dbAccesses;
+
+    std::thread flushThread;
+    std::atomic<bool> flushFailed{false};
+
+    // the snapshot is only written once the memory caches are loaded
+    bool memCachesLoaded = false;
+    int64_t lastSnapshotTime = 0;
 };  // CCacheDBManager
 
 const CRegID& GetBlockBpRegid(const CBlock &block);
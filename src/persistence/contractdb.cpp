@@ -39,7 +39,10 @@ bool CContractDBCache::GetContract(const CRegID &contractRegId, CUniversalContra
 }
 
 bool CContractDBCache::SaveContract(const CRegID &contractRegId, const CUniversalContractStore &contractStore) {
-    return contractCache.SetData(CRegIDKey(contractRegId), contractStore);
+    CRegIDKey key(contractRegId);
+    EraseContractMeta(key);
+    changedContracts.insert(key);
+    return contractCache.SetData(key, contractStore);
 }
 
 bool CContractDBCache::HasContract(const CRegID &contractRegId) {
@@ -47,7 +50,76 @@ bool CContractDBCache::HasContract(const CRegID &contractRegId) {
 }
 
 bool CContractDBCache::EraseContract(const CRegID &contractRegId) {
-    return contractCache.EraseData(CRegIDKey(contractRegId));
+    CRegIDKey key(contractRegId);
+    EraseContractMeta(key);
+    changedContracts.insert(key);
+    return contractCache.EraseData(key);
+}
+
+CContractMetaPtr CContractDBCache::GetContractMeta(const CRegID &contractRegId) {
+    CRegIDKey key(contractRegId);
+    auto it = contractMetas.find(key);
+    if (it != contractMetas.end())
+        return it->second;
+
+    CContractMetaPtr spMeta;
+    if (pBase != nullptr && !metasReset && !changedContracts.count(key)) {
+        spMeta = pBase->GetContractMeta(contractRegId);
+    } else {
+        auto spNewMeta     = std::make_shared<CContractMeta>();
+        spNewMeta->spStore = contractCache.GetDataPtr(key);
+        if (spNewMeta->spStore) {
+            spNewMeta->exists     = true;
+            spNewMeta->vm_type    = spNewMeta->spStore->vm_type;
+            spNewMeta->maintainer = spNewMeta->spStore->maintainer;
+            spNewMeta->code_hash  = spNewMeta->spStore->code_hash;
+        }
+        spMeta = spNewMeta;
+    }
+
+    AddContractMeta(key, spMeta);
+    return spMeta;
+}
+
+static uint64_t GetContractMetaSize(const CContractMetaPtr &spMeta) {
+    return sizeof(CContractMeta) + (spMeta->spStore ? spMeta->spStore->GetContractSize() : 0);
+}
+
+void CContractDBCache::AddContractMeta(const CRegIDKey &key, const CContractMetaPtr &spMeta) {
+    // the metadata is only a shortcut to the contract cache, all of it is dropped when it grows too big
+    uint64_t size = GetContractMetaSize(spMeta);
+    if (contractMetasSize + size > MAX_CONTRACT_METAS_SIZE) {
+        contractMetas.clear();
+        contractMetasSize = 0;
+    }
+
+    if (contractMetas.emplace(key, spMeta).second)
+        contractMetasSize += size;
+}
+
+void CContractDBCache::EraseContractMeta(const CRegIDKey &key) {
+    auto it = contractMetas.find(key);
+    if (it != contractMetas.end()) {
+        contractMetasSize -= GetContractMetaSize(it->second);
+        contractMetas.erase(it);
+    }
+}
+
+void CContractDBCache::InvalidateContractMetas(const set<CRegIDKey> &contractKeys) {
+    for (const auto &key : contractKeys) {
+        EraseContractMeta(key);
+        // the root view has no base view to be stale
+        if (pBase != nullptr)
+            changedContracts.insert(key);
+    }
+}
+
+void CContractDBCache::ResetContractMetas() {
+    contractMetas.clear();
+    contractMetasSize = 0;
+    changedContracts.clear();
+    if (pBase != nullptr)
+        metasReset = true;
 }
 
 /************************ contract managed APP data ******************************/
@@ -81,6 +153,16 @@ bool CContractDBCache::SetContractTraces(const uint256 &txid, const string &cont
 }
 
 bool CContractDBCache::Flush() {
+    if (pBase != nullptr) {
+        if (metasReset)
+            pBase->ResetContractMetas();
+        else
+            pBase->InvalidateContractMetas(changedContracts);
+
+        changedContracts.clear();
+        metasReset = false;
+    }
+
     contractCache.Flush();
     contractDataCache.Flush();
     contractAccountCache.Flush();
@@ -92,7 +174,8 @@ bool CContractDBCache::Flush() {
 uint32_t CContractDBCache::GetCacheSize() const {
     return contractCache.GetCacheSize() +
         contractDataCache.GetCacheSize() +
-        contractTracesCache.GetCacheSize();
+        contractTracesCache.GetCacheSize() +
+        contractMetasSize;
 }
 
 shared_ptr<CDBContractDataIterator> CContractDBCache::CreateContractDataIterator(const CRegID &contractRegid,
@@ -17,6 +17,7 @@
 #include "vm/luavm/appaccount.h"
 
 #include <map>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -59,6 +60,18 @@ public:
     }
 };
 
+/** The contract metadata of the contract execution, it is shared by the views until the contract is changed */
+struct CContractMeta {
+    bool exists = false;
+    VMType vm_type = VMType::NULL_VM;
+    CRegID maintainer;
+    uint256 code_hash;
+    // the code and abi shared with the contract cache, not copied
+    std::shared_ptr<const CUniversalContractStore> spStore;
+};
+
+typedef std::shared_ptr<const CContractMeta> CContractMetaPtr;
+
 class CContractDBCache {
 public:
     CContractDBCache() {}
@@ -75,7 +88,8 @@ public:
         contractCache(pBaseIn->contractCache),
         contractDataCache(pBaseIn->contractDataCache),
         contractAccountCache(pBaseIn->contractAccountCache),
-        contractTracesCache(pBaseIn->contractTracesCache) {};
+        contractTracesCache(pBaseIn->contractTracesCache),
+        pBase(pBaseIn) {};
 
     bool GetContractAccount(const CRegID &contractRegId, const string &accountKey, CAppUserAccount &appAccOut);
     bool SetContractAccount(const CRegID &contractRegId, const CAppUserAccount &appAccIn);
@@ -84,6 +98,8 @@ public:
     bool SaveContract(const CRegID &contractRegId, const CUniversalContractStore &contractStore);
     bool HasContract(const CRegID &contractRegId);
     bool EraseContract(const CRegID &contractRegId);
+    // the metadata of the contract, never null, loaded once for all the views until the contract is changed
+    CContractMetaPtr GetContractMeta(const CRegID &contractRegId);
 
     bool GetContractData(const CRegID &contractRegId, const string &contractKey, string &contractData);
     bool SetContractData(const CRegID &contractRegId, const string &contractKey, const string &contractData);
@@ -97,6 +113,7 @@ public:
     uint32_t GetCacheSize() const;
 
     void SetBaseViewPtr(CContractDBCache *pBaseIn) {
+        pBase = pBaseIn;
         contractCache.SetBase(&pBaseIn->contractCache);
         contractDataCache.SetBase(&pBaseIn->contractDataCache);
         contractAccountCache.SetBase(&pBaseIn->contractAccountCache);
@@ -111,7 +128,11 @@ public:
     }
 
     void RegisterUndoFunc(UndoDataFuncMap &undoDataFuncMap) {
-        contractCache.RegisterUndoFunc(undoDataFuncMap);
+        // the undone contracts are not known by key, drop all the contract metadata
+        undoDataFuncMap[contractCache.GetPrefixType()] = [this](const CDbOpLogs &dbOpLogs) {
+            contractCache.UndoDataList(dbOpLogs);
+            ResetContractMetas();
+        };
         contractDataCache.RegisterUndoFunc(undoDataFuncMap);
         contractAccountCache.RegisterUndoFunc(undoDataFuncMap);
         contractTracesCache.RegisterUndoFunc(undoDataFuncMap);
@@ -120,6 +141,12 @@ public:
     shared_ptr<CDBContractDataIterator> CreateContractDataIterator(const CRegID &contractRegid,
         const string &contractKeyPrefix);
 
+private:
+    void AddContractMeta(const CRegIDKey &key, const CContractMetaPtr &spMeta);
+    void EraseContractMeta(const CRegIDKey &key);
+    void InvalidateContractMetas(const set<CRegIDKey> &contractKeys);
+    void ResetContractMetas();
+
 public:
 /*       type               prefixType               key                     value                 variable               */
 /*  ----------------   -------------------------   -----------------------  ------------------   ------------------------ */
@@ -135,6 +162,17 @@ public:
 
     // txid -> contract_traces
     CCompositeKVCache< dbk::CONTRACT_TRACES,     uint256,                      string >                    contractTracesCache;
+
+private:
+    CContractDBCache *pBase = nullptr;
+    // contract $RegIdKey -> metadata, loaded in this view or shared from the base view
+    map<CRegIDKey, CContractMetaPtr> contractMetas;
+    // bytes held by contractMetas, counted in the cache size and bounded by MAX_CONTRACT_METAS_SIZE
+    uint64_t contractMetasSize = 0;
+    // the contracts changed in this view, their metadata of the base view is stale
+    set<CRegIDKey> changedContracts;
+    // all the metadata of the base view is stale after undoing the contracts
+    bool metasReset = false;
 };
 
 #endif  // PERSIST_CONTRACTDB_H
\ No newline at end of file
@@ -10,6 +10,11 @@
 #include "dbconf.h"
 #include "leveldbwrapper.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <set>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -278,33 +283,156 @@ namespace db_util {
 typedef void(UndoDataFunc)(const CDbOpLogs &pDbOpLogs);
 typedef std::map<dbk::PrefixType, std::function<UndoDataFunc>> UndoDataFuncMap;
 
+/** Writes the data frozen by a db level cache into the batch of its db, run by the background flush */
+typedef std::function<void(CLevelDBBatch &batch)> DbFlushJob;
+
+/** Key lookups of the db level caches of a prefix type */
+struct CDbCacheLookupStats {
+    std::atomic<uint64_t> hits{0};        // answered from memory, including the absent keys
+    std::atomic<uint64_t> absent_hits{0}; // answered by the absent keys
+    std::atomic<uint64_t> misses{0};      // read from the db
+};
+
+inline CDbCacheLookupStats &GetDbCacheLookupStats(dbk::PrefixType prefixType) {
+    static CDbCacheLookupStats stats[dbk::PREFIX_COUNT + 1];
+    assert(prefixType >= 0 && prefixType <= dbk::PREFIX_COUNT);
+    return stats[prefixType];
+}
+
+struct CDbCacheCowStats {
+    std::atomic<uint64_t> shared_reads{0}; // a view read through to its base, sharing the base value
+    std::atomic<uint64_t> cow_copies{0};   // first write of a value shared with other views, made a new value
+    std::atomic<uint64_t> owned_writes{0}; // write of a value owned by the view only, updated in place
+};
+
+inline CDbCacheCowStats &GetDbCacheCowStats(dbk::PrefixType prefixType) {
+    static CDbCacheCowStats stats[dbk::PREFIX_COUNT + 1];
+    assert(prefixType >= 0 && prefixType <= dbk::PREFIX_COUNT);
+    return stats[prefixType];
+}
+
+// sum of the copy on write stats of all the prefixes, the difference of two totals is the traffic in between
+struct CDbCacheCowTotals {
+    uint64_t shared_reads = 0;
+    uint64_t cow_copies   = 0;
+    uint64_t owned_writes = 0;
+
+    static CDbCacheCowTotals Now() {
+        CDbCacheCowTotals totals;
+        for (int32_t i = dbk::EMPTY + 1; i < dbk::PREFIX_COUNT; i++) {
+            CDbCacheCowStats &stats = GetDbCacheCowStats((dbk::PrefixType)i);
+            totals.shared_reads += stats.shared_reads;
+            totals.cow_copies   += stats.cow_copies;
+            totals.owned_writes += stats.owned_writes;
+        }
+        return totals;
+    }
+
+    CDbCacheCowTotals operator-(const CDbCacheCowTotals &other) const {
+        CDbCacheCowTotals totals;
+        totals.shared_reads = shared_reads - other.shared_reads;
+        totals.cow_copies   = cow_copies - other.cow_copies;
+        totals.owned_writes = owned_writes - other.owned_writes;
+        return totals;
+    }
+
+    std::string ToString() const {
+        return strprintf("shared_reads=%llu, cow_copies=%llu, owned_writes=%llu", shared_reads, cow_copies,
+                         owned_writes);
+    }
+};
+
 class CDBAccess {
 public:
     CDBAccess(DBNameType dbNameTypeIn, const boost::filesystem::path &path, size_t cacheSize,
-              bool memory, bool wipe)
-        : dbNameType(dbNameTypeIn), db(path, cacheSize, memory, wipe) {}
+              bool memory, bool wipe, const CDbProfile &profile = CDbProfile())
+        : dbNameType(dbNameTypeIn), spDb(std::make_shared<CLevelDBWrapper>(path, cacheSize, memory, wipe, profile)) {}
+
+    /**
+     * Access the data of dbNameTypeIn in a store shared with the other db names. The key prefixes of the
+     * db names never start with one another, so they keep the data apart like column families.
+     */
+    CDBAccess(DBNameType dbNameTypeIn, const std::shared_ptr<CLevelDBWrapper> &spDbIn)
+        : dbNameType(dbNameTypeIn), spDb(spDbIn) {}
 
-    int64_t GetDbCount() const { return db.GetDbCount(); }
+    int64_t GetDbCount() const { return spDb->GetDbCount(); }
     template<typename KeyType, typename ValueType>
     bool GetData(const dbk::PrefixType prefixType, const KeyType &key, ValueType &value) const {
         string keyStr = dbk::GenDbKey(prefixType, key);
-        return db.Read(keyStr, value);
+        return spDb->Read(keyStr, value);
     }
 
     template<typename ValueType>
     bool GetData(const dbk::PrefixType prefixType, ValueType &value) const {
         const string prefix = dbk::GetKeyPrefix(prefixType);
-        return db.Read(prefix, value);
+        return spDb->Read(prefix, value);
     }
 
     template<typename KeyType, typename ValueType>
     bool HasData(const dbk::PrefixType prefixType, const KeyType &key) const {
         string keyStr = dbk::GenDbKey(prefixType, key);
-        return db.Exists(keyStr);
+        return spDb->Exists(keyStr);
     }
 
     inline void WriteBatch(CLevelDBBatch &batch) {
-        db.WriteBatch(batch, true);
+        if (pPendingBatch != nullptr) {
+            pPendingBatch->Append(batch);
+        } else {
+            // the older data of a background flush must not overwrite this batch
+            if (!WaitForBackgroundFlush())
+                throw std::runtime_error(strprintf("%s: the background flush failed, refuse to write",
+                                                   ::GetDbName(dbNameType)));
+            spDb->WriteBatch(batch, true);
+        }
+    }
+
+    /** Collect the written batches into pBatchIn instead of writing them, until it is reset to nullptr */
+    void SetPendingBatch(CLevelDBBatch *pBatchIn) { pPendingBatch = pBatchIn; }
+
+    /**
+     * Background flush: between BeginBackgroundFlush() and SetFlushJobs(nullptr) the db level caches freeze
+     * their data and hand its writing to pJobsIn. The frozen data is read by the caches until
+     * EndBackgroundFlush() tells the generation is written. After FailBackgroundFlush() it is never written,
+     * the caches keep reading it and the db refuses any later write.
+     */
+    void BeginBackgroundFlush(std::vector<DbFlushJob> *pJobsIn) {
+        assert(IsFlushWritten(flushGeneration));
+        pFlushJobs = pJobsIn;
+        flushGeneration++;
+    }
+    void SetFlushJobs(std::vector<DbFlushJob> *pJobsIn) { pFlushJobs = pJobsIn; }
+    std::vector<DbFlushJob> *GetFlushJobs() const { return pFlushJobs; }
+    uint64_t GetFlushGeneration() const { return flushGeneration; }
+
+    // write the batch of the background flush
+    void CommitBackgroundBatch(CLevelDBBatch &batch) { spDb->WriteBatch(batch, true); }
+
+    void EndBackgroundFlush() {
+        std::unique_lock<std::mutex> lock(flushMutex);
+        writtenGeneration = flushGeneration.load();
+        flushCond.notify_all();
+    }
+
+    void FailBackgroundFlush() {
+        std::unique_lock<std::mutex> lock(flushMutex);
+        flushFailed = true;
+        flushCond.notify_all();
+    }
+
+    bool IsFlushWritten(uint64_t generation) const { return writtenGeneration >= generation; }
+
+    /**
+     * While set, the views of several threads read through the db level caches of this db at the same time, so
+     * the caches keep nothing they read. Only set while nothing writes the db level caches.
+     */
+    void SetSharedRead(bool sharedReadIn) { sharedRead = sharedReadIn; }
+    bool IsSharedRead() const { return sharedRead; }
+
+    // returns false if the background flush failed, the db then misses the frozen data
+    bool WaitForBackgroundFlush() {
+        std::unique_lock<std::mutex> lock(flushMutex);
+        flushCond.wait(lock, [this] { return flushFailed || writtenGeneration >= flushGeneration; });
+        return !flushFailed;
     }
 
     template<typename ValueType>
@@ -317,19 +445,60 @@ public:
         } else {
             batch.Write(prefix, value);
         }
-        db.WriteBatch(batch, true);
+        WriteBatch(batch);
     }
 
     DBNameType GetDbNameType() const { return dbNameType; }
 
+    const std::shared_ptr<CLevelDBWrapper> &GetDb() const { return spDb; }
+
+    // approximate bytes on disk of the key prefixes of dbNameType
+    uint64_t GetApproximateSize() const {
+        uint64_t size = 0;
+        for (int32_t i = dbk::EMPTY + 1; i < dbk::PREFIX_COUNT; i++) {
+            if (dbk::GetDbNameEnumByPrefix((dbk::PrefixType)i) != dbNameType)
+                continue;
+            const string &prefix = dbk::GetKeyPrefix((dbk::PrefixType)i);
+            // the prefixes are ascii, the end is the next prefix of the same length
+            string end = prefix;
+            end.back()++;
+            size += spDb->GetApproximateSize(prefix, end);
+        }
+        return size;
+    }
+
     std::shared_ptr<leveldb::Iterator> NewIterator() {
-        return std::shared_ptr<leveldb::Iterator>(db.NewIterator());
+        // the iterators do not see the frozen data, wait until it is in the db. After a failed background
+        // flush they miss it, the node is stopping then
+        WaitForBackgroundFlush();
+        return std::shared_ptr<leveldb::Iterator>(spDb->NewIterator());
     }
 private:
     DBNameType dbNameType;
-    mutable CLevelDBWrapper db; // // TODO: remove the mutable declare
+    std::shared_ptr<CLevelDBWrapper> spDb;
+    CLevelDBBatch *pPendingBatch = nullptr;
+
+    std::vector<DbFlushJob> *pFlushJobs = nullptr;
+    std::atomic<uint64_t> flushGeneration{0};
+    std::atomic<uint64_t> writtenGeneration{0};
+    bool flushFailed = false;
+    std::atomic<bool> sharedRead{false};
+    std::mutex flushMutex;
+    std::condition_variable flushCond;
 };
 
+/**
+ * Copy-on-write layered KV cache.
+ *
+ * The values held by the map are immutable once inserted, every write puts a new value object into the map
+ * instead of changing the old one in place. So the child caches reading through to the base share the value
+ * objects of the base, a copy of the cache only copies the pointers, and flushing to the base moves the
+ * pointers instead of copying the values.
+ *
+ * Every layer also remembers the keys its base or the db did not have, so a repeated miss is answered without
+ * going down the layers to the db again. A key leaves the absent keys as soon as a value is put into the map,
+ * and the keys erased from the db by a flush become absent keys of the db level cache.
+ */
 template<int32_t PREFIX_TYPE_VALUE, typename __KeyType, typename __ValueType>
 class CCompositeKVCache {
 public:
@@ -365,11 +534,11 @@ public:
     CCompositeKVCache& operator=(const CCompositeKVCache& other) {
         pBase = other.pBase;
         pDbAccess = other.pDbAccess;
-        // deep copy for map
-        mapData.clear();
-        for (auto otherItem : other.mapData) {
-            mapData[otherItem.first] = make_shared<ValueType>(*otherItem.second);
-        }
+        // the values are immutable, share them with other. The absent keys are not copied, the copy looks them up again
+        mapData = other.mapData;
+        absentKeys.clear();
+        spFrozenMap = other.spFrozenMap;
+        frozenGeneration = other.frozenGeneration;
         pDbOpLogMap = other.pDbOpLogMap;
         is_calc_size = other.is_calc_size;
         size = other.size;
@@ -381,6 +550,7 @@ public:
         assert(pDbAccess == nullptr);
         assert(mapData.empty());
         pBase = pBaseIn;
+        absentKeys.clear();
     };
 
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
@@ -405,6 +575,18 @@ public:
         return false;
     }
 
+    // the value shared with the cache without copying it, a later write to the key copies the value
+    std::shared_ptr<const ValueType> GetDataPtr(const KeyType &key) const {
+        if (db_util::IsEmpty(key)) {
+            return nullptr;
+        }
+        auto it = GetDataIt(key);
+        if (it != mapData.end() && !db_util::IsEmpty(*it->second)) {
+            return it->second;
+        }
+        return nullptr;
+    }
+
     bool SetData(const KeyType &key, const ValueType &value) {
         if (db_util::IsEmpty(key)) {
             return false;
@@ -417,7 +599,7 @@ public:
         } else {
             AddOpLog(key, *it->second, &value);
             UpdateDataSize(*it->second, value);
-            *it->second = value;
+            SetValue(it, value);
         }
         return true;
     }
@@ -438,7 +620,7 @@ public:
         if (it != mapData.end() && !db_util::IsEmpty(*it->second)) {
             DecDataSize(*it->second);
             AddOpLog(key, *it->second, nullptr);
-            db_util::SetEmpty(*it->second);
+            it->second = db_util::MakeEmptyValue<ValueType>();
             IncDataSize(*it->second);
         }
         return true;
@@ -453,9 +635,39 @@ public:
         assert(pBase != nullptr || pDbAccess != nullptr);
         if (pBase != nullptr) {
             assert(pDbAccess == nullptr);
-            for (auto item : mapData) {
-                pBase->SetDataToSelf(item.first, *item.second);
+            if (pBase->mapData.empty() && !pBase->is_calc_size) {
+                // nothing to merge with, hand over the whole map
+                pBase->mapData.swap(mapData);
+                if (!pBase->absentKeys.empty()) {
+                    for (auto &item : pBase->mapData)
+                        pBase->absentKeys.erase(item.first);
+                }
+            } else {
+                for (auto &item : mapData) {
+                    pBase->SetDataToSelf(item.first, item.second);
+                }
+            }
+        } else if (pDbAccess != nullptr && pDbAccess->GetFlushJobs() != nullptr) {
+            // background flush: freeze the data, it is read from the frozen map until it is written
+            auto spFrozen = std::make_shared<Map>();
+            spFrozen->swap(mapData);
+            for (auto &item : *spFrozen) {
+                if (db_util::IsEmpty(*item.second))
+                    AddAbsentKey(item.first);
             }
+            spFrozenMap      = spFrozen;
+            frozenGeneration = pDbAccess->GetFlushGeneration();
+
+            pDbAccess->GetFlushJobs()->push_back([spFrozen](CLevelDBBatch &batch) {
+                for (auto &item : *spFrozen) {
+                    string key = dbk::GenDbKey(PREFIX_TYPE, item.first);
+                    if (db_util::IsEmpty(*item.second)) {
+                        batch.Erase(key);
+                    } else {
+                        batch.Write(key, *item.second);
+                    }
+                }
+            });
         } else if (pDbAccess != nullptr) {
             assert(pBase == nullptr);
             CLevelDBBatch batch;
@@ -463,6 +675,7 @@ public:
                 string key = dbk::GenDbKey(PREFIX_TYPE, item.first);
                 if (db_util::IsEmpty(*item.second)) {
                     batch.Erase(key);
+                    AddAbsentKey(item.first);
                 } else {
                     batch.Write(key, *item.second);
                 }
@@ -502,38 +715,138 @@ public:
 
     CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType>* GetBasePtr() { return pBase; }
 
+    // an iterator over the cache reads all the keys of the prefix
+    void AddIteratorRead() const {
+        if (pDbOpLogMap != nullptr && pDbOpLogMap->IsRecordRead())
+            pDbOpLogMap->AddReadPrefix(PREFIX_TYPE);
+    }
+
     map<KeyType, ValueSPtr>& GetMapData() { return mapData; };
 private:
     Iterator GetDataIt(const KeyType &key) const {
+        if (pDbOpLogMap != nullptr && pDbOpLogMap->IsRecordRead())
+            pDbOpLogMap->AddReadKey(dbk::GenDbKey(PREFIX_TYPE, key));
+
         Iterator it = mapData.find(key);
         if (it != mapData.end()) {
+            if (pDbAccess != nullptr)
+                GetDbCacheLookupStats(PREFIX_TYPE).hits++;
             return it;
-        } else if (pBase != nullptr) {
+        }
+
+        if (absentKeys.count(key)) {
+            if (pDbAccess != nullptr) {
+                CDbCacheLookupStats &stats = GetDbCacheLookupStats(PREFIX_TYPE);
+                stats.hits++;
+                stats.absent_hits++;
+            }
+            return mapData.end();
+        }
+
+        if (pBase != nullptr) {
             // find key-value at base cache
-            auto baseIt = pBase->GetDataIt(key);
-            if (baseIt != pBase->mapData.end()) {
-                // the found key-value add to current mapData
-                return AddDataToMap(key, *baseIt->second);
+            auto spBaseValue = pBase->FindValue(key);
+            if (spBaseValue) {
+                // the found key-value add to current mapData, sharing the value with base
+                GetDbCacheCowStats(PREFIX_TYPE).shared_reads++;
+                return AddDataToMap(key, spBaseValue);
             }
         } else if (pDbAccess != NULL) {
-            // TODO: need to save the empty value to mapData for search performance?
+            if (spFrozenMap) {
+                if (pDbAccess->IsFlushWritten(frozenGeneration)) {
+                    spFrozenMap.reset();
+                } else {
+                    auto frozenIt = spFrozenMap->find(key);
+                    if (frozenIt != spFrozenMap->end()) {
+                        GetDbCacheLookupStats(PREFIX_TYPE).hits++;
+                        return AddDataToMap(key, frozenIt->second);
+                    }
+                }
+            }
+
+            GetDbCacheLookupStats(PREFIX_TYPE).misses++;
             auto pDbValue = db_util::MakeEmptyValue<ValueType>();
             if (pDbAccess->GetData(PREFIX_TYPE, key, *pDbValue)) {
                 return AddDataToMap(key, pDbValue);
             }
         }
 
+        AddAbsentKey(key);
         return mapData.end();
     }
 
+    // The value of key for a child view. The db level cache read by the views of several threads at the same
+    // time keeps nothing it reads, see CDBAccess::SetSharedRead(), nor does a cache without base and db.
+    ValueSPtr FindValue(const KeyType &key) const {
+        if (pDbAccess == nullptr && pBase == nullptr) {
+            auto it = mapData.find(key);
+            return it != mapData.end() ? it->second : nullptr;
+        }
+        if (pDbAccess == nullptr || !pDbAccess->IsSharedRead()) {
+            auto it = GetDataIt(key);
+            return it != mapData.end() ? it->second : nullptr;
+        }
+
+        CDbCacheLookupStats &stats = GetDbCacheLookupStats(PREFIX_TYPE);
+        auto it = mapData.find(key);
+        if (it != mapData.end()) {
+            stats.hits++;
+            return it->second;
+        }
+        if (absentKeys.count(key)) {
+            stats.hits++;
+            stats.absent_hits++;
+            return nullptr;
+        }
+        if (spFrozenMap && !pDbAccess->IsFlushWritten(frozenGeneration)) {
+            auto frozenIt = spFrozenMap->find(key);
+            if (frozenIt != spFrozenMap->end()) {
+                stats.hits++;
+                return frozenIt->second;
+            }
+        }
+
+        stats.misses++;
+        auto pDbValue = db_util::MakeEmptyValue<ValueType>();
+        if (pDbAccess->GetData(PREFIX_TYPE, key, *pDbValue))
+            return pDbValue;
+        return nullptr;
+    }
+
+    inline void AddAbsentKey(const KeyType &key) const {
+        if (absentKeys.size() >= DB_CACHE_MAX_ABSENT_KEYS)
+            absentKeys.clear();
+        absentKeys.insert(key);
+    }
+
+    /**
+     * Copy on write: a value shared with other views, the base, a copy or a frozen map, is replaced by a new
+     * value. A value owned by this view only is updated in place, so the repeated writes of a key do not
+     * allocate. The reference count only drops from other threads, a stale count makes a needless copy.
+     */
+    inline void SetValue(Iterator it, const ValueType &value) {
+        CDbCacheCowStats &stats = GetDbCacheCowStats(PREFIX_TYPE);
+        if (it->second.use_count() == 1) {
+            *it->second = value;
+            stats.owned_writes++;
+        } else {
+            it->second = make_shared<ValueType>(value);
+            stats.cow_copies++;
+        }
+    }
+
     // set data to self only
     void SetDataToSelf(const KeyType &key, const ValueType &value) {
+        SetDataToSelf(key, make_shared<ValueType>(value));
+    }
+
+    void SetDataToSelf(const KeyType &key, const ValueSPtr &spValue) {
         auto it = mapData.find(key);
         if (it != mapData.end()) {
-            UpdateDataSize(*it->second, value);
-            *it->second = value;
+            UpdateDataSize(*it->second, *spValue);
+            it->second = spValue;
         } else {
-            AddDataToMap(key, value);
+            AddDataToMap(key, spValue);
         }
     }
 
@@ -542,11 +855,13 @@ private:
         return AddDataToMap(keyIn, spNewValue);
     }
 
-    inline Iterator AddDataToMap(const KeyType &keyIn, ValueSPtr &spNewValue) const {
+    inline Iterator AddDataToMap(const KeyType &keyIn, const ValueSPtr &spNewValue) const {
         auto newRet = mapData.emplace(keyIn, spNewValue);
         if (!newRet.second)
             throw runtime_error(strprintf("%s :  %s, alloc new cache item failed", __FUNCTION__, __LINE__));
         IncDataSize(keyIn, *spNewValue);
+        if (!absentKeys.empty())
+            absentKeys.erase(keyIn);
         return newRet.first;
     }
 
@@ -594,6 +909,15 @@ private:
                 dbOpLog.Set(key, oldValue);
             #endif
             pDbOpLogMap->AddOpLog(PREFIX_TYPE, dbOpLog);
+
+            if (pDbOpLogMap->IsRecordRedo()) {
+                CDbOpLog dbRedoLog;
+                if (pNewValue != nullptr)
+                    dbRedoLog.Set(key, *pNewValue);
+                else
+                    dbRedoLog.Set(key, *db_util::MakeEmptyValue<ValueType>());
+                pDbOpLogMap->AddRedoLog(PREFIX_TYPE, dbRedoLog);
+            }
         }
 
     }
@@ -601,6 +925,11 @@ private:
     mutable CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType> *pBase = nullptr;
     CDBAccess *pDbAccess = nullptr;
     mutable map<KeyType, ValueSPtr> mapData;
+    // keys not found in the base or the db, never in mapData at the same time
+    mutable std::set<KeyType> absentKeys;
+    // data of the db level cache being written by a background flush
+    mutable std::shared_ptr<const Map> spFrozenMap;
+    uint64_t frozenGeneration = 0;
     CDBOpLogMap *pDbOpLogMap = nullptr;
     bool is_calc_size = false;
     mutable uint32_t size = 0;
@@ -635,12 +964,10 @@ public:
     CSimpleKVCache& operator=(const CSimpleKVCache& other) {
         pBase = other.pBase;
         pDbAccess = other.pDbAccess;
-        // deep copy for shared_ptr
-        if (other.ptrData == nullptr) {
-            ptrData = nullptr;
-        } else {
-            ptrData = make_shared<ValueType>(*other.ptrData);
-        }
+        // the value is immutable, share it with other
+        ptrData = other.ptrData;
+        spFrozenData = other.spFrozenData;
+        frozenGeneration = other.frozenGeneration;
         pDbOpLogMap = other.pDbOpLogMap;
         return *this;
     }
@@ -673,12 +1000,13 @@ public:
     }
 
     bool SetData(const ValueType &value) {
-        GetDataPtr();
-        if (!ptrData) {
-            ptrData = db_util::MakeEmptyValue<ValueType>();
+        auto ptr = GetDataPtr();
+        if (ptr) {
+            AddOpLog(*ptr, &value);
+        } else {
+            AddOpLog(*db_util::MakeEmptyValue<ValueType>(), &value);
         }
-        AddOpLog(*ptrData, &value);
-        *ptrData = value;
+        ptrData = make_shared<ValueType>(value);
         return true;
     }
 
@@ -691,7 +1019,7 @@ public:
         auto ptr = GetDataPtr();
         if (ptr && !db_util::IsEmpty(*ptr)) {
             AddOpLog(*ptr, nullptr);
-            db_util::SetEmpty(*ptr);
+            ptrData = db_util::MakeEmptyValue<ValueType>();
         }
         return true;
     }
@@ -706,6 +1034,19 @@ public:
             if (pBase != nullptr) {
                 assert(pDbAccess == nullptr);
                 pBase->ptrData = ptrData;
+            } else if (pDbAccess != nullptr && pDbAccess->GetFlushJobs() != nullptr) {
+                // background flush: freeze the value, it is read until it is written
+                auto spValue     = ptrData;
+                spFrozenData     = spValue;
+                frozenGeneration = pDbAccess->GetFlushGeneration();
+                pDbAccess->GetFlushJobs()->push_back([spValue](CLevelDBBatch &batch) {
+                    const string &prefix = dbk::GetKeyPrefix(PREFIX_TYPE);
+                    if (db_util::IsEmpty(*spValue)) {
+                        batch.Erase(prefix);
+                    } else {
+                        batch.Write(prefix, *spValue);
+                    }
+                });
             } else if (pDbAccess != nullptr) {
                 assert(pBase == nullptr);
                 pDbAccess->WriteBatch(PREFIX_TYPE, *ptrData);
@@ -715,10 +1056,9 @@ public:
     }
 
     void UndoData(const CDbOpLog &dbOpLog) {
-        if (!ptrData) {
-            ptrData = db_util::MakeEmptyValue<ValueType>();
-        }
-        dbOpLog.Get(*ptrData);
+        auto ptrValue = db_util::MakeEmptyValue<ValueType>();
+        dbOpLog.Get(*ptrValue);
+        ptrData = ptrValue;
     }
 
     void UndoDataList(const CDbOpLogs &dbOpLogs) {
@@ -734,20 +1074,34 @@ public:
     dbk::PrefixType GetPrefixType() const { return PREFIX_TYPE; }
 
     std::shared_ptr<ValueType> GetDataPtr() const {
+        if (pDbOpLogMap != nullptr && pDbOpLogMap->IsRecordRead())
+            pDbOpLogMap->AddReadKey(dbk::GetKeyPrefix(PREFIX_TYPE));
 
         if (ptrData) {
             return ptrData;
         } else if (pBase != nullptr){
             auto ptr = pBase->GetDataPtr();
             if (ptr) {
-                ptrData = std::make_shared<ValueType>(*ptr);
+                // share the value with base, it is replaced instead of changed on write
+                ptrData = ptr;
                 return ptrData;
             }
         } else if (pDbAccess != NULL) {
+            // read by the views of several threads at the same time, keep nothing
+            bool sharedRead = pDbAccess->IsSharedRead();
+            if (spFrozenData) {
+                if (!pDbAccess->IsFlushWritten(frozenGeneration))
+                    return spFrozenData;
+                if (!sharedRead)
+                    spFrozenData.reset();
+            }
+
             auto ptrDbData = db_util::MakeEmptyValue<ValueType>();
 
             if (pDbAccess->GetData(PREFIX_TYPE, *ptrDbData)) {
                 assert(!db_util::IsEmpty(*ptrDbData));
+                if (sharedRead)
+                    return ptrDbData;
                 ptrData = ptrDbData;
                 return ptrData;
             }
@@ -768,6 +1122,15 @@ private:
                 dbOpLog.Set(oldValue);
             #endif
             pDbOpLogMap->AddOpLog(PREFIX_TYPE, dbOpLog);
+
+            if (pDbOpLogMap->IsRecordRedo()) {
+                CDbOpLog dbRedoLog;
+                if (pNewValue != nullptr)
+                    dbRedoLog.Set(*pNewValue);
+                else
+                    dbRedoLog.Set(*db_util::MakeEmptyValue<ValueType>());
+                pDbOpLogMap->AddRedoLog(PREFIX_TYPE, dbRedoLog);
+            }
         }
 
     }
@@ -775,6 +1138,9 @@ private:
     mutable CSimpleKVCache<PREFIX_TYPE, ValueType> *pBase;
     CDBAccess *pDbAccess;
     mutable std::shared_ptr<ValueType> ptrData = nullptr;
+    // the value of a background flush, read until its generation is written
+    mutable std::shared_ptr<ValueType> spFrozenData = nullptr;
+    uint64_t frozenGeneration                  = 0;
     CDBOpLogMap *pDbOpLogMap                   = nullptr;
 };
 
@@ -50,10 +50,55 @@ enum DBNameType {
 
 static const uint32_t MAX_DB_CACHE_SIZE = 1 << 30; // 1 GB: max cache size
 
+// the store of all the db names with -singlestatedb
+static const std::string STATE_DB_NAME = "state";
+
 static const EnumTypeMap<DBNameType, uint32_t> kDBCacheSizeMap = {
     DB_NAME_LIST(DEF_CACHE_SIZE_PAIR)
 };
 
+/**
+ * LevelDB tuning of a store, every option can be overridden by -db_<option>_<dbname>.
+ * The in-tree LevelDB is built without snappy, so the tables are always written uncompressed.
+ */
+struct CDbProfile {
+    uint32_t bloom_bits;        // bits per key of the bloom filter, 0 for none
+    uint32_t block_size;        // bytes of the table blocks
+    uint32_t max_open_files;
+    uint32_t write_buffer_size; // 0 for a quarter of the cache size
+
+    CDbProfile(uint32_t bloomBitsIn = 10, uint32_t blockSizeIn = (4 << 10), uint32_t maxOpenFilesIn = 64,
+               uint32_t writeBufferSizeIn = 0)
+        : bloom_bits(bloomBitsIn), block_size(blockSizeIn), max_open_files(maxOpenFilesIn),
+          write_buffer_size(writeBufferSizeIn) {}
+};
+
+#define DEF_DB_PROFILE_PAIR(enumType, bloomBits, blockSize, maxOpenFiles, writeBufferSize) \
+    {enumType, CDbProfile(bloomBits, blockSize, maxOpenFiles, writeBufferSize)},
+
+//         DBNameType       BloomBits  BlockSize     MaxOpenFiles  WriteBufferSize   description
+//         ----------       ---------  -----------   ------------  ---------------  ----------------------
+#define DB_PROFILE_LIST(DEFINE)                                                                         \
+    DEFINE( SYSPARAM,        10,        (4  << 10),   64,           0 )    /* few small entries */      \
+    DEFINE( ACCOUNT,         10,        (4  << 10),   256,          0 )    /* hot point reads */        \
+    DEFINE( ASSET,           10,        (4  << 10),   64,           0 )                                 \
+    DEFINE( BLOCK,           10,        (4  << 10),   256,          0 )    /* txid lookups */           \
+    DEFINE( CONTRACT,        10,        (16 << 10),   256,          0 )    /* scripts and data */       \
+    DEFINE( DELEGATE,        10,        (4  << 10),   64,           0 )                                 \
+    DEFINE( CDP,             10,        (16 << 10),   128,          0 )    /* index range scans */      \
+    DEFINE( CLOSEDCDP,       10,        (16 << 10),   64,           0 )    /* write mostly */           \
+    DEFINE( DEX,             10,        (16 << 10),   128,          0 )    /* order range scans */      \
+    DEFINE( LOG,             0,         (32 << 10),   64,           0 )    /* write mostly */           \
+    DEFINE( RECEIPT,         10,        (16 << 10),   64,           0 )    /* write mostly */           \
+    DEFINE( UTXO,            10,        (4  << 10),   128,          0 )    /* point reads */            \
+    DEFINE( SYSGOVERN,       10,        (4  << 10),   64,           0 )                                 \
+    DEFINE( PRICEFEED,       10,        (4  << 10),   64,           0 )                                 \
+    DEFINE( AXC,             10,        (4  << 10),   64,           0 )
+
+static const EnumTypeMap<DBNameType, CDbProfile> kDbProfileMap = {
+    DB_PROFILE_LIST(DEF_DB_PROFILE_PAIR)
+};
+
 static const std::string kDbNames[DBNameType::DB_NAME_COUNT + 1] {
     DB_NAME_LIST(DEF_DB_NAME_ARRAY)
 };
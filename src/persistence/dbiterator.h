@@ -302,7 +302,7 @@ public:
     typedef typename CacheType::ValueType ValueType;
 
     CDbIterator(CacheType &dbCacheIn): sp_it_Impl(IteratorImpl::Create(dbCacheIn)){
-
+        dbCacheIn.AddIteratorRead();
     }
     virtual bool First() {
         return sp_it_Impl->First();
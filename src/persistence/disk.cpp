@@ -7,6 +7,13 @@
 #include "logging.h"
 #include "boost/filesystem.hpp"
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CBlockFileInfo
 
@@ -62,3 +69,76 @@ FILE *OpenDiskFile(const CDiskBlockPos &pos, const char *prefix, bool fReadOnly)
 FILE *OpenBlockFile(const CDiskBlockPos &pos, bool fReadOnly) {
     return OpenDiskFile(pos, "blk", fReadOnly);
 }
+
+////////////////////////////////////////////////////////////////////////////////
+// class CBlockFileMapper
+
+CBlockFileMapper blockFileMapper;
+
+CMappedBlockFile::~CMappedBlockFile() {
+#ifndef WIN32
+    munmap((void *)data, length);
+#endif
+}
+
+std::shared_ptr<const CMappedBlockFile> CBlockFileMapper::GetFile(int32_t nFile, uint64_t minLength) {
+    std::unique_lock<std::mutex> lock(mtx);
+    auto it = files.find(nFile);
+    if (it != files.end() && it->second->length >= minLength)
+        return it->second;
+
+#ifdef WIN32
+    return nullptr;
+#else
+    boost::filesystem::path path = GetDataDir() / "blocks" / strprintf("blk%05u.dat", nFile);
+    int fd = open(path.string().c_str(), O_RDONLY);
+    if (fd == -1)
+        return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < minLength) {
+        close(fd);
+        return nullptr;
+    }
+
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        LogPrint(BCLog::ERROR, "Unable to map file %s\n", path.string());
+        return nullptr;
+    }
+
+    auto spFile  = std::make_shared<const CMappedBlockFile>((const char *)data, (size_t)st.st_size);
+    files[nFile] = spFile;
+    return spFile;
+#endif
+}
+
+CBlockFileSpan CBlockFileMapper::GetBlockSpan(const CDiskBlockPos &pos) {
+    CBlockFileSpan span;
+    // the block is preceded by the message start and its size
+    if (pos.IsNull() || pos.nPos < 8)
+        return span;
+
+    auto spFile = GetFile(pos.nFile, pos.nPos);
+    if (!spFile)
+        return span;
+
+    uint32_t nSize;
+    memcpy(&nSize, spFile->data + pos.nPos - 4, sizeof(nSize));
+    if ((uint64_t)pos.nPos + nSize > spFile->length) {
+        spFile = GetFile(pos.nFile, (uint64_t)pos.nPos + nSize);
+        if (!spFile)
+            return span;
+    }
+
+    span.pBegin = spFile->data + pos.nPos;
+    span.pEnd   = span.pBegin + nSize;
+    span.spFile = spFile;
+    return span;
+}
+
+void CBlockFileMapper::Clear() {
+    std::unique_lock<std::mutex> lock(mtx);
+    files.clear();
+}
@@ -10,6 +10,10 @@
 #include "commons/serialize.h"
 #include "entities/id.h"
 
+#include <map>
+#include <memory>
+#include <mutex>
+
 struct CDiskBlockPos {
     int32_t nFile;
     uint32_t nPos;
@@ -127,4 +131,89 @@ FILE *OpenDiskFile(const CDiskBlockPos &pos, const char *prefix, bool fReadOnly)
 /** Open a block file (blk?????.dat) */
 FILE *OpenBlockFile(const CDiskBlockPos &pos, bool fReadOnly = false);
 
+/** A block file mapped read-only into memory, unmapped when the last span using it is gone */
+class CMappedBlockFile {
+public:
+    CMappedBlockFile(const char *dataIn, size_t lengthIn) : data(dataIn), length(lengthIn) {}
+    ~CMappedBlockFile();
+
+    CMappedBlockFile(const CMappedBlockFile &) = delete;
+    CMappedBlockFile &operator=(const CMappedBlockFile &) = delete;
+
+    const char *data;
+    size_t length;
+};
+
+/** A range of bytes of a mapped block file */
+class CBlockFileSpan {
+public:
+    std::shared_ptr<const CMappedBlockFile> spFile;
+    const char *pBegin = nullptr;
+    const char *pEnd   = nullptr;
+
+    bool IsNull() const { return pBegin == nullptr; }
+    size_t size() const { return pEnd - pBegin; }
+};
+
+/** Deserialize straight from a span of a mapped block file, the CAutoFile counterpart without the reads */
+class CBlockFileReader {
+public:
+    int nType;
+    int nVersion;
+
+    CBlockFileReader(const CBlockFileSpan &spanIn, int nTypeIn, int nVersionIn)
+        : nType(nTypeIn), nVersion(nVersionIn), span(spanIn), pCur(spanIn.pBegin) {}
+
+    void SetType(int n) { nType = n; }
+    int GetType() { return nType; }
+    void SetVersion(int n) { nVersion = n; }
+    int GetVersion() { return nVersion; }
+
+    CBlockFileReader &read(char *pch, size_t nSize) {
+        if (nSize > (size_t)(span.pEnd - pCur))
+            throw std::ios_base::failure("CBlockFileReader::read : end of data");
+        memcpy(pch, pCur, nSize);
+        pCur += nSize;
+        return *this;
+    }
+
+    CBlockFileReader &Skip(size_t nSize) {
+        if (nSize > (size_t)(span.pEnd - pCur))
+            throw std::ios_base::failure("CBlockFileReader::Skip : end of data");
+        pCur += nSize;
+        return *this;
+    }
+
+    template <typename T>
+    CBlockFileReader &operator>>(T &obj) {
+        ::Unserialize(*this, obj, nType, nVersion);
+        return *this;
+    }
+
+private:
+    CBlockFileSpan span;
+    const char *pCur;
+};
+
+/**
+ * Maps every block file once and hands out spans of it, so that a block or a single tx is deserialized
+ * without reading the file, and the serialized block can be relayed as it is. The file being appended to
+ * is mapped again when a read goes beyond its mapped length, the old mapping lives on with its spans.
+ */
+class CBlockFileMapper {
+public:
+    /** The span of the serialized block at pos, a null span if the file can not be mapped */
+    CBlockFileSpan GetBlockSpan(const CDiskBlockPos &pos);
+    /** Drop the mappings, the spans still in use keep theirs */
+    void Clear();
+
+private:
+    std::shared_ptr<const CMappedBlockFile> GetFile(int32_t nFile, uint64_t minLength);
+
+    std::mutex mtx;
+    std::map<int32_t, std::shared_ptr<const CMappedBlockFile>> files;
+};
+
+extern CBlockFileMapper blockFileMapper;
+
 #endif //PERSIST_DISK_H
\ No newline at end of file
@@ -41,23 +41,46 @@ std::string CDBOpLogMap::ToString() const {
     return str;
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize) {
+namespace {
+class CBatchAppender : public leveldb::WriteBatch::Handler {
+public:
+    explicit CBatchAppender(leveldb::WriteBatch &batchIn) : batch(batchIn) {}
+
+    void Put(const leveldb::Slice &key, const leveldb::Slice &value) override { batch.Put(key, value); }
+    void Delete(const leveldb::Slice &key) override { batch.Delete(key); }
+
+private:
+    leveldb::WriteBatch &batch;
+};
+}  // namespace
+
+void CLevelDBBatch::Append(const CLevelDBBatch &other) {
+    CBatchAppender appender(batch);
+    leveldb::Status status = other.batch.Iterate(&appender);
+    ThrowError(status);
+}
+
+static leveldb::Options GetOptions(size_t nCacheSize, const CDbProfile &profile) {
     leveldb::Options options;
     options.block_cache       = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4;  // up to two write buffers may be held in memory simultaneously
-    options.filter_policy     = leveldb::NewBloomFilterPolicy(10);
+    // up to two write buffers may be held in memory simultaneously
+    options.write_buffer_size = profile.write_buffer_size > 0 ? profile.write_buffer_size : nCacheSize / 4;
+    options.filter_policy     = profile.bloom_bits > 0 ? leveldb::NewBloomFilterPolicy(profile.bloom_bits) : nullptr;
     options.compression       = leveldb::kNoCompression;
-    options.max_open_files    = 64;
+    options.block_size        = profile.block_size;
+    options.max_open_files    = profile.max_open_files;
     return options;
 }
 
-CLevelDBWrapper::CLevelDBWrapper(const boost::filesystem::path &path, size_t nCacheSize, bool fMemory, bool fWipe) {
+CLevelDBWrapper::CLevelDBWrapper(const boost::filesystem::path &path, size_t nCacheSize, bool fMemory, bool fWipe,
+                                 const CDbProfile &profileIn)
+    : profile(profileIn), blockCacheSize(nCacheSize / 2) {
     penv                         = nullptr;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache       = false;
     syncoptions.sync             = true;
-    options                      = GetOptions(nCacheSize);
+    options                      = GetOptions(nCacheSize, profile);
     options.create_if_missing    = true;
     if (fMemory) {
         penv        = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -75,6 +98,11 @@ CLevelDBWrapper::CLevelDBWrapper(const boost::filesystem::path &path, size_t nCa
     LogPrint(BCLog::INFO, "Opened LevelDB successfully\n");
 }
 
+std::string &CLevelDBWrapper::GetReadBuffer() {
+    static thread_local std::string buffer;
+    return buffer;
+}
+
 CLevelDBWrapper::~CLevelDBWrapper() {
     delete pdb;
     pdb = nullptr;
@@ -86,6 +114,17 @@ CLevelDBWrapper::~CLevelDBWrapper() {
     options.env = nullptr;
 }
 
+bool CLevelDBWrapper::GetProperty(const std::string &property, std::string &value) {
+    return pdb->GetProperty(property, &value);
+}
+
+uint64_t CLevelDBWrapper::GetApproximateSize(const std::string &begin, const std::string &end) {
+    leveldb::Range range(begin, end);
+    uint64_t size = 0;
+    pdb->GetApproximateSizes(&range, 1, &size);
+    return size;
+}
+
 bool CLevelDBWrapper::WriteBatch(CLevelDBBatch &batch, bool fSync) {
     leveldb::Status status = pdb->Write(fSync ? syncoptions : writeoptions, &batch.batch);
     ThrowError(status);
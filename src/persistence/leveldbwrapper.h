@@ -104,7 +104,46 @@ public:
         mapDbOpLogs[prefix].push_back(dbOpLogIn);
     }
 
-    void Clear() { mapDbOpLogs.clear(); }
+    void Clear() {
+        mapDbOpLogs.clear();
+        mapDbRedoLogs.clear();
+        readKeys.clear();
+        readPrefixes.clear();
+    }
+
+    // The redo logs record the new values of the changes, so the changes can be applied to another cache view
+    // with the undo functions of that view. Only kept in memory, not serialized.
+    void SetRecordRedo(bool recordRedoIn) { recordRedo = recordRedoIn; }
+    bool IsRecordRedo() const { return recordRedo; }
+
+    void AddRedoLog(dbk::PrefixType prefixType, const CDbOpLog& dbRedoLogIn) {
+        assert(prefixType != dbk::EMPTY);
+        const string& prefix = dbk::GetKeyPrefix(prefixType);
+        mapDbRedoLogs[prefix].push_back(dbRedoLogIn);
+    }
+
+    const map<string, CDbOpLogs>& GetRedoMap() const { return mapDbRedoLogs; }
+
+    // The read keys record the db keys read by the cache views, an iterator reads all the keys of its prefix.
+    // Only kept in memory, not serialized.
+    void SetRecordRead(bool recordReadIn) { recordRead = recordReadIn; }
+    bool IsRecordRead() const { return recordRead; }
+
+    void AddReadKey(const string &key) { readKeys.insert(key); }
+    void AddReadPrefix(dbk::PrefixType prefixType) { readPrefixes.insert(dbk::GetKeyPrefix(prefixType)); }
+
+    const set<string>& GetReadKeys() const { return readKeys; }
+    const set<string>& GetReadPrefixes() const { return readPrefixes; }
+
+    // the db keys of the redo logs
+    set<string> GetRedoKeys() const {
+        set<string> keys;
+        for (const auto &redoLogPair : mapDbRedoLogs) {
+            for (const auto &redoLog : redoLogPair.second)
+                keys.insert(redoLogPair.first + redoLog.GetKey());
+        }
+        return keys;
+    }
 
     std::string ToString() const;
 public:
@@ -113,6 +152,11 @@ public:
 	)
 private:
     mutable map<string, CDbOpLogs> mapDbOpLogs; // dbName -> dbOpLogs
+    map<string, CDbOpLogs> mapDbRedoLogs;       // dbName -> dbOpLogs of the new values
+    bool recordRedo = false;
+    set<string> readKeys;                       // db keys
+    set<string> readPrefixes;                   // prefixes of the iterated db keys
+    bool recordRead = false;
 };
 
 class leveldb_error : public runtime_error
@@ -145,10 +189,16 @@ public:
         batch.Delete(key);
     }
 
+    // append the writes and erases of other to this batch
+    void Append(const CLevelDBBatch &other);
+
  };
 
 class CLevelDBWrapper {
 private:
+    // the value buffer of the reads of the calling thread, keeps its capacity so the reads do not allocate
+    static std::string &GetReadBuffer();
+
     // custom environment this database is using (may be NULL in case of default environment)
     leveldb::Env *penv;
 
@@ -170,15 +220,20 @@ private:
     // the database itself
     leveldb::DB *pdb;
 
+    // tuning in effect, the compression is off without snappy
+    CDbProfile profile;
+    size_t blockCacheSize;
+
 public:
-    CLevelDBWrapper(const boost::filesystem::path &path, size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+    CLevelDBWrapper(const boost::filesystem::path &path, size_t nCacheSize, bool fMemory = false, bool fWipe = false,
+                    const CDbProfile &profileIn = CDbProfile());
     ~CLevelDBWrapper();
 
     template<typename V>
-    bool Read(std::string key, V &value) {
+    bool Read(const std::string &key, V &value) {
     	leveldb::Slice slKey(key);
 
-        string strValue;
+        string &strValue = GetReadBuffer();
         leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
         if (!status.ok()) {
             if (status.IsNotFound())
@@ -187,8 +242,9 @@ public:
             ThrowError(status);
         }
         try {
-            CDataStream ssValue(strValue.data(), strValue.data() + strValue.size(), SER_DISK, CLIENT_VERSION);
-            ssValue >> value;
+            // deserialize in place from the read buffer
+            CSpanReader reader(strValue.data(), strValue.data() + strValue.size(), SER_DISK, CLIENT_VERSION);
+            reader >> value;
         } catch(std::exception &e) {
             return false;
         }
@@ -204,7 +260,7 @@ public:
 
     bool Exists(const std::string &key) {
     	leveldb::Slice slKey(key);
-        string strValue;
+        string &strValue = GetReadBuffer();
         leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
         if (!status.ok()) {
             if (status.IsNotFound())
@@ -238,6 +294,13 @@ public:
         return pdb->NewIterator(iteroptions);
     }
     int64_t GetDbCount();
+
+    const CDbProfile &GetProfile() const { return profile; }
+    size_t GetBlockCacheSize() const { return blockCacheSize; }
+    // LevelDB property like "leveldb.stats" or "leveldb.num-files-at-level<N>"
+    bool GetProperty(const std::string &property, std::string &value);
+    // approximate bytes on disk of the keys in [begin, end)
+    uint64_t GetApproximateSize(const std::string &begin, const std::string &end);
    // Object ToJsonObj();
 };
 
@@ -10,6 +10,9 @@
 #include "tx/pricefeedtx.h"
 #include "commons/types.h"
 
+#include <algorithm>
+#include <limits>
+
 static inline bool ReadSlideWindow(CSysParamDBCache &sysParamCache, uint64_t &slideWindow, const char* pTitle) {
     if (!sysParamCache.GetParam(SysParamType::MEDIAN_PRICE_SLIDE_WINDOW_BLOCKCOUNT, slideWindow)) {
         return ERRORMSG("%s, read sys param MEDIAN_PRICE_SLIDE_WINDOW_BLOCKCOUNT error", pTitle);
@@ -17,20 +20,63 @@ static inline bool ReadSlideWindow(CSysParamDBCache &sysParamCache, uint64_t &sl
     return true;
 }
 
+void CSortedPrices::Insert(const uint64_t price) {
+    prices.insert(upper_bound(prices.begin(), prices.end(), price), price);
+}
+
+void CSortedPrices::Erase(const uint64_t price) {
+    auto it = lower_bound(prices.begin(), prices.end(), price);
+    assert(it != prices.end() && *it == price);
+    prices.erase(it);
+}
+
+size_t CSortedPrices::CountNotGreater(const uint64_t price) const {
+    return upper_bound(prices.begin(), prices.end(), price) - prices.begin();
+}
+
 void CConsecutiveBlockPrice::AddUserPrice(const HeightType blockHeight, const CRegID &regId, const uint64_t price) {
-    mapBlockUserPrices[blockHeight][regId] = price;
+    auto &userPrices = mapBlockUserPrices[blockHeight];
+    auto it = userPrices.find(regId);
+    if (it != userPrices.end()) {
+        sortedPrices.Erase(it->second);
+        it->second = price;
+    } else {
+        userPrices.emplace(regId, price);
+    }
+    sortedPrices.Insert(price);
+}
+
+void CConsecutiveBlockPrice::EmplaceUserPrice(const HeightType blockHeight, const CRegID &regId, const uint64_t price) {
+    if (mapBlockUserPrices[blockHeight].emplace(regId, price).second)
+        sortedPrices.Insert(price);
 }
 
 void CConsecutiveBlockPrice::DeleteUserPrice(const HeightType blockHeight) {
     // Marked the value empty, the base cache will delete it when Flush() is called.
-    mapBlockUserPrices[blockHeight].clear();
+    auto &userPrices = mapBlockUserPrices[blockHeight];
+    for (const auto &item : userPrices)
+        sortedPrices.Erase(item.second);
+    userPrices.clear();
 }
 
-bool CConsecutiveBlockPrice::ExistBlockUserPrice(const HeightType blockHeight, const CRegID &regId) {
-    if (mapBlockUserPrices.count(blockHeight) == 0)
-        return false;
+void CConsecutiveBlockPrice::EraseBlock(const HeightType blockHeight) {
+    auto it = mapBlockUserPrices.find(blockHeight);
+    if (it == mapBlockUserPrices.end())
+        return;
+
+    for (const auto &item : it->second)
+        sortedPrices.Erase(item.second);
+    mapBlockUserPrices.erase(it);
+}
 
-    return mapBlockUserPrices[blockHeight].count(regId);
+bool CConsecutiveBlockPrice::ExistBlockUserPrice(const HeightType blockHeight, const CRegID &regId) const {
+    auto it = mapBlockUserPrices.find(blockHeight);
+    return it != mapBlockUserPrices.end() && it->second.count(regId);
+}
+
+bool CConsecutiveBlockPrice::HasUserPrice(const HeightType blockHeight) const {
+    auto it = mapBlockUserPrices.find(blockHeight);
+    return it != mapBlockUserPrices.end() && !it->second.empty();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -62,35 +108,47 @@ bool CPricePointMemCache::ReleadBlocks(CSysParamDBCache &sysParamCache, CBlockIn
     return true;
 }
 
+bool CPricePointMemCache::ReplayBlock(CSysParamDBCache &sysParamCache, CBlockIndex *pBlockIdx, const CBlock &block) {
+    if (!AddPriceByBlock(block))
+        return ERRORMSG("add block=[%d]%s to price point memory cache failed", pBlockIdx->height,
+                        pBlockIdx->GetBlockHash().ToString());
+
+    return PushBlock(sysParamCache, pBlockIdx);
+}
+
 bool CPricePointMemCache::PushBlock(CSysParamDBCache &sysParamCache, CBlockIndex *pTipBlockIdx) {
 
     uint64_t slideWindow = 0;
     if (!ReadSlideWindow(sysParamCache, slideWindow, __func__)) return false;
-    // remove the oldest block
-    if ((HeightType)pTipBlockIdx->height > (HeightType)slideWindow) {
-        CBlockIndex *pDeleteBlockIndex = pTipBlockIdx;
-        int idx           = slideWindow;
-        while (pDeleteBlockIndex && idx-- > 0) {
-            pDeleteBlockIndex = pDeleteBlockIndex->pprev;
-        }
+    // remove the blocks slid out of the window
+    if ((HeightType)pTipBlockIdx->height > (HeightType)slideWindow)
+        ExpireBlocks(pTipBlockIdx->height - slideWindow);
 
-        if (pDeleteBlockIndex) {
-            CBlock deleteBlock;
-            if (!ReadBlockFromDisk(pDeleteBlockIndex, deleteBlock)) {
-                return ERRORMSG("read block=[%d]%s failed", pDeleteBlockIndex->height,
-                        pDeleteBlockIndex->GetBlockHash().ToString());
-            }
+    return true;
+}
 
-            if (!DeleteBlockFromCache(deleteBlock)) {
-                return ERRORMSG("delete block==[%d]%s from price point memory cache failed",
-                        pDeleteBlockIndex->height, pDeleteBlockIndex->GetBlockHash().ToString());
+void CPricePointMemCache::ExpireBlocks(const HeightType expireHeight) {
+    map<PriceCoinPair, set<HeightType>> expiring;
+    for (const CPricePointMemCache *pCache = this; pCache != nullptr; pCache = pCache->pBase) {
+        for (const auto &item : pCache->mapCoinPricePointCache) {
+            const BlockUserPriceMap &blockUserPrices = item.second.GetBlockUserPrices();
+            for (auto it = blockUserPrices.begin(); it != blockUserPrices.end() && it->first <= expireHeight; ++it) {
+                // the root cache erases its empty items too, nothing is left to hide under it
+                if (!it->second.empty() || pBase == nullptr)
+                    expiring[item.first].insert(it->first);
             }
-        } else {
-            return ERRORMSG("[WARN]the slide index=%u block not found in block index",
-                    idx);
         }
     }
-    return true;
+
+    for (const auto &item : expiring) {
+        CConsecutiveBlockPrice &cbp = mapCoinPricePointCache[item.first];
+        for (const auto height : item.second) {
+            if (pBase == nullptr)
+                cbp.EraseBlock(height);
+            else
+                cbp.DeleteUserPrice(height);
+        }
+    }
 }
 
 bool CPricePointMemCache::UndoBlock(CSysParamDBCache &sysParamCache, CBlockIndex *pTipBlockIdx, CBlock &block) {
@@ -146,8 +204,8 @@ bool CPricePointMemCache::AddPrice(const HeightType blockHeight, const CRegID &r
 
 bool CPricePointMemCache::ExistBlockUserPrice(const HeightType blockHeight, const CRegID &regId,
                                               const PriceCoinPair &coinPricePair) {
-    if (mapCoinPricePointCache.count(coinPricePair) &&
-        mapCoinPricePointCache[coinPricePair].ExistBlockUserPrice(blockHeight, regId))
+    auto it = mapCoinPricePointCache.find(coinPricePair);
+    if (it != mapCoinPricePointCache.end() && it->second.ExistBlockUserPrice(blockHeight, regId))
         return true;
 
     if (pBase)
@@ -193,16 +251,15 @@ bool CPricePointMemCache::DeleteBlockFromCache(const CBlock &block) {
     }
     auto height = block.GetHeight();
     for (auto &coinPair : deletingSet) {
-        mapCoinPricePointCache[coinPair].mapBlockUserPrices[height].clear();
+        mapCoinPricePointCache[coinPair].DeleteUserPrice(height);
     }
 
     for (auto &item : mapCoinPricePointCache) {
-        auto &blockPrices = item.second.mapBlockUserPrices[height];
-        if (!blockPrices.empty()) {
+        if (item.second.HasUserPrice(height)) {
             LogPrint(BCLog::ERROR, "[WARN] the price should be erased!, coin_pair=%s, height=%u\n",
                 CoinPairToString(item.first), height);
         }
-        blockPrices.clear();
+        item.second.DeleteUserPrice(height);
     }
 
     return true;
@@ -210,17 +267,16 @@ bool CPricePointMemCache::DeleteBlockFromCache(const CBlock &block) {
 
 void CPricePointMemCache::BatchWrite(const CoinPricePointMap &mapCoinPricePointCacheIn) {
     for (const auto &item : mapCoinPricePointCacheIn) {
+        CConsecutiveBlockPrice &cbp = mapCoinPricePointCache[item.first /* PriceCoinPair */];
         // map<HeightType /* block height */, map<CRegID, uint64_t /* price */>>
-        const auto &mapBlockUserPrices = item.second.mapBlockUserPrices;
-        for (const auto &userPrice : mapBlockUserPrices) {
+        for (const auto &userPrice : item.second.GetBlockUserPrices()) {
             if (userPrice.second.empty()) {
-                mapCoinPricePointCache[item.first /* PriceCoinPair */].mapBlockUserPrices.erase(userPrice.first /* height */);
+                cbp.EraseBlock(userPrice.first /* height */);
             } else {
                 // map<CRegID, uint64_t /* price */>;
                 for (const auto &priceItem : userPrice.second) {
-                    mapCoinPricePointCache[item.first /* PriceCoinPair */]
-                        .mapBlockUserPrices[userPrice.first /* height */]
-                        .emplace(priceItem.first /* CRegID */, priceItem.second /* price */);
+                    cbp.EmplaceUserPrice(userPrice.first /* height */, priceItem.first /* CRegID */,
+                                         priceItem.second /* price */);
                 }
             }
         }
@@ -238,101 +294,151 @@ void CPricePointMemCache::Flush() {
     mapCoinPricePointCache.clear();
 }
 
-bool CPricePointMemCache::GetBlockUserPrices(const PriceCoinPair &coinPricePair, set<HeightType> &expired,
-                                             BlockUserPriceMap &blockUserPrices) {
-    const auto &iter = mapCoinPricePointCache.find(coinPricePair);
-    if (iter != mapCoinPricePointCache.end()) {
-        const auto &mapBlockUserPrices = iter->second.mapBlockUserPrices;
-        for (const auto &item : mapBlockUserPrices) {
-            if (item.second.empty()) {
-                expired.insert(item.first);
-            } else if (expired.count(item.first) || blockUserPrices.count(item.first)) {
-                // TODO: log
-                continue;
-            } else {
-                // Got a valid item.
-                blockUserPrices[item.first] = item.second;
-            }
+map<PriceCoinPair, BlockUserPriceMap> CPricePointMemCache::GetSnapshot() const {
+    assert(pBase == nullptr);
+    map<PriceCoinPair, BlockUserPriceMap> snapshot;
+    for (const auto &item : mapCoinPricePointCache) {
+        for (const auto &blockPrices : item.second.GetBlockUserPrices()) {
+            if (!blockPrices.second.empty())
+                snapshot[item.first].insert(blockPrices);
         }
     }
+    return snapshot;
+}
 
-    if (pBase != nullptr) {
-        return pBase->GetBlockUserPrices(coinPricePair, expired, blockUserPrices);
+void CPricePointMemCache::LoadSnapshot(const map<PriceCoinPair, BlockUserPriceMap> &snapshot) {
+    assert(pBase == nullptr);
+    for (const auto &item : snapshot) {
+        CConsecutiveBlockPrice &cbp = mapCoinPricePointCache[item.first];
+        for (const auto &blockPrices : item.second) {
+            for (const auto &userPrice : blockPrices.second)
+                cbp.AddUserPrice(blockPrices.first, userPrice.first, userPrice.second);
+        }
     }
-
-    return true;
 }
 
-bool CPricePointMemCache::GetBlockUserPrices(const PriceCoinPair &coinPricePair, BlockUserPriceMap &blockUserPrices) {
-    set<HeightType /* block height */> expired;
-    if (!GetBlockUserPrices(coinPricePair, expired, blockUserPrices)) {
-        // TODO: log
-        return false;
-    }
+void CPricePointMemCache::GetViewBlockUserPrices(const PriceCoinPair &coinPricePair, set<HeightType> &expired,
+                                                 BlockUserPriceMap &blockUserPrices) const {
+    const auto &iter = mapCoinPricePointCache.find(coinPricePair);
+    if (iter == mapCoinPricePointCache.end())
+        return;
 
-    return true;
+    for (const auto &item : iter->second.GetBlockUserPrices()) {
+        if (item.second.empty()) {
+            expired.insert(item.first);
+        } else if (expired.count(item.first) || blockUserPrices.count(item.first)) {
+            continue;
+        } else {
+            // Got a valid item.
+            blockUserPrices[item.first] = item.second;
+        }
+    }
 }
 
-CMedianPriceDetail CPricePointMemCache::ComputeBlockMedianPrice(const HeightType blockHeight, const uint64_t slideWindow,
-                                                      const PriceCoinPair &coinPricePair) {
-    // 1. merge block user prices with base cache.
-    BlockUserPriceMap blockUserPrices;
-    if (!GetBlockUserPrices(coinPricePair, blockUserPrices) || blockUserPrices.empty()) {
-        return CMedianPriceDetail(); // {0, 0}
+// the k-th (from 0) price of sorted - removed + added, removed must be a part of sorted, both sorted too
+static uint64_t SelectPrice(const CSortedPrices &sorted, const vector<uint64_t> &removed,
+                            const vector<uint64_t> &added, const size_t k) {
+    auto countNotGreater = [&](const uint64_t price) {
+        return sorted.CountNotGreater(price) - (upper_bound(removed.begin(), removed.end(), price) - removed.begin()) +
+               (upper_bound(added.begin(), added.end(), price) - added.begin());
+    };
+
+    // the k-th price is the least price with count > k, the least one of sorted or the least one of added
+    size_t low = 0, high = sorted.Size();
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (countNotGreater(sorted.At(mid)) > k)
+            high = mid;
+        else
+            low = mid + 1;
     }
+    uint64_t price = low < sorted.Size() ? sorted.At(low) : std::numeric_limits<uint64_t>::max();
 
-    // 2. compute block median price.
-    return ComputeBlockMedianPrice(blockHeight, slideWindow, blockUserPrices);
+    auto addedIt = partition_point(added.begin(), added.end(),
+                                   [&](const uint64_t addedPrice) { return countNotGreater(addedPrice) <= k; });
+    if (addedIt != added.end())
+        price = std::min(price, *addedIt);
+
+    return price;
 }
 
 CMedianPriceDetail CPricePointMemCache::ComputeBlockMedianPrice(const HeightType blockHeight, const uint64_t slideWindow,
-                                                      const BlockUserPriceMap &blockUserPrices) {
-    // for (const auto &item : blockUserPrices) {
-    //     string price;
-    //     for (const auto &userPrice : item.second) {
-    //         price += strprintf("{user:%s, price:%lld}", userPrice.first.ToString(), userPrice.second);
-    //     }
-
-    //     LogPrint(BCLog::PRICEFEED, "CPricePointMemCache::ComputeBlockMedianPrice, height: %d, userPrice: %s\n",
-    //              item.first, price);
-    // }
-
-    CMedianPriceDetail priceDetail;
-    vector<uint64_t> prices;
+                                                                const PriceCoinPair &coinPricePair) {
     HeightType beginBlockHeight = 0;
     if (blockHeight > slideWindow)
         beginBlockHeight = blockHeight - slideWindow;
-    for (HeightType height = blockHeight; height > beginBlockHeight; --height) {
-        const auto &iter = blockUserPrices.find(height);
-        if (iter != blockUserPrices.end()) {
-            if (height == blockHeight)
-                priceDetail.last_feed_height = blockHeight; // current block has price feed
-
-            for (const auto &userPrice : iter->second) {
-                prices.push_back(userPrice.second);
-            }
+
+    // 1. merge the block user prices of the child caches, they override the ones of the root cache by height
+    const CPricePointMemCache *pRoot = this;
+    set<HeightType> expired;
+    BlockUserPriceMap viewPrices;
+    for (; pRoot->pBase != nullptr; pRoot = pRoot->pBase) {
+        pRoot->GetViewBlockUserPrices(coinPricePair, expired, viewPrices);
+    }
+
+    CMedianPriceDetail priceDetail;
+    vector<uint64_t> added;
+    for (const auto &item : viewPrices) {
+        if (item.first <= beginBlockHeight || item.first > blockHeight)
+            continue;
+        if (item.first == blockHeight)
+            priceDetail.last_feed_height = blockHeight; // current block has price feed
+
+        for (const auto &userPrice : item.second)
+            added.push_back(userPrice.second);
+    }
+
+    // 2. the root prices out of the window or overridden
+    static const CSortedPrices emptyPrices;
+    const CSortedPrices *pSorted = &emptyPrices;
+    vector<uint64_t> removed;
+    auto rootIt = pRoot->mapCoinPricePointCache.find(coinPricePair);
+    if (rootIt != pRoot->mapCoinPricePointCache.end()) {
+        pSorted = &rootIt->second.GetSortedPrices();
+        const BlockUserPriceMap &rootPrices = rootIt->second.GetBlockUserPrices();
+        auto removeBlock = [&](const map<CRegID, uint64_t> &userPrices) {
+            for (const auto &userPrice : userPrices)
+                removed.push_back(userPrice.second);
+        };
+
+        for (auto it = rootPrices.begin(); it != rootPrices.end() && it->first <= beginBlockHeight; ++it)
+            removeBlock(it->second);
+        for (auto it = rootPrices.upper_bound(blockHeight); it != rootPrices.end(); ++it)
+            removeBlock(it->second);
+
+        set<HeightType> overridden = expired;
+        for (const auto &item : viewPrices)
+            overridden.insert(item.first);
+        for (const auto height : overridden) {
+            if (height <= beginBlockHeight || height > blockHeight)
+                continue;
+            auto it = rootPrices.find(height);
+            if (it != rootPrices.end())
+                removeBlock(it->second);
         }
+
+        if (!overridden.count(blockHeight) && rootIt->second.HasUserPrice(blockHeight))
+            priceDetail.last_feed_height = blockHeight; // current block has price feed
     }
 
-    // for (const auto &item : prices) {
-    //     LogPrint(BCLog::PRICEFEED, "CPricePointMemCache::ComputeBlockMedianPrice, found a candidate price: %llu\n", item);
-    // }
+    // 3. the median of the window
+    const size_t size = pSorted->Size() - removed.size() + added.size();
+    if (size == 0)
+        return CMedianPriceDetail(); // {0, 0}
 
-    priceDetail.price = ComputeMedianNumber(prices);
+    sort(removed.begin(), removed.end());
+    sort(added.begin(), added.end());
+    if (size % 2 == 0) {
+        priceDetail.price = (SelectPrice(*pSorted, removed, added, size / 2 - 1) +
+                             SelectPrice(*pSorted, removed, added, size / 2)) / 2;
+    } else {
+        priceDetail.price = SelectPrice(*pSorted, removed, added, size / 2);
+    }
     LogPrint(BCLog::PRICEFEED, "[%d] computed median number: %llu\n", blockHeight, priceDetail.price);
 
     return priceDetail;
 }
 
-uint64_t CPricePointMemCache::ComputeMedianNumber(vector<uint64_t> &numbers) {
-    uint32_t size = numbers.size();
-    if (size < 2) {
-        return size == 0 ? 0 : numbers[0];
-    }
-    sort(numbers.begin(), numbers.end());
-    return (size % 2 == 0) ? (numbers[size / 2 - 1] + numbers[size / 2]) / 2 : numbers[size / 2];
-}
-
 CMedianPriceDetail CPricePointMemCache::GetMedianPrice(const HeightType blockHeight, const uint64_t slideWindow,
                                              const PriceCoinPair &coinPricePair) {
     CMedianPriceDetail priceDetail;
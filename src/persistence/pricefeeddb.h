@@ -27,16 +27,45 @@ class CConsecutiveBlockPrice;
 typedef map<HeightType /* block height */, map<CRegID, uint64_t /* price */>> BlockUserPriceMap;
 typedef map<PriceCoinPair, CConsecutiveBlockPrice> CoinPricePointMap;
 
+/**
+ * Sorted multiset of prices, an order statistic structure: the k-th price and the count of the prices not
+ * greater than a price are read in O(log n). The prices of a slide window are a few thousand at most, moving
+ * them in a vector on insert/erase costs less than the node allocations of a tree.
+ */
+class CSortedPrices {
+public:
+    void Insert(const uint64_t price);
+    void Erase(const uint64_t price);
+
+    size_t Size() const { return prices.size(); }
+    uint64_t At(const size_t index) const { return prices[index]; }
+    // count of the prices <= price
+    size_t CountNotGreater(const uint64_t price) const;
+
+private:
+    vector<uint64_t> prices;
+};
+
 // Price Points in 11 consecutive blocks
 class CConsecutiveBlockPrice {
 public:
     void AddUserPrice(const HeightType blockHeight, const CRegID &regId, const uint64_t price);
-    // delete user price by specific block height.
+    // add the user price only if the user has no price at blockHeight yet
+    void EmplaceUserPrice(const HeightType blockHeight, const CRegID &regId, const uint64_t price);
+    // delete user price by specific block height, keeps an empty item to hide the prices of the base cache
     void DeleteUserPrice(const HeightType blockHeight);
-    bool ExistBlockUserPrice(const HeightType blockHeight, const CRegID &regId);
+    // erase the item of the block height
+    void EraseBlock(const HeightType blockHeight);
+    bool ExistBlockUserPrice(const HeightType blockHeight, const CRegID &regId) const;
+    bool HasUserPrice(const HeightType blockHeight) const;
 
-public:
+    const BlockUserPriceMap &GetBlockUserPrices() const { return mapBlockUserPrices; }
+    // the prices of all the block heights, updated with every change
+    const CSortedPrices &GetSortedPrices() const { return sortedPrices; }
+
+private:
     BlockUserPriceMap mapBlockUserPrices;
+    CSortedPrices sortedPrices;
 };
 
 class CPricePointMemCache {
@@ -47,7 +76,12 @@ public:
 
 public:
     bool ReleadBlocks(CSysParamDBCache &sysParamCache, CBlockIndex *pTipBlockIdx);
+    // add the prices of a block connected after the snapshot was taken, like connecting the block does
+    bool ReplayBlock(CSysParamDBCache &sysParamCache, CBlockIndex *pBlockIdx, const CBlock &block);
     bool PushBlock(CSysParamDBCache &sysParamCache, CBlockIndex *pTipBlockIdx);
+    // delete the prices of the block heights <= expireHeight, also the ones left behind when the slide window
+    // shrinks, so the root cache keeps only the window
+    void ExpireBlocks(const HeightType expireHeight);
     bool UndoBlock(CSysParamDBCache &sysParamCache, CBlockIndex *pTipBlockIdx, CBlock &block);
     bool AddPrice(const HeightType blockHeight, const CRegID &regId, const vector<CPricePoint> &pps);
 
@@ -57,6 +91,18 @@ public:
     void SetBaseViewPtr(CPricePointMemCache *pBaseIn);
     void Flush();
 
+    // the block user prices of the root cache, for the snapshot of the memory caches
+    map<PriceCoinPair, BlockUserPriceMap> GetSnapshot() const;
+    void LoadSnapshot(const map<PriceCoinPair, BlockUserPriceMap> &snapshot);
+
+    /**
+     * Median of the prices in the block heights (blockHeight - slideWindow, blockHeight]. The sorted prices of
+     * the root cache are adjusted by the few block heights the child caches override and the ones out of the
+     * window, instead of collecting and sorting the prices of the whole window.
+     */
+    CMedianPriceDetail ComputeBlockMedianPrice(const HeightType blockHeight, const uint64_t slideWindow,
+                                               const PriceCoinPair &coinPricePair);
+
 private:
     CMedianPriceDetail GetMedianPrice(const HeightType blockHeight, const uint64_t slideWindow, const PriceCoinPair &coinPricePair);
 
@@ -68,14 +114,9 @@ private:
 
     void BatchWrite(const CoinPricePointMap &mapCoinPricePointCacheIn);
 
-    bool GetBlockUserPrices(const PriceCoinPair &coinPricePair, set<HeightType> &expired, BlockUserPriceMap &blockUserPrices);
-    bool GetBlockUserPrices(const PriceCoinPair &coinPricePair, BlockUserPriceMap &blockUserPrices);
-
-    CMedianPriceDetail ComputeBlockMedianPrice(const HeightType blockHeight, const uint64_t slideWindow,
-                                     const PriceCoinPair &coinPricePair);
-    CMedianPriceDetail ComputeBlockMedianPrice(const HeightType blockHeight, const uint64_t slideWindow,
-                                     const BlockUserPriceMap &blockUserPrices);
-    static uint64_t ComputeMedianNumber(vector<uint64_t> &numbers);
+    // merge the block user prices of this cache into the ones of the upper caches, not including the base
+    void GetViewBlockUserPrices(const PriceCoinPair &coinPricePair, set<HeightType> &expired,
+                                BlockUserPriceMap &blockUserPrices) const;
 
 private:
     CoinPricePointMap mapCoinPricePointCache;  // coinPriceType -> consecutiveBlockPrice
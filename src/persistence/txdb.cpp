@@ -14,65 +14,280 @@
 
 #include <algorithm>
 
-bool CTxMemCache::AddBlockTx(const CBlock &block) {
-    for (auto &ptx : block.vptx) {
-        txids[ptx->GetHash()] = true;
+////////////////////////////////////////////////////////////////////////////////
+// class CTxBloomFilter
+
+void CTxBloomFilter::Reset(uint64_t capacityIn) {
+    capacity = std::max<uint64_t>(capacityIn, MIN_CAPACITY);
+    // about 12 counters per txid
+    uint64_t blockCount = (capacity * 12 + BLOCK_COUNTERS - 1) / BLOCK_COUNTERS;
+    counters.assign(blockCount * BLOCK_COUNTERS, 0);
+}
+
+uint64_t CTxBloomFilter::GetBlockOffset(const uint256 &txid, uint64_t &probeBits) const {
+    // the low bytes feed the hasher of the txid index, use the other bytes for the block and the probes
+    uint64_t blockBits;
+    memcpy(&blockBits, txid.begin() + 8, 8);
+    memcpy(&probeBits, txid.begin() + 16, 8);
+    uint64_t blockCount = counters.size() / BLOCK_COUNTERS;
+    return (blockBits % blockCount) * BLOCK_COUNTERS;
+}
+
+void CTxBloomFilter::Insert(const uint256 &txid) {
+    if (counters.empty())
+        Reset(MIN_CAPACITY);
+
+    uint64_t probeBits;
+    uint8_t *pBlock = &counters[GetBlockOffset(txid, probeBits)];
+    for (uint32_t i = 0; i < PROBE_COUNT; i++) {
+        uint8_t &counter = pBlock[(probeBits >> (i * 6)) % BLOCK_COUNTERS];
+        if (counter < UINT8_MAX)
+            counter++;
+    }
+}
+
+void CTxBloomFilter::Erase(const uint256 &txid) {
+    if (counters.empty())
+        return;
+
+    uint64_t probeBits;
+    uint8_t *pBlock = &counters[GetBlockOffset(txid, probeBits)];
+    for (uint32_t i = 0; i < PROBE_COUNT; i++) {
+        uint8_t &counter = pBlock[(probeBits >> (i * 6)) % BLOCK_COUNTERS];
+        // a saturated counter has lost its count
+        if (counter > 0 && counter < UINT8_MAX)
+            counter--;
+    }
+}
+
+bool CTxBloomFilter::MayContain(const uint256 &txid) const {
+    if (counters.empty())
+        return true;
+
+    uint64_t probeBits;
+    const uint8_t *pBlock = &counters[GetBlockOffset(txid, probeBits)];
+    for (uint32_t i = 0; i < PROBE_COUNT; i++) {
+        if (pBlock[(probeBits >> (i * 6)) % BLOCK_COUNTERS] == 0)
+            return false;
     }
     return true;
 }
 
-bool CTxMemCache::RemoveBlockTx(const CBlock &block) {
+////////////////////////////////////////////////////////////////////////////////
+// class CTxMemCache
+
+bool CTxMemCache::AddBlockTx(const CBlock &block) {
+    vector<uint256> blockTxids;
+    blockTxids.reserve(block.vptx.size());
     for (auto &ptx : block.vptx) {
-        if (pBase == nullptr) {
-            txids.erase(ptx->GetHash());
-        } else {
-            txids[ptx->GetHash()] = false;
-        }
+        blockTxids.push_back(ptx->GetHash());
     }
+
+    AddTxIds(block.GetHeight(), blockTxids);
+    return true;
+}
+
+bool CTxMemCache::RemoveBlockTx(int32_t height) {
+    RetireHeight(height);
     return true;
 }
 
 bool CTxMemCache::HasTx(const uint256 &txid) {
+    int32_t height;
+    return GetTxHeight(txid, height);
+}
+
+bool CTxMemCache::GetTxHeight(const uint256 &txid, int32_t &height) const {
+    if (pBase == nullptr) {
+        if (buckets.empty() || !bloomFilter.MayContain(txid))
+            return false;
+
+        auto it = txids.find(txid);
+        if (it == txids.end())
+            return false;
+
+        // the index entry is stale if its bucket is retired or reused
+        const Bucket &bucket = buckets[it->second % buckets.size()];
+        if (bucket.height != it->second || !bucket.live)
+            return false;
+
+        height = it->second;
+        return true;
+    }
+
     auto it = txids.find(txid);
     if (it != txids.end()) {
-        return it->second;
+        height = it->second;
+        return true;
+    }
+
+    return pBase->GetTxHeight(txid, height) && !retiredHeights.count(height);
+}
+
+void CTxMemCache::AddTxIds(int32_t height, const vector<uint256> &txidsIn) {
+    if (pBase == nullptr) {
+        Bucket &bucket = GetBucket(height);
+        ReleaseBucket(bucket);
+
+        bucket.height = height;
+        bucket.live   = true;
+        bucket.txids  = txidsIn;
+        for (const auto &txid : txidsIn) {
+            txids[txid] = height;
+            bloomFilter.Insert(txid);
+        }
+
+        bucketTxCount += txidsIn.size();
+        if (bucketTxCount > bloomFilter.GetCapacity())
+            ResizeBloomFilter();
+
+        return;
     }
 
-    if (pBase != nullptr) {
-        return pBase->HasTx(txid);
+    // the block replaces the one of the same height
+    RetireHeight(height);
+    for (const auto &txid : txidsIn) {
+        txids[txid] = height;
     }
-    return false;
+    blocks[height] = txidsIn;
 }
 
-void CTxMemCache::BatchWrite(const TxIdMap &txidsIn) {
-    for (const auto &item : txidsIn) {
-        if (pBase == nullptr && !item.second) {
-            txids.erase(item.first);
-        } else {
-            txids[item.first] = item.second;
+void CTxMemCache::RetireHeight(int32_t height) {
+    if (pBase == nullptr) {
+        if (buckets.empty())
+            return;
+
+        Bucket &bucket = buckets[height % buckets.size()];
+        if (bucket.height == height)
+            bucket.live = false;
+
+        return;
+    }
 
+    auto it = blocks.find(height);
+    if (it != blocks.end()) {
+        for (const auto &txid : it->second) {
+            auto txIt = txids.find(txid);
+            if (txIt != txids.end() && txIt->second == height)
+                txids.erase(txIt);
         }
+        blocks.erase(it);
+    }
+    retiredHeights.insert(height);
+}
+
+CTxMemCache::Bucket &CTxMemCache::GetBucket(int32_t height) {
+    if (buckets.empty()) {
+        // one more bucket than the cached blocks, so a block can be added before the oldest one is removed
+        buckets.resize(std::max<int32_t>(SysCfg().GetTxCacheHeight(), 1) + 1);
+        bloomFilter.Reset(CTxBloomFilter::MIN_CAPACITY);
+    }
+
+    return buckets[height % buckets.size()];
+}
+
+void CTxMemCache::ReleaseBucket(Bucket &bucket) {
+    for (const auto &txid : bucket.txids) {
+        auto it = txids.find(txid);
+        if (it != txids.end() && it->second == bucket.height)
+            txids.erase(it);
+
+        bloomFilter.Erase(txid);
+    }
+
+    bucketTxCount -= bucket.txids.size();
+    bucket.height = -1;
+    bucket.live   = false;
+    vector<uint256>().swap(bucket.txids);
+}
+
+void CTxMemCache::ResizeBloomFilter() {
+    // the txids of the retired buckets are still counted, they are erased from the filter when released
+    bloomFilter.Reset(bucketTxCount * 2);
+    for (const auto &bucket : buckets) {
+        for (const auto &txid : bucket.txids)
+            bloomFilter.Insert(txid);
+    }
+}
+
+void CTxMemCache::BatchWrite(const set<int32_t> &retiredHeightsIn, const BlockTxIdsMap &blocksIn) {
+    for (int32_t height : retiredHeightsIn) {
+        RetireHeight(height);
+    }
+
+    for (const auto &item : blocksIn) {
+        AddTxIds(item.first, item.second);
     }
 }
 
 void CTxMemCache::Flush() {
     assert(pBase);
 
-    pBase->BatchWrite(txids);
+    pBase->BatchWrite(retiredHeights, blocks);
+    Clear();
+}
+
+void CTxMemCache::Clear() {
     txids.clear();
+    buckets.clear();
+    bloomFilter   = CTxBloomFilter();
+    bucketTxCount = 0;
+    blocks.clear();
+    retiredHeights.clear();
+}
+
+uint64_t CTxMemCache::GetSize() {
+    if (pBase != nullptr)
+        return txids.size();
+
+    uint64_t size = 0;
+    for (const auto &bucket : buckets) {
+        if (bucket.live)
+            size += bucket.txids.size();
+    }
+    return size;
 }
 
-void CTxMemCache::Clear() { txids.clear(); }
+CTxMemCache::Stats CTxMemCache::GetStats() const {
+    Stats stats;
+    for (const auto &bucket : buckets) {
+        if (bucket.live) {
+            stats.count += bucket.txids.size();
+            stats.blocks++;
+        }
+    }
+    stats.bloom_bytes = bloomFilter.GetMemUsage();
+    // estimated memory: the index nodes and buckets, the txids of the buckets and the bloom filter
+    stats.bytes = txids.size() * (sizeof(uint256) + sizeof(int32_t) + 3 * sizeof(void *)) +
+                  buckets.size() * sizeof(Bucket) + bucketTxCount * sizeof(uint256) + stats.bloom_bytes;
+    return stats;
+}
 
-uint64_t CTxMemCache::GetSize() { return txids.size(); }
+CTxMemCache::BlockTxIdsMap CTxMemCache::GetSnapshot() const {
+    assert(pBase == nullptr);
+    BlockTxIdsMap ret;
+    for (const auto &bucket : buckets) {
+        if (bucket.live)
+            ret[bucket.height] = bucket.txids;
+    }
+    return ret;
+}
+
+void CTxMemCache::LoadSnapshot(const BlockTxIdsMap &blocksIn) {
+    assert(pBase == nullptr);
+    for (const auto &item : blocksIn)
+        AddTxIds(item.first, item.second);
+}
 
 Object CTxMemCache::ToJsonObj() const {
     Array txArray;
-    for (auto &item : txids) {
-        Object obj;
-        obj.push_back(Pair("txid", item.first.ToString()));
-        obj.push_back(Pair("existed", item.second));
-        txArray.push_back(obj);
+    for (const auto &item : (pBase == nullptr ? GetSnapshot() : blocks)) {
+        for (const auto &txid : item.second) {
+            Object obj;
+            obj.push_back(Pair("txid", txid.ToString()));
+            obj.push_back(Pair("height", item.first));
+            txArray.push_back(obj);
+        }
     }
 
     Object txCacheObj;
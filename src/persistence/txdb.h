@@ -15,14 +15,63 @@
 #include "block.h"
 
 #include <map>
+#include <set>
 #include <vector>
 
 using namespace std;
 using namespace json_spirit;
 
+/**
+ * Counting blocked bloom filter of txids. All the probes of a txid fall into one cache line of counters, and a
+ * counter saturated at the max is never decremented again, so a txid can be removed without false negatives.
+ */
+class CTxBloomFilter {
+public:
+    static const uint32_t BLOCK_COUNTERS = 64;  // one cache line of counters
+    static const uint32_t PROBE_COUNT    = 4;
+    static const uint32_t MIN_CAPACITY   = 1 << 14;
+
+public:
+    CTxBloomFilter() {}
+
+    // reset to hold up to capacity txids with about one percent of false positives
+    void Reset(uint64_t capacity);
+
+    void Insert(const uint256 &txid);
+    void Erase(const uint256 &txid);
+    bool MayContain(const uint256 &txid) const;
+
+    uint64_t GetCapacity() const { return capacity; }
+    uint64_t GetMemUsage() const { return counters.size(); }
+
+private:
+    uint64_t GetBlockOffset(const uint256 &txid, uint64_t &probeBits) const;
+
+private:
+    vector<uint8_t> counters;
+    uint64_t capacity = 0;
+};
+
+/**
+ * The txids of the latest GetTxCacheHeight() blocks, to detect the duplicated txs.
+ *
+ * The root cache keeps a ring buffer of the per-block txids indexed by block height, a txid index pointing to
+ * the height of its block, and a bloom filter in front of the index for the fast negatives. Removing a block
+ * only retires its bucket, the stale index entries of a retired bucket are erased when the bucket is reused.
+ * A child cache records the blocks added and the heights removed, and writes them to the base by Flush().
+ */
 class CTxMemCache {
 public:
-    typedef unordered_map<uint256, bool, CUint256Hasher> TxIdMap;
+    typedef unordered_map<uint256, int32_t, CUint256Hasher> TxIdMap;  // txid -> block height
+    typedef map<int32_t, vector<uint256>> BlockTxIdsMap;                // block height -> txids
+
+    struct Stats {
+        uint64_t count       = 0;
+        uint64_t blocks      = 0;
+        uint64_t bytes       = 0;
+        uint64_t bloom_bytes = 0;
+    };
+
 public:
     CTxMemCache() : pBase(nullptr) {}
     CTxMemCache(CTxMemCache *pBaseIn) : pBase(pBaseIn) {}
@@ -31,7 +80,8 @@ public:
     bool HasTx(const uint256 &txid);
 
     bool AddBlockTx(const CBlock &block);
-    bool RemoveBlockTx(const CBlock &block);
+    // remove the txids of the block at the height, no need to read the block
+    bool RemoveBlockTx(int32_t height);
 
     void Clear();
     void SetBaseViewPtr(CTxMemCache *pBaseIn) { pBase = pBaseIn; }
@@ -39,12 +89,38 @@ public:
 
     Object ToJsonObj() const;
     uint64_t GetSize();
+    Stats GetStats() const;
+
+    // the txids of the blocks in the root cache, for the snapshot of the memory caches
+    BlockTxIdsMap GetSnapshot() const;
+    void LoadSnapshot(const BlockTxIdsMap &blocksIn);
 
 private:
-    void BatchWrite(const TxIdMap &txidsIn);
+    struct Bucket {
+        int32_t height = -1;
+        bool live      = false;  // false after retired, the txids are kept until the bucket is reused
+        vector<uint256> txids;
+    };
+
+    bool GetTxHeight(const uint256 &txid, int32_t &height) const;
+    void AddTxIds(int32_t height, const vector<uint256> &txidsIn);
+    void RetireHeight(int32_t height);
+    void BatchWrite(const set<int32_t> &retiredHeightsIn, const BlockTxIdsMap &blocksIn);
+
+    // root only
+    Bucket &GetBucket(int32_t height);
+    void ReleaseBucket(Bucket &bucket);
+    void ResizeBloomFilter();
 
 private:
     TxIdMap txids;
+    // root: the ring buffer of the per-block txids
+    vector<Bucket> buckets;
+    CTxBloomFilter bloomFilter;
+    uint64_t bucketTxCount = 0;
+    // child: the blocks added and the heights removed in this cache
+    BlockTxIdsMap blocks;
+    set<int32_t> retiredHeights;
     CTxMemCache *pBase;
 };
 
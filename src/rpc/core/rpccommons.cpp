@@ -262,17 +262,11 @@ Object GetTxDetailJSON(const uint256& txid) {
         if (SysCfg().IsTxIndex()) {
             CDiskTxPos postx;
             if (pCw->blockCache.ReadTxIndex(txid, postx)) {
-                CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
                 CBlockHeader header;
+                if (!ReadBaseTxFromDisk(postx, header, pBaseTx))
+                    throw runtime_error(strprintf("%s : Deserialize or I/O error", __func__).c_str());
 
-                try {
-                    file >> header;
-                    fseek(file, postx.nTxOffset, SEEK_CUR);
-                    file >> pBaseTx;
-                    obj = GetTxDetailJSON(*pCw, header, pBaseTx, postx.tx_cord);
-                } catch (std::exception &e) {
-                    throw runtime_error(strprintf("%s : Deserialize or I/O error - %s", __func__, e.what()).c_str());
-                }
+                obj = GetTxDetailJSON(*pCw, header, pBaseTx, postx.tx_cord);
 
                 return obj;
             }
@@ -218,6 +218,7 @@ extern Value listmintxfees(const Array& params, bool fHelp);
 // debug only
 extern Value dumpdb(const Array& params, bool fHelp);
 extern Value getmemstat(const Array& params, bool fHelp);
+extern Value getdbstats(const Array& params, bool fHelp);
 
 extern Value startcommontpstest(const Array& params, bool fHelp);
 extern Value startcontracttpstest(const Array& params, bool fHelp);
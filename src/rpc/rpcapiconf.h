@@ -194,6 +194,7 @@ static const CRPCCommand vRPCCommands[] =
     /* debug */
     { "dumpdb",                         &dumpdb,                            true,       false,       false    },
     { "getmemstat",                     &getmemstat,                        true,       false,       false    },
+    { "getdbstats",                     &getdbstats,                        true,       false,       false    },
 
 #ifdef ENABLE_GPERFTOOLS
     { "startheapprofiler",              &startheapprofiler,                 true,       false,       false    },
@@ -117,7 +117,8 @@ Value getrawmempool(const Array& params, bool fHelp)
     if (fHelp || params.size() > 1)
         throw runtime_error(
             "getrawmempool ( verbose )\n"
-            "\nReturns all transaction ids in memory pool as a json or an array of string transaction ids.\n"
+            "\nReturns all transaction ids in memory pool as a json or an array of string transaction ids,\n"
+            "ordered by block producing priority, the highest first.\n"
             "\nArguments:\n"
             "1. verbose           (boolean, optional, default=false) true for a json object, false for array of "
             "transaction ids\n"
@@ -144,12 +145,18 @@ Value getrawmempool(const Array& params, bool fHelp)
     if (params.size() > 0)
         fVerbose = params[0].get_bool();
 
+    vector<uint256> txids;
+    mempool.QueryHashByPriority(txids);
+
     if (fVerbose) {
         LOCK(mempool.cs);
         Object obj;
-        for (const auto& entry : mempool.memPoolTxs) {
-            const uint256& hash      = entry.first;
-            const CTxMemPoolEntry& mpe = entry.second;
+        for (const auto& hash : txids) {
+            auto it = mempool.memPoolTxs.find(hash);
+            if (it == mempool.memPoolTxs.end())
+                continue;
+
+            const CTxMemPoolEntry& mpe = it->second;
             Object info;
             info.push_back(Pair("size",         (int) mpe.GetTxSize()));
             info.push_back(Pair("fees_type",    std::get<0>(mpe.GetFees())));
@@ -162,9 +169,6 @@ Value getrawmempool(const Array& params, bool fHelp)
         }
         return obj;
     } else {
-        vector<uint256> txids;
-        mempool.QueryHash(txids);
-
         Array arr;
         for (const auto& hash : txids) {
             arr.push_back(hash.ToString());
@@ -723,23 +723,84 @@ Value getmemstat(const Array& params, bool fHelp) {
     // signatureCache
     {
         Object statObj;
-        uint64_t totalSz = 0;
-        {
-            uint64_t cnt = signatureCache.setValid.size();
-            statObj.push_back(Pair("count", cnt));
-            if (cnt > 0) {
-                const auto &item = signatureCache.setValid.begin();
-                // need to calc size for each idx?
-                totalSz = sizeof(signatureCache) + cnt * (sizeof(item));
-            }
-        }
-        statObj.push_back(Pair("size", SizeToString(totalSz)));
-        statObj.push_back(Pair("size_bytes", totalSz));
+        CSignatureCache::Stats stats = signatureCache.GetStats();
+        statObj.push_back(Pair("count", stats.entries));
+        statObj.push_back(Pair("size", SizeToString(stats.bytes)));
+        statObj.push_back(Pair("size_bytes", stats.bytes));
+        statObj.push_back(Pair("max_size_bytes", stats.maxBytes));
+        statObj.push_back(Pair("hits", stats.hits));
+        statObj.push_back(Pair("misses", stats.misses));
+        statObj.push_back(Pair("evictions", stats.evictions));
 
         obj.push_back(Pair("signature_cache", statObj));
 
     }
 
+    // txCache
+    {
+        Object statObj;
+        CTxMemCache::Stats stats = pCdMan->pTxCache->GetStats();
+        statObj.push_back(Pair("count", stats.count));
+        statObj.push_back(Pair("blocks", stats.blocks));
+        statObj.push_back(Pair("size", SizeToString(stats.bytes)));
+        statObj.push_back(Pair("size_bytes", stats.bytes));
+        statObj.push_back(Pair("bloom_size_bytes", stats.bloom_bytes));
+
+        obj.push_back(Pair("tx_cache", statObj));
+    }
+
+    // recentBlockCache
+    {
+        Object statObj;
+        CRecentBlockCache::Stats stats = recentBlockCache.GetStats();
+        statObj.push_back(Pair("count", stats.count));
+        statObj.push_back(Pair("size", SizeToString(stats.bytes)));
+        statObj.push_back(Pair("size_bytes", stats.bytes));
+        statObj.push_back(Pair("max_size_bytes", stats.maxBytes));
+        statObj.push_back(Pair("hits", stats.hits));
+        statObj.push_back(Pair("misses", stats.misses));
+
+        obj.push_back(Pair("recent_block_cache", statObj));
+    }
+
+    // db cache lookups
+    {
+        Object statObj;
+        for (int32_t i = dbk::EMPTY + 1; i < dbk::PREFIX_COUNT; i++) {
+            dbk::PrefixType prefixType = (dbk::PrefixType)i;
+            CDbCacheLookupStats &stats = GetDbCacheLookupStats(prefixType);
+            if (stats.hits == 0 && stats.misses == 0)
+                continue;
+
+            Object prefixObj;
+            prefixObj.push_back(Pair("hits", (uint64_t)stats.hits));
+            prefixObj.push_back(Pair("absent_hits", (uint64_t)stats.absent_hits));
+            prefixObj.push_back(Pair("misses", (uint64_t)stats.misses));
+            statObj.push_back(Pair(dbk::GetKeyPrefix(prefixType), prefixObj));
+        }
+
+        obj.push_back(Pair("db_cache_lookups", statObj));
+    }
+
+    // db cache copy on write
+    {
+        Object statObj;
+        for (int32_t i = dbk::EMPTY + 1; i < dbk::PREFIX_COUNT; i++) {
+            dbk::PrefixType prefixType = (dbk::PrefixType)i;
+            CDbCacheCowStats &stats = GetDbCacheCowStats(prefixType);
+            if (stats.shared_reads == 0 && stats.cow_copies == 0 && stats.owned_writes == 0)
+                continue;
+
+            Object prefixObj;
+            prefixObj.push_back(Pair("shared_reads", (uint64_t)stats.shared_reads));
+            prefixObj.push_back(Pair("cow_copies", (uint64_t)stats.cow_copies));
+            prefixObj.push_back(Pair("owned_writes", (uint64_t)stats.owned_writes));
+            statObj.push_back(Pair(dbk::GetKeyPrefix(prefixType), prefixObj));
+        }
+
+        obj.push_back(Pair("db_cache_cow", statObj));
+    }
+
     // mempool;
     {
         Object statObj;
@@ -747,11 +808,7 @@ Value getmemstat(const Array& params, bool fHelp) {
         {
             LOCK(mempool.cs);
             statObj.push_back(Pair("count", (int64_t)mempool.memPoolTxs.size()));
-            if (mempool.memPoolTxs.size() > 0) {
-                const auto &item = *mempool.memPoolTxs.rbegin();
-                // need to calc size for each idx?
-                totalSz = sizeof(mempool.memPoolTxs) + mempool.memPoolTxs.size() * (sizeof(item));
-            }
+            totalSz = mempool.GetMemUsage();
         }
         statObj.push_back(Pair("size", SizeToString(totalSz)));
         statObj.push_back(Pair("size_bytes", totalSz));
@@ -763,6 +820,66 @@ Value getmemstat(const Array& params, bool fHelp) {
     return obj;
 }
 
+Value getdbstats(const Array& params, bool fHelp) {
+    if (fHelp || params.size() != 0) {
+        throw runtime_error(
+            "getdbstats \n"
+            "\nget the LevelDB stats of the chain state databases.\n"
+            "\nArguments:\n"
+
+            "\nResult: the approximate size of every db name, and the tuning, block cache, "
+            "table files and leveldb.stats of every store\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getdbstats", "") +
+            "\nAs json rpc\n" +
+            HelpExampleRpc("getdbstats", ""));
+    }
+
+    Object dbsObj;
+    Object storesObj;
+    set<CLevelDBWrapper*> stores;
+    for (CDBAccess *pDbAccess : pCdMan->GetDbAccesses()) {
+        const auto &spDb = pDbAccess->GetDb();
+        const string &dbName = ::GetDbName(pDbAccess->GetDbNameType());
+        // with -singlestatedb all the db names share one store
+        const string &storeName = SysCfg().GetBoolArg("-singlestatedb", false) ? STATE_DB_NAME : dbName;
+
+        Object dbObj;
+        uint64_t size = pDbAccess->GetApproximateSize();
+        dbObj.push_back(Pair("store", storeName));
+        dbObj.push_back(Pair("approximate_size", SizeToString(size)));
+        dbObj.push_back(Pair("approximate_size_bytes", size));
+        dbsObj.push_back(Pair(dbName, dbObj));
+
+        if (!stores.insert(spDb.get()).second)
+            continue;
+
+        Object storeObj;
+        const CDbProfile &profile = spDb->GetProfile();
+        storeObj.push_back(Pair("bloom_bits", (uint64_t)profile.bloom_bits));
+        storeObj.push_back(Pair("block_size", (uint64_t)profile.block_size));
+        storeObj.push_back(Pair("max_open_files", (uint64_t)profile.max_open_files));
+        storeObj.push_back(Pair("write_buffer_size", (uint64_t)profile.write_buffer_size));
+        storeObj.push_back(Pair("block_cache_size", (uint64_t)spDb->GetBlockCacheSize()));
+
+        Array filesArray;
+        string value;
+        for (int32_t level = 0; spDb->GetProperty(strprintf("leveldb.num-files-at-level%d", level), value); level++)
+            filesArray.push_back(atoi(value));
+        storeObj.push_back(Pair("files_at_level", filesArray));
+
+        if (spDb->GetProperty("leveldb.stats", value))
+            storeObj.push_back(Pair("stats", value));
+
+        storesObj.push_back(Pair(storeName, storeObj));
+    }
+
+    Object obj;
+    obj.push_back(Pair("dbs", dbsObj));
+    obj.push_back(Pair("stores", storesObj));
+    return obj;
+}
+
 #ifdef ENABLE_GPERFTOOLS
 
 #include <gperftools/heap-profiler.h>
@@ -6,45 +6,114 @@
 
 #include "sigcache.h"
 
+#include <limits>
+
+CSignatureCache::CSignatureCache() {
+    // the global cache is constructed before the random source is seeded, its nonce is drawn by Setup()
+    Reset(DEFAULT_MAX_SIG_CACHE_SIZE << 20);
+}
+
+void CSignatureCache::Setup(uint64_t maxBytesIn) {
+    GetRandBytes(nonce.begin(), 32);
+    Reset(maxBytesIn);
+}
+
+void CSignatureCache::Reset(uint64_t maxBytesIn) {
+    maxBytes = maxBytesIn;
+    uint64_t capacity = maxBytes / ENTRY_BYTES / STRIPE_COUNT;
+
+    for (auto& stripe : stripes) {
+        std::unique_lock<std::mutex> lock(stripe.mtx);
+        stripe.index.clear();
+        stripe.slots.clear();
+        stripe.slots.shrink_to_fit();
+        stripe.hand     = 0;
+        stripe.capacity = std::min<uint64_t>(capacity, std::numeric_limits<uint32_t>::max());
+    }
+}
+
 void CSignatureCache::ComputeEntry(uint256& entry, const uint256& sigHash,
                                    const std::vector<unsigned char>& vchSig,
                                    const CPubKey& pubKey) {
     CSHA256()
+        .Write(nonce.begin(), 32)
         .Write(sigHash.begin(), 32)
         .Write(&pubKey[0], pubKey.size())
-        .Write(&vchSig[0], vchSig.size())
+        .Write(vchSig.data(), vchSig.size())
         .Finalize(entry.begin());
 }
 
+CSignatureCache::Stripe& CSignatureCache::GetStripe(const uint256& entry) {
+    // the low bytes feed the hasher of the index, use the high bytes for the stripe
+    uint64_t high;
+    memcpy(&high, entry.begin() + 24, 8);
+    return stripes[high % STRIPE_COUNT];
+}
+
 bool CSignatureCache::Get(const uint256& sigHash, const std::vector<unsigned char>& vchSig,
                           const CPubKey& pubKey) {
     uint256 entry;
     ComputeEntry(entry, sigHash, vchSig, pubKey);
-    std::unique_lock<std::mutex> lock(mtx);
-    return setValid.count(entry);
+
+    Stripe& stripe = GetStripe(entry);
+    std::unique_lock<std::mutex> lock(stripe.mtx);
+    auto it = stripe.index.find(entry);
+    if (it == stripe.index.end()) {
+        misses++;
+        return false;
+    }
+
+    stripe.slots[it->second].referenced = true;
+    hits++;
+    return true;
 }
 
 void CSignatureCache::Set(const uint256& sigHash, const std::vector<unsigned char>& vchSig,
                           const CPubKey& pubKey) {
-    static int64_t nMaxCacheSize = SysCfg().GetArg("-maxsigcachesize", 50000);
-    if (nMaxCacheSize <= 0) return;
-
     uint256 entry;
     ComputeEntry(entry, sigHash, vchSig, pubKey);
 
-    std::unique_lock<std::mutex> lock(mtx);
-
-    while (static_cast<int64_t>(setValid.size()) > nMaxCacheSize) {
-        // Evict a random entry. Random because that helps
-        // foil would-be DoS attackers who might try to pre-generate
-        // and re-use a set of valid signatures just-slightly-greater
-        // than our cache size.
-        UnorderedHashSet::size_type s       = GetRand(setValid.bucket_count());
-        UnorderedHashSet::local_iterator it = setValid.begin(s);
-        if (it != setValid.end(s)) {
-            setValid.erase(*it);
-        }
+    Stripe& stripe = GetStripe(entry);
+    std::unique_lock<std::mutex> lock(stripe.mtx);
+    if (stripe.capacity == 0) return;
+
+    auto it = stripe.index.find(entry);
+    if (it != stripe.index.end()) {
+        stripe.slots[it->second].referenced = true;
+        return;
+    }
+
+    if (stripe.slots.size() < stripe.capacity) {
+        stripe.index.emplace(entry, stripe.slots.size());
+        stripe.slots.push_back({entry, false});
+        return;
     }
 
-    setValid.insert(entry);
+    // CLOCK: move the hand over the referenced slots, clearing their bits, and replace the first one that
+    // was not referenced since the last pass. Ends within two rounds.
+    while (stripe.slots[stripe.hand].referenced) {
+        stripe.slots[stripe.hand].referenced = false;
+        stripe.hand = (stripe.hand + 1) % stripe.slots.size();
+    }
+
+    Slot& victim = stripe.slots[stripe.hand];
+    stripe.index.erase(victim.entry);
+    victim.entry = entry;
+    stripe.index.emplace(entry, stripe.hand);
+    stripe.hand = (stripe.hand + 1) % stripe.slots.size();
+    evictions++;
+}
+
+CSignatureCache::Stats CSignatureCache::GetStats() {
+    Stats stats;
+    for (auto& stripe : stripes) {
+        std::unique_lock<std::mutex> lock(stripe.mtx);
+        stats.entries += stripe.slots.size();
+    }
+    stats.bytes     = stats.entries * ENTRY_BYTES;
+    stats.maxBytes  = maxBytes;
+    stats.hits      = hits;
+    stats.misses    = misses;
+    stats.evictions = evictions;
+    return stats;
 }
@@ -7,7 +7,10 @@
 #ifndef COIN_SIGCACHE_H
 #define COIN_SIGCACHE_H
 
+#include <array>
+#include <atomic>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "config/chainparams.h"
@@ -17,28 +20,80 @@
 #include "commons/uint256.h"
 #include "commons/util/util.h"
 
+/** -maxsigcachemb default (MiB) */
+static const int64_t DEFAULT_MAX_SIG_CACHE_SIZE = 32;
+/** max. -maxsigcachemb (MiB) */
+static const int64_t MAX_MAX_SIG_CACHE_SIZE = 16384;
+
 /**
  * Valid signature cache, to avoid doing expensive ECDSA signature checking
  * twice for every transaction (once when accepted into memory pool, and
  * again when accepted into the block chain)
+ *
+ * The cache is split into stripes with their own lock, so the signature checking threads do not contend on
+ * one mutex. Every stripe owns an equal share of the memory budget and evicts with the CLOCK policy: an entry
+ * hit since the hand passed it last time gets a second chance.
  */
 class CSignatureCache {
 public:
-    //! Entries are SHA256(signature hash || public key || signature):
-    UnorderedHashSet setValid;
-    std::mutex mtx;
+    static const uint32_t STRIPE_COUNT = 32;
+
+    struct Stats {
+        uint64_t entries   = 0;
+        uint64_t bytes     = 0;
+        uint64_t maxBytes  = 0;
+        uint64_t hits      = 0;
+        uint64_t misses    = 0;
+        uint64_t evictions = 0;
+    };
 
 public:
-    CSignatureCache() {}
+    CSignatureCache();
     ~CSignatureCache() {}
+
+    // Salt the entries with a new random nonce and reset the cache with the memory budget of maxBytes,
+    // not thread safe against Get/Set
+    void Setup(uint64_t maxBytes);
+
     bool Get(const uint256& sigHash, const std::vector<unsigned char>& vchSig,
              const CPubKey& pubKey);
     void Set(const uint256& sigHash, const std::vector<unsigned char>& vchSig,
              const CPubKey& pubKey);
 
+    Stats GetStats();
+
 private:
+    struct Slot {
+        //! Entries are SHA256(nonce || signature hash || public key || signature):
+        uint256 entry;
+        bool referenced = false;
+    };
+
+    struct Stripe {
+        std::mutex mtx;
+        std::unordered_map<uint256, uint32_t, CUint256Hasher> index;  // entry -> slot
+        std::vector<Slot> slots;
+        uint32_t hand     = 0;
+        uint32_t capacity = 0;
+    };
+
+    // estimated memory of one entry: the slot plus the index node and bucket
+    static const uint64_t ENTRY_BYTES = sizeof(Slot) + sizeof(uint256) + sizeof(uint32_t) + 3 * sizeof(void*);
+
+    void Reset(uint64_t maxBytes);
     void ComputeEntry(uint256& entry, const uint256& sigHash,
                       const std::vector<unsigned char>& vchSig, const CPubKey& pubKey);
+    Stripe& GetStripe(const uint256& entry);
+
+private:
+    // random salt of the entries, keeps the stripes and slots of the entries unpredictable from outside
+    uint256 nonce;
+    uint64_t maxBytes = 0;
+    std::array<Stripe, STRIPE_COUNT> stripes;
+
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
 };
 
-#endif  // COIN_SIGCACHE_H
\ No newline at end of file
+#endif  // COIN_SIGCACHE_H
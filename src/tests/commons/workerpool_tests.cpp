@@ -0,0 +1,41 @@
+// Copyright (c) 2017-2020 The DragonBallChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <atomic>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "commons/workerpool.h"
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(commons_workerpool_tests)
+
+BOOST_AUTO_TEST_CASE(workerpool_parallel_for)
+{
+    CWorkerPool pool("test", 4);
+    BOOST_CHECK(pool.GetWorkerCount() == 4);
+
+    for (size_t count : {0, 1, 3, 1000}) {
+        vector<atomic<uint32_t>> hits(count);
+        pool.ParallelFor(count, [&hits](size_t i) { hits[i]++; });
+        for (size_t i = 0; i < count; i++)
+            BOOST_CHECK(hits[i] == 1);
+    }
+
+    pool.Stop();
+    // a stopped pool runs the items on the caller thread
+    atomic<uint32_t> total{0};
+    pool.ParallelFor(10, [&total](size_t i) { total += i; });
+    BOOST_CHECK(total == 45);
+}
+
+BOOST_AUTO_TEST_CASE(workerpool_count_from_arg)
+{
+    BOOST_CHECK(GetWorkerCountFromArg(1, 16) == 0);
+    BOOST_CHECK(GetWorkerCountFromArg(8, 16) == 7);
+    BOOST_CHECK(GetWorkerCountFromArg(100, 16) == 16);
+    BOOST_CHECK(GetWorkerCountFromArg(-100000, 16) == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
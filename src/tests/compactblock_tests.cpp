@@ -0,0 +1,94 @@
+// Copyright (c) 2017-2020 The DragonBallChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "p2p/compactblock.h"
+#include "tx/txserializer.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static CBlock MakeBlock(uint32_t height, uint32_t txCount) {
+    CBlock block;
+    block.SetHeight(height);
+    block.vptx.push_back(std::make_shared<CBlockRewardTx>(CRegID(1, 0).GetRegIdRaw(), 0, height));
+    for (uint32_t i = 1; i < txCount; i++)
+        block.vptx.push_back(std::make_shared<CBaseCoinTransferTx>(CRegID(1, i), CRegID(2, i), height, i, 10000, ""));
+    block.SetMerkleRootHash(block.BuildMerkleTree());
+    return block;
+}
+
+static CBlockHeaderAndShortTxIDs RelayCmpctBlock(const CBlock &block, uint64_t nonce) {
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << CBlockHeaderAndShortTxIDs(block, nonce);
+    CBlockHeaderAndShortTxIDs cmpctBlock;
+    ss >> cmpctBlock;
+    return cmpctBlock;
+}
+
+BOOST_AUTO_TEST_SUITE(compactblock_tests)
+
+BOOST_AUTO_TEST_CASE(compactblock_reconstruct_test)
+{
+    CBlock block = MakeBlock(10, 20);
+    CBlockHeaderAndShortTxIDs cmpctBlock = RelayCmpctBlock(block, 42);
+    BOOST_CHECK_EQUAL(cmpctBlock.prefilledTxs.size(), 1U);
+    BOOST_CHECK_EQUAL(cmpctBlock.shortTxIds.size(), 19U);
+
+    CPartialBlock partialBlock;
+    BOOST_CHECK(partialBlock.Init(cmpctBlock) == CPartialBlock::READ_OK);
+    BOOST_CHECK(partialBlock.GetBlockHash() == block.GetHash());
+
+    // the odd txs are in the mempool, along with txs of another block
+    CBlock otherBlock = MakeBlock(11, 20);
+    for (uint32_t i = 1; i < 20; i++) {
+        if (i % 2 == 1)
+            partialBlock.AddAvailableTx(block.vptx[i]->GetHash(), block.vptx[i]);
+        partialBlock.AddAvailableTx(otherBlock.vptx[i]->GetHash(), otherBlock.vptx[i]);
+    }
+
+    vector<uint32_t> missingIndexes = partialBlock.GetMissingIndexes();
+    BOOST_CHECK_EQUAL(missingIndexes.size(), 9U);
+
+    vector<std::shared_ptr<CBaseTx>> missingTxs;
+    for (uint32_t index : missingIndexes) {
+        BOOST_CHECK_EQUAL(index % 2, 0U);
+        missingTxs.push_back(block.vptx[index]);
+    }
+
+    CBlock filledBlock;
+    BOOST_CHECK(!partialBlock.FillBlock(filledBlock, vector<std::shared_ptr<CBaseTx>>(missingTxs.begin() + 1, missingTxs.end())));
+    BOOST_CHECK(partialBlock.FillBlock(filledBlock, missingTxs));
+    BOOST_CHECK(filledBlock.GetHash() == block.GetHash());
+    BOOST_CHECK_EQUAL(filledBlock.vptx.size(), block.vptx.size());
+    // the available txs are copied into the block
+    BOOST_CHECK(filledBlock.vptx[1] != block.vptx[1]);
+    BOOST_CHECK(filledBlock.vptx[1]->GetHash() == block.vptx[1]->GetHash());
+
+    // the wrong tx in a slot fails the merkle root
+    missingTxs[0] = otherBlock.vptx[2];
+    BOOST_CHECK(!partialBlock.FillBlock(filledBlock, missingTxs));
+}
+
+BOOST_AUTO_TEST_CASE(compactblock_invalid_test)
+{
+    CBlock block = MakeBlock(10, 5);
+    CBlockHeaderAndShortTxIDs cmpctBlock = RelayCmpctBlock(block, 7);
+    CPartialBlock partialBlock;
+
+    CBlockHeaderAndShortTxIDs outOfRange = cmpctBlock;
+    outOfRange.prefilledTxs[0].index = 5;
+    BOOST_CHECK(partialBlock.Init(outOfRange) == CPartialBlock::READ_INVALID);
+
+    CBlockHeaderAndShortTxIDs empty = cmpctBlock;
+    empty.shortTxIds.clear();
+    empty.prefilledTxs.clear();
+    BOOST_CHECK(partialBlock.Init(empty) == CPartialBlock::READ_INVALID);
+
+    CBlockHeaderAndShortTxIDs duplicated = cmpctBlock;
+    duplicated.shortTxIds[1] = duplicated.shortTxIds[0];
+    BOOST_CHECK(partialBlock.Init(duplicated) == CPartialBlock::READ_FAILED);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
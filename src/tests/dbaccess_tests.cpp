@@ -78,6 +78,30 @@ BOOST_AUTO_TEST_CASE(dbaccess_test)
 
 }
 
+BOOST_AUTO_TEST_CASE(dbaccess_shared_store_test)
+{
+    auto spDb = make_shared<CLevelDBWrapper>(db_dir, CACHE_SIZE, false, true);
+    CDBAccess accountAccess(DBNameType::ACCOUNT, spDb);
+    CDBAccess sysParamAccess(DBNameType::SYSPARAM, spDb);
+
+    // the batches of both accesses are committed together
+    CLevelDBBatch pendingBatch;
+    accountAccess.SetPendingBatch(&pendingBatch);
+    sysParamAccess.SetPendingBatch(&pendingBatch);
+    WriteBatch(accountAccess, dbk::REGID_KEYID, map<string, string>{{"regid-1", "keyid-1"}});
+    WriteBatch(sysParamAccess, dbk::SYS_PARAM, map<string, string>{{"param-1", "value-1"}});
+
+    string value;
+    BOOST_CHECK(!accountAccess.GetData(dbk::REGID_KEYID, string("regid-1"), value));
+    accountAccess.SetPendingBatch(nullptr);
+    sysParamAccess.SetPendingBatch(nullptr);
+    spDb->WriteBatch(pendingBatch, true);
+
+    BOOST_CHECK(accountAccess.GetData(dbk::REGID_KEYID, string("regid-1"), value) && value == "keyid-1");
+    BOOST_CHECK(sysParamAccess.GetData(dbk::SYS_PARAM, string("param-1"), value) && value == "value-1");
+    BOOST_CHECK(!accountAccess.GetData(dbk::REGID_KEYID, string("param-1"), value));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
@@ -200,4 +224,250 @@ BOOST_AUTO_TEST_CASE(dbcache_cache_size_test)
     BOOST_CHECK(!pDBCache2->IsCalcSize() && pDBCache2->GetCacheSize() == 0);
 }
 
+BOOST_AUTO_TEST_CASE(dbcache_copy_on_write_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        DBNameType::ACCOUNT, db_dir, CACHE_SIZE, false, isWipe);
+
+    auto pDBCache1 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBAccess.get());
+    pDBCache1->SetData("regid-1", "keyid-1");
+    pDBCache1->SetData("regid-2", "keyid-2");
+
+    // child reads share the values of base, writes and erases must not leak into base
+    auto pDBCache2 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBCache1.get());
+    string value;
+    BOOST_CHECK(pDBCache2->GetData(string("regid-1"), value) && value == "keyid-1");
+    BOOST_CHECK(pDBCache2->GetData(string("regid-2"), value) && value == "keyid-2");
+    BOOST_CHECK(pDBCache2->GetMapData().at("regid-1") == pDBCache1->GetMapData().at("regid-1"));
+    pDBCache2->SetData("regid-1", "keyid-1-new");
+    pDBCache2->EraseData("regid-2");
+    BOOST_CHECK(pDBCache1->GetData(string("regid-1"), value) && value == "keyid-1");
+    BOOST_CHECK(pDBCache1->GetData(string("regid-2"), value) && value == "keyid-2");
+
+    // a copy is isolated from the source too
+    CCompositeKVCache<prefix, string, string> copyCache = *pDBCache2;
+    copyCache.SetData("regid-1", "keyid-1-copy");
+    BOOST_CHECK(pDBCache2->GetData(string("regid-1"), value) && value == "keyid-1-new");
+
+    pDBCache2->Flush();
+    BOOST_CHECK(pDBCache1->GetData(string("regid-1"), value) && value == "keyid-1-new");
+    BOOST_CHECK(!pDBCache1->HasData(string("regid-2")));
+    BOOST_CHECK(pDBCache1->GetCacheSize() == GetCacheSerializeSize(*pDBCache1));
+
+    // flush to an empty base hands over the map
+    auto pDBCache3 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBCache2.get());
+    pDBCache3->SetData("regid-3", "keyid-3");
+    pDBCache3->Flush();
+    BOOST_CHECK(pDBCache3->GetMapData().empty());
+    BOOST_CHECK(pDBCache2->GetData(string("regid-3"), value) && value == "keyid-3");
+
+    auto pScalarCache1 = make_shared< CSimpleKVCache<prefix, string> >(pDBAccess.get());
+    pScalarCache1->SetData("keyid-1");
+    auto pScalarCache2 = make_shared< CSimpleKVCache<prefix, string> >(pScalarCache1.get());
+    BOOST_CHECK(pScalarCache2->GetData(value) && value == "keyid-1");
+    pScalarCache2->SetData("keyid-2");
+    BOOST_CHECK(pScalarCache1->GetData(value) && value == "keyid-1");
+    pScalarCache2->Flush();
+    BOOST_CHECK(pScalarCache1->GetData(value) && value == "keyid-2");
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_cow_stats_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        DBNameType::ACCOUNT, db_dir, CACHE_SIZE, false, isWipe);
+
+    auto pDBCache1 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBAccess.get());
+    pDBCache1->SetData("regid-1", "keyid-1");
+    auto pDBCache2 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBCache1.get());
+
+    // the first write of a shared value copies it, the next ones update the copy in place
+    CDbCacheCowStats &stats = GetDbCacheCowStats(prefix);
+    uint64_t sharedReads = stats.shared_reads, cowCopies = stats.cow_copies, ownedWrites = stats.owned_writes;
+    string value;
+    BOOST_CHECK(pDBCache2->GetData(string("regid-1"), value) && value == "keyid-1");
+    BOOST_CHECK(stats.shared_reads == sharedReads + 1);
+    pDBCache2->SetData("regid-1", "keyid-1-a");
+    BOOST_CHECK(stats.cow_copies == cowCopies + 1);
+    pDBCache2->SetData("regid-1", "keyid-1-b");
+    BOOST_CHECK(stats.owned_writes == ownedWrites + 1);
+    BOOST_CHECK(pDBCache2->GetData(string("regid-1"), value) && value == "keyid-1-b");
+    BOOST_CHECK(pDBCache1->GetData(string("regid-1"), value) && value == "keyid-1");
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_redo_log_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        DBNameType::ACCOUNT, db_dir, CACHE_SIZE, false, isWipe);
+
+    auto pDBCache1 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBAccess.get());
+    pDBCache1->SetData("regid-1", "keyid-1");
+    pDBCache1->SetData("regid-2", "keyid-2");
+
+    // record the changes of a child view
+    CDBOpLogMap dbOpLogMap;
+    dbOpLogMap.SetRecordRedo(true);
+    auto pDBCache2 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBCache1.get());
+    pDBCache2->SetDbOpLogMap(&dbOpLogMap);
+    pDBCache2->SetData("regid-1", "keyid-1-a");
+    pDBCache2->SetData("regid-1", "keyid-1-b");
+    pDBCache2->EraseData("regid-2");
+    pDBCache2->SetData("regid-3", "keyid-3");
+    BOOST_CHECK(dbOpLogMap.GetRedoMap().at(dbk::GetKeyPrefix(prefix)).size() == 4);
+
+    // and replay them on another view of the same base
+    UndoDataFuncMap undoDataFuncMap;
+    auto pDBCache3 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBCache1.get());
+    pDBCache3->RegisterUndoFunc(undoDataFuncMap);
+    const CDbOpLogs &redoLogs = dbOpLogMap.GetRedoMap().at(dbk::GetKeyPrefix(prefix));
+    undoDataFuncMap[prefix](CDbOpLogs(redoLogs.rbegin(), redoLogs.rend()));
+
+    string value;
+    BOOST_CHECK(pDBCache3->GetData(string("regid-1"), value) && value == "keyid-1-b");
+    BOOST_CHECK(!pDBCache3->HasData(string("regid-2")));
+    BOOST_CHECK(pDBCache3->GetData(string("regid-3"), value) && value == "keyid-3");
+    BOOST_CHECK(pDBCache1->GetData(string("regid-1"), value) && value == "keyid-1");
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_shared_read_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        DBNameType::ACCOUNT, db_dir, CACHE_SIZE, false, isWipe);
+
+    auto pDBCache1 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBAccess.get());
+    pDBCache1->SetData("regid-1", "keyid-1");
+    pDBCache1->SetData("regid-2", "keyid-2");
+    pDBCache1->Flush();
+    pDBCache1->SetData("regid-3", "keyid-3");
+
+    // the db level cache keeps nothing the child views read while it is shared
+    pDBAccess->SetSharedRead(true);
+    auto pDBCache2 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBCache1.get());
+    string value;
+    BOOST_CHECK(pDBCache2->GetData(string("regid-1"), value) && value == "keyid-1");
+    BOOST_CHECK(pDBCache2->GetData(string("regid-3"), value) && value == "keyid-3");
+    BOOST_CHECK(!pDBCache2->HasData(string("regid-4")));
+    BOOST_CHECK(pDBCache1->GetMapData().size() == 1);
+    pDBAccess->SetSharedRead(false);
+
+    BOOST_CHECK(pDBCache1->GetData(string("regid-2"), value) && value == "keyid-2");
+    BOOST_CHECK(pDBCache1->GetMapData().size() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_absent_key_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        DBNameType::ACCOUNT, db_dir, CACHE_SIZE, false, isWipe);
+
+    auto pDBCache1 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBAccess.get());
+    pDBCache1->SetData("regid-1", "keyid-1");
+    pDBCache1->Flush();
+
+    // the repeated misses are answered by the absent keys
+    CDbCacheLookupStats &stats = GetDbCacheLookupStats(prefix);
+    uint64_t misses = stats.misses, absentHits = stats.absent_hits;
+    BOOST_CHECK(!pDBCache1->HasData(string("regid-2")));
+    BOOST_CHECK(!pDBCache1->HasData(string("regid-2")));
+    BOOST_CHECK(stats.misses == misses + 1);
+    BOOST_CHECK(stats.absent_hits == absentHits + 1);
+
+    // a child view sets the absent key, the value reaches the base when flushed
+    auto pDBCache2 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBCache1.get());
+    BOOST_CHECK(!pDBCache2->HasData(string("regid-2")));
+    pDBCache2->SetData("regid-2", "keyid-2");
+    string value;
+    BOOST_CHECK(pDBCache2->GetData(string("regid-2"), value) && value == "keyid-2");
+    BOOST_CHECK(!pDBCache1->HasData(string("regid-2")));
+    pDBCache2->Flush();
+    BOOST_CHECK(pDBCache1->GetData(string("regid-2"), value) && value == "keyid-2");
+
+    // the keys erased from the db become absent keys
+    pDBCache1->EraseData("regid-1");
+    pDBCache1->Flush();
+    misses = stats.misses;
+    BOOST_CHECK(!pDBCache1->HasData(string("regid-1")));
+    BOOST_CHECK(stats.misses == misses);
+    pDBCache1->SetData("regid-1", "keyid-1-a");
+    BOOST_CHECK(pDBCache1->GetData(string("regid-1"), value) && value == "keyid-1-a");
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_background_flush_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        DBNameType::ACCOUNT, db_dir, CACHE_SIZE, false, isWipe);
+
+    auto pDBCache1 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBAccess.get());
+    pDBCache1->SetData("regid-1", "keyid-1");
+    pDBCache1->SetData("regid-2", "keyid-2");
+    pDBCache1->Flush();
+    pDBCache1->SetData("regid-1", "keyid-1-a");
+    pDBCache1->EraseData("regid-2");
+
+    // freeze the data
+    vector<DbFlushJob> jobs;
+    pDBAccess->BeginBackgroundFlush(&jobs);
+    pDBCache1->Flush();
+    pDBAccess->SetFlushJobs(nullptr);
+    BOOST_CHECK(jobs.size() == 1);
+    BOOST_CHECK(pDBCache1->GetMapData().empty());
+
+    // it is read from the frozen map until it is written
+    string value;
+    BOOST_CHECK(pDBCache1->GetData(string("regid-1"), value) && value == "keyid-1-a");
+    BOOST_CHECK(!pDBCache1->HasData(string("regid-2")));
+    BOOST_CHECK(pDBAccess->GetData(prefix, string("regid-1"), value) && value == "keyid-1");
+
+    CLevelDBBatch batch;
+    jobs[0](batch);
+    pDBAccess->CommitBackgroundBatch(batch);
+    pDBAccess->EndBackgroundFlush();
+
+    BOOST_CHECK(pDBAccess->GetData(prefix, string("regid-1"), value) && value == "keyid-1-a");
+    BOOST_CHECK(!pDBAccess->GetData(prefix, string("regid-2"), value));
+    auto pDBCache2 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBAccess.get());
+    BOOST_CHECK(pDBCache2->GetData(string("regid-1"), value) && value == "keyid-1-a");
+}
+
+
+BOOST_AUTO_TEST_CASE(dbcache_background_flush_failed_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        DBNameType::ACCOUNT, db_dir, CACHE_SIZE, false, isWipe);
+
+    auto pDBCache1 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBAccess.get());
+    auto pScalarCache1 = make_shared< CSimpleKVCache<prefix, string> >(pDBAccess.get());
+    pDBCache1->SetData("regid-1", "keyid-1");
+    pScalarCache1->SetData("keyid-1");
+
+    vector<DbFlushJob> jobs;
+    pDBAccess->BeginBackgroundFlush(&jobs);
+    pDBCache1->Flush();
+    pScalarCache1->Flush();
+    pDBAccess->SetFlushJobs(nullptr);
+    BOOST_CHECK(jobs.size() == 2);
+    BOOST_CHECK(pScalarCache1->GetCacheSize() == 0);
+
+    // the frozen data is never written, it is still read and the db refuses the later writes
+    pDBAccess->FailBackgroundFlush();
+    string value;
+    BOOST_CHECK(pDBCache1->GetData(string("regid-1"), value) && value == "keyid-1");
+    BOOST_CHECK(pScalarCache1->GetData(value) && value == "keyid-1");
+    BOOST_CHECK(!pDBAccess->WaitForBackgroundFlush());
+    pDBCache1->SetData("regid-2", "keyid-2");
+    BOOST_CHECK_THROW(pDBCache1->Flush(), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
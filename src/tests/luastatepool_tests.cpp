@@ -0,0 +1,102 @@
+// Copyright (c) 2017-2020 The DragonBallChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "config/version.h"
+#include "vm/luavm/lmylib.h"
+#include "vm/luavm/luastatepool.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <string>
+
+using namespace std;
+
+typedef std::unique_ptr<lua_State, decltype(&CloseLuaState)> LuaStatePtr;
+
+static const uint64_t FUEL_LIMIT = 5000000;
+
+struct RunResult {
+    int status       = LUA_OK;
+    uint64_t fuel    = 0;
+    uint64_t memSize = 0;
+};
+
+static RunResult RunChunk(lua_State *L, const string &code, int burnVersion) {
+    RunResult result;
+    result.status = luaL_loadbuffer(L, code.c_str(), code.size(), "line");
+    if (result.status == LUA_OK)
+        result.status = lua_pcallk(L, 0, 0, 0, 0, NULL, burnVersion);
+
+    result.fuel    = lua_GetBurnedFuel(L);
+    result.memSize = lua_GetBurnerState(L)->allocMemSize;
+    return result;
+}
+
+static LuaStatePtr NewFreshState(int burnVersion, lua_CFunction mylib) {
+    LuaStatePtr L(luaL_newstate(), &CloseLuaState);
+    BOOST_REQUIRE(L);
+    BOOST_REQUIRE(lua_StartBurner(L.get(), nullptr, FUEL_LIMIT, burnVersion));
+    BOOST_REQUIRE(OpenContractLibs(L.get(), mylib));
+    return L;
+}
+
+BOOST_AUTO_TEST_SUITE(luastatepool_tests)
+
+BOOST_AUTO_TEST_CASE(luastatepool_fuel_test)
+{
+    const vector<string> chunks = {
+        "local t = {} for i = 1, 20000 do t['k' .. i] = {i, tostring(i)} end",
+        "local s = '' for i = 1, 3000 do s = s .. string.rep('x', i % 50) end",
+        "error('failed')",
+        // burned-out
+        "local t = {} for i = 1, 1000000000 do t[i] = {} end",
+    };
+
+    lua_CFunction mylib = GetLuaMylib(0);
+    for (int burnVersion : {MAJOR_VER_R2, MAJOR_VER_R3}) {
+        // the second round runs on the restored images
+        for (int round = 0; round < 2; round++) {
+            for (const auto &chunk : chunks) {
+                LuaStatePtr freshState = NewFreshState(burnVersion, mylib);
+                RunResult fresh = RunChunk(freshState.get(), chunk, burnVersion);
+
+                LuaStatePtr pooledState(
+                    CLuaStatePool::GetThreadPool().Acquire(nullptr, FUEL_LIMIT, burnVersion, mylib), &CloseLuaState);
+                BOOST_REQUIRE(pooledState);
+                RunResult pooled = RunChunk(pooledState.get(), chunk, burnVersion);
+
+                BOOST_CHECK_EQUAL(pooled.status, fresh.status);
+                BOOST_CHECK_EQUAL(pooled.fuel, fresh.fuel);
+                BOOST_CHECK_EQUAL(pooled.memSize, fresh.memSize);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(luastatepool_reuse_test)
+{
+    lua_CFunction mylib = GetLuaMylib(0);
+    CLuaStatePool &pool = CLuaStatePool::GetThreadPool();
+    {
+        LuaStatePtr L(pool.Acquire(nullptr, FUEL_LIMIT, MAJOR_VER_R2, mylib), &CloseLuaState);
+        BOOST_REQUIRE(L);
+        BOOST_CHECK_EQUAL(RunChunk(L.get(), "gCheckAccount = true contract = {1}", MAJOR_VER_R2).status, LUA_OK);
+
+        // the arena is taken by the running state
+        BOOST_CHECK(pool.Acquire(nullptr, FUEL_LIMIT, MAJOR_VER_R2, mylib) == nullptr);
+    }
+
+    // nothing of the previous contract is left
+    LuaStatePtr L(pool.Acquire(nullptr, FUEL_LIMIT, MAJOR_VER_R2, mylib), &CloseLuaState);
+    BOOST_REQUIRE(L);
+    BOOST_CHECK_EQUAL(lua_getglobal(L.get(), "gCheckAccount"), LUA_TNIL);
+    BOOST_CHECK_EQUAL(lua_getglobal(L.get(), "contract"), LUA_TNIL);
+    L.reset();
+
+    // a fresh state would be burned-out while opening the libs
+    BOOST_CHECK(pool.Acquire(nullptr, 1, MAJOR_VER_R2, mylib) == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,103 @@
+// Copyright (c) 2017-2020 The DragonBallChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "persistence/pricefeeddb.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const PriceCoinPair COIN_PAIR = {"WICC", "USD"};
+
+// the median of the prices of all the users in the block heights (blockHeight - slideWindow, blockHeight]
+static uint64_t ComputeMedian(const map<HeightType, vector<uint64_t>> &blockPrices, HeightType blockHeight,
+                              uint64_t slideWindow) {
+    vector<uint64_t> prices;
+    for (const auto &item : blockPrices) {
+        if (item.first + slideWindow > blockHeight && item.first <= blockHeight)
+            prices.insert(prices.end(), item.second.begin(), item.second.end());
+    }
+    if (prices.empty())
+        return 0;
+
+    sort(prices.begin(), prices.end());
+    size_t size = prices.size();
+    return (size % 2 == 0) ? (prices[size / 2 - 1] + prices[size / 2]) / 2 : prices[size / 2];
+}
+
+static void AddBlockPrices(CPricePointMemCache &cache, map<HeightType, vector<uint64_t>> &blockPrices,
+                           HeightType height, uint32_t userCount) {
+    for (uint32_t i = 0; i < userCount; i++) {
+        uint64_t price = 10000 + (height * 7919 + i * 104729) % 5000;
+        BOOST_CHECK(cache.AddPrice(height, CRegID(1, i), {CPricePoint(COIN_PAIR, price)}));
+        blockPrices[height].push_back(price);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(pricefeed_tests)
+
+BOOST_AUTO_TEST_CASE(pricefeed_median_test)
+{
+    const uint64_t slideWindow = 11;
+    CPricePointMemCache rootCache;
+    map<HeightType, vector<uint64_t>> blockPrices;
+    for (HeightType height = 1; height <= 30; height++) {
+        // odd and even counts of prices
+        AddBlockPrices(rootCache, blockPrices, height, 1 + height % 4);
+
+        CMedianPriceDetail detail = rootCache.ComputeBlockMedianPrice(height, slideWindow, COIN_PAIR);
+        BOOST_CHECK_EQUAL(detail.price, ComputeMedian(blockPrices, height, slideWindow));
+        BOOST_CHECK_EQUAL(detail.last_feed_height, height);
+    }
+
+    // the prices of the block being connected are in the child cache
+    CPricePointMemCache childCache(&rootCache);
+    AddBlockPrices(childCache, blockPrices, 31, 5);
+    CMedianPriceDetail detail = childCache.ComputeBlockMedianPrice(31, slideWindow, COIN_PAIR);
+    BOOST_CHECK_EQUAL(detail.price, ComputeMedian(blockPrices, 31, slideWindow));
+    BOOST_CHECK_EQUAL(detail.last_feed_height, 31U);
+
+    // no price in the current block
+    detail = childCache.ComputeBlockMedianPrice(32, slideWindow, COIN_PAIR);
+    BOOST_CHECK_EQUAL(detail.price, ComputeMedian(blockPrices, 32, slideWindow));
+    BOOST_CHECK_EQUAL(detail.last_feed_height, 0U);
+
+    childCache.Flush();
+    detail = rootCache.ComputeBlockMedianPrice(31, 3, COIN_PAIR);
+    BOOST_CHECK_EQUAL(detail.price, ComputeMedian(blockPrices, 31, 3));
+}
+
+BOOST_AUTO_TEST_CASE(pricefeed_expire_test)
+{
+    const uint64_t slideWindow = 11;
+    CPricePointMemCache rootCache;
+    map<HeightType, vector<uint64_t>> blockPrices;
+    for (HeightType height = 1; height <= 30; height++)
+        AddBlockPrices(rootCache, blockPrices, height, 1 + height % 4);
+
+    // a window shrunk from 30 blocks to slideWindow leaves all the blocks before it to expire at once
+    rootCache.ExpireBlocks(30 - slideWindow);
+    BlockUserPriceMap rootPrices = rootCache.GetSnapshot()[COIN_PAIR];
+    BOOST_CHECK_EQUAL(rootPrices.size(), slideWindow);
+    BOOST_CHECK_EQUAL(rootPrices.begin()->first, 30 - slideWindow + 1);
+    BOOST_CHECK_EQUAL(rootCache.ComputeBlockMedianPrice(30, slideWindow, COIN_PAIR).price,
+                      ComputeMedian(blockPrices, 30, slideWindow));
+
+    // the child cache hides the expired block of the root cache until it is flushed
+    CPricePointMemCache childCache(&rootCache);
+    AddBlockPrices(childCache, blockPrices, 31, 3);
+    childCache.ExpireBlocks(31 - slideWindow);
+    BOOST_CHECK_EQUAL(childCache.ComputeBlockMedianPrice(31, slideWindow, COIN_PAIR).price,
+                      ComputeMedian(blockPrices, 31, slideWindow));
+    BOOST_CHECK_EQUAL(rootCache.GetSnapshot()[COIN_PAIR].size(), slideWindow);
+
+    childCache.Flush();
+    rootPrices = rootCache.GetSnapshot()[COIN_PAIR];
+    BOOST_CHECK_EQUAL(rootPrices.size(), slideWindow);
+    BOOST_CHECK_EQUAL(rootPrices.begin()->first, 31 - slideWindow + 1);
+    BOOST_CHECK_EQUAL(rootCache.ComputeBlockMedianPrice(31, slideWindow, COIN_PAIR).price,
+                      ComputeMedian(blockPrices, 31, slideWindow));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
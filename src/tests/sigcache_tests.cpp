@@ -0,0 +1,85 @@
+// Copyright (c) 2017-2020 The DragonBallChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "sigcache.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static CPubKey MakePubKey(uint8_t seed) {
+    vector<uint8_t> data(33, seed);
+    data[0] = 0x02;
+    return CPubKey(data);
+}
+
+static uint256 MakeHash(uint32_t n) {
+    uint256 hash;
+    memcpy(hash.begin(), &n, sizeof(n));
+    return hash;
+}
+
+BOOST_AUTO_TEST_SUITE(sigcache_tests)
+
+BOOST_AUTO_TEST_CASE(sigcache_hit_miss_test)
+{
+    CSignatureCache cache;
+    CPubKey pubKey = MakePubKey(1);
+    vector<uint8_t> sig(70, 0x30);
+
+    BOOST_CHECK(!cache.Get(MakeHash(1), sig, pubKey));
+    cache.Set(MakeHash(1), sig, pubKey);
+    BOOST_CHECK(cache.Get(MakeHash(1), sig, pubKey));
+    BOOST_CHECK(!cache.Get(MakeHash(1), sig, MakePubKey(2)));
+    BOOST_CHECK(!cache.Get(MakeHash(2), sig, pubKey));
+
+    CSignatureCache::Stats stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.entries, 1U);
+    BOOST_CHECK_EQUAL(stats.hits, 1U);
+    BOOST_CHECK_EQUAL(stats.misses, 3U);
+    BOOST_CHECK_EQUAL(stats.evictions, 0U);
+}
+
+BOOST_AUTO_TEST_CASE(sigcache_budget_test)
+{
+    CSignatureCache cache;
+    cache.Setup(64 * 1024);
+    CPubKey pubKey = MakePubKey(1);
+    vector<uint8_t> sig(70, 0x30);
+
+    const uint32_t count = 10000;
+    for (uint32_t i = 0; i < count; i++)
+        cache.Set(MakeHash(i), sig, pubKey);
+
+    CSignatureCache::Stats stats = cache.GetStats();
+    BOOST_CHECK(stats.bytes <= stats.maxBytes);
+    BOOST_CHECK(stats.entries > 0);
+    BOOST_CHECK_EQUAL(stats.entries + stats.evictions, count);
+
+    // the latest entry of every stripe is still cached
+    BOOST_CHECK(cache.Get(MakeHash(count - 1), sig, pubKey));
+
+    cache.Setup(0);
+    cache.Set(MakeHash(0), sig, pubKey);
+    BOOST_CHECK_EQUAL(cache.GetStats().entries, 0U);
+}
+
+BOOST_AUTO_TEST_CASE(sigcache_clock_test)
+{
+    CSignatureCache cache;
+    CPubKey pubKey = MakePubKey(1);
+    vector<uint8_t> sig(70, 0x30);
+    // room for a handful of entries in every stripe
+    cache.Setup(CSignatureCache::STRIPE_COUNT * 400);
+
+    // keep touching the first entry, it must survive the stream of new entries in its stripe
+    cache.Set(MakeHash(0), sig, pubKey);
+    for (uint32_t i = 1; i < 5000; i++) {
+        BOOST_CHECK(cache.Get(MakeHash(0), sig, pubKey));
+        cache.Set(MakeHash(i), sig, pubKey);
+    }
+    BOOST_CHECK(cache.GetStats().evictions > 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,111 @@
+// Copyright (c) 2017-2020 The DragonBallChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "persistence/txdb.h"
+#include "tx/blockrewardtx.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static CBlock MakeBlock(uint32_t height, uint32_t txCount) {
+    CBlock block;
+    block.SetHeight(height);
+    for (uint32_t i = 0; i < txCount; i++)
+        block.vptx.push_back(std::make_shared<CBlockRewardTx>(CRegID(1, i).GetRegIdRaw(), 0, height));
+    return block;
+}
+
+BOOST_AUTO_TEST_SUITE(txcache_tests)
+
+BOOST_AUTO_TEST_CASE(txcache_bucket_test)
+{
+    CTxMemCache rootCache;
+    vector<CBlock> blocks;
+    for (uint32_t height = 1; height <= 3; height++) {
+        blocks.push_back(MakeBlock(height, 10));
+        BOOST_CHECK(rootCache.AddBlockTx(blocks.back()));
+    }
+    BOOST_CHECK_EQUAL(rootCache.GetSize(), 30U);
+    BOOST_CHECK(rootCache.HasTx(blocks[0].vptx[0]->GetHash()));
+    BOOST_CHECK(!rootCache.HasTx(MakeBlock(4, 1).vptx[0]->GetHash()));
+
+    // retire the oldest block without the block
+    BOOST_CHECK(rootCache.RemoveBlockTx(1));
+    BOOST_CHECK(!rootCache.HasTx(blocks[0].vptx[0]->GetHash()));
+    BOOST_CHECK(rootCache.HasTx(blocks[1].vptx[0]->GetHash()));
+    BOOST_CHECK_EQUAL(rootCache.GetStats().blocks, 2U);
+    BOOST_CHECK_EQUAL(rootCache.GetSize(), 20U);
+
+    // re-adding the same height replaces the block
+    blocks[0] = MakeBlock(1, 5);
+    BOOST_CHECK(rootCache.AddBlockTx(blocks[0]));
+    BOOST_CHECK(rootCache.HasTx(blocks[0].vptx[4]->GetHash()));
+    BOOST_CHECK_EQUAL(rootCache.GetSize(), 25U);
+
+    CTxMemCache::BlockTxIdsMap snapshot = rootCache.GetSnapshot();
+    BOOST_CHECK_EQUAL(snapshot.size(), 3U);
+    CTxMemCache loadedCache;
+    loadedCache.LoadSnapshot(snapshot);
+    BOOST_CHECK_EQUAL(loadedCache.GetSize(), 25U);
+    BOOST_CHECK(loadedCache.HasTx(blocks[2].vptx[9]->GetHash()));
+}
+
+BOOST_AUTO_TEST_CASE(txcache_child_test)
+{
+    CTxMemCache rootCache;
+    CBlock block1 = MakeBlock(1, 10);
+    CBlock block2 = MakeBlock(2, 10);
+    BOOST_CHECK(rootCache.AddBlockTx(block1));
+
+    // connect block 2 and drop block 1 in the child cache
+    CTxMemCache childCache(&rootCache);
+    BOOST_CHECK(childCache.AddBlockTx(block2));
+    BOOST_CHECK(childCache.RemoveBlockTx(1));
+    BOOST_CHECK(!childCache.HasTx(block1.vptx[0]->GetHash()));
+    BOOST_CHECK(childCache.HasTx(block2.vptx[0]->GetHash()));
+    BOOST_CHECK(rootCache.HasTx(block1.vptx[0]->GetHash()));
+    BOOST_CHECK(!rootCache.HasTx(block2.vptx[0]->GetHash()));
+
+    childCache.Flush();
+    BOOST_CHECK(!rootCache.HasTx(block1.vptx[0]->GetHash()));
+    BOOST_CHECK(rootCache.HasTx(block2.vptx[0]->GetHash()));
+
+    // disconnect block 2 and reload block 1
+    CTxMemCache undoCache(&rootCache);
+    BOOST_CHECK(undoCache.RemoveBlockTx(2));
+    BOOST_CHECK(undoCache.AddBlockTx(block1));
+    BOOST_CHECK(!undoCache.HasTx(block2.vptx[0]->GetHash()));
+    BOOST_CHECK(undoCache.HasTx(block1.vptx[0]->GetHash()));
+    undoCache.Flush();
+    BOOST_CHECK(!rootCache.HasTx(block2.vptx[0]->GetHash()));
+    BOOST_CHECK(rootCache.HasTx(block1.vptx[9]->GetHash()));
+    BOOST_CHECK_EQUAL(rootCache.GetSize(), 10U);
+}
+
+BOOST_AUTO_TEST_CASE(txcache_bloom_filter_test)
+{
+    CTxBloomFilter filter;
+    filter.Reset(1000);
+    vector<uint256> txids;
+    for (uint32_t i = 0; i < 1000; i++) {
+        txids.push_back(MakeBlock(i, 1).vptx[0]->GetHash());
+        filter.Insert(txids.back());
+    }
+    for (const auto &txid : txids)
+        BOOST_CHECK(filter.MayContain(txid));
+
+    for (uint32_t i = 0; i < 500; i++)
+        filter.Erase(txids[i]);
+    // no false negatives after erasing
+    for (uint32_t i = 500; i < 1000; i++)
+        BOOST_CHECK(filter.MayContain(txids[i]));
+
+    uint32_t falsePositives = 0;
+    for (uint32_t i = 0; i < 500; i++)
+        falsePositives += filter.MayContain(txids[i]);
+    BOOST_CHECK(falsePositives < 50);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,144 @@
+// Copyright (c) 2017-2020 The DragonBallChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "tx/txmempool.h"
+#include "commons/random.h"
+#include "commons/workerpool.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const uint8_t ACCOUNT_COUNT   = 200;
+static const uint64_t INIT_BALANCE   = 100;
+static const uint8_t HIDDEN_FEE_KEY  = ACCOUNT_COUNT + 1;
+
+// a transfer between two balances kept in the sys params of the cache views
+struct CTestTransfer {
+    uint8_t from;
+    uint8_t to;
+    uint64_t amount;
+    bool payHiddenFee;  // also changes HIDDEN_FEE_KEY, which is in no key id list
+};
+
+static uint64_t GetBalance(CCacheWrapper &cw, uint8_t key) {
+    CVarIntValue<uint64_t> value;
+    return cw.sysParamCache.sys_param_chache.GetData(key, value) ? value.get() : 0;
+}
+
+static void SetBalance(CCacheWrapper &cw, uint8_t key, uint64_t balance) {
+    cw.sysParamCache.sys_param_chache.SetData(key, CVarIntValue<uint64_t>(balance));
+}
+
+static CKeyID MakeKeyId(uint8_t key) {
+    CKeyID keyId;
+    *keyId.begin() = key;
+    return keyId;
+}
+
+class CTestRescanner : public CTxRescanner {
+public:
+    CCacheWrapper root;
+    vector<CTestTransfer> transfers;
+
+    CTestRescanner() {
+        for (uint8_t key = 1; key <= HIDDEN_FEE_KEY; key++)
+            SetBalance(root, key, INIT_BALANCE);
+    }
+
+protected:
+    std::shared_ptr<CCacheWrapper> NewView() { return std::make_shared<CCacheWrapper>(&root); }
+
+    bool ExecuteTx(size_t index, CCacheWrapper &cw, bool parallel) {
+        const CTestTransfer &transfer = transfers[index];
+        uint64_t fromBalance = GetBalance(cw, transfer.from);
+        if (fromBalance < transfer.amount)
+            return false;
+
+        SetBalance(cw, transfer.from, fromBalance - transfer.amount);
+        SetBalance(cw, transfer.to, GetBalance(cw, transfer.to) + transfer.amount);
+        if (transfer.payHiddenFee)
+            SetBalance(cw, HIDDEN_FEE_KEY, GetBalance(cw, HIDDEN_FEE_KEY) + 1);
+        return true;
+    }
+};
+
+// the parallel rescan gives the same result as executing the transfers one by one
+static void CheckSameAsSerial(CTestRescanner &rescanner, const vector<CTxRescanner::Item> &items, CWorkerPool &pool) {
+    vector<bool> serialPassed;
+    auto spSerialCw = rescanner.Rescan(items, nullptr, serialPassed);
+
+    vector<bool> parallelPassed;
+    auto spParallelCw = rescanner.Rescan(items, &pool, parallelPassed);
+
+    BOOST_CHECK(serialPassed == parallelPassed);
+    for (uint8_t key = 1; key <= HIDDEN_FEE_KEY; key++)
+        BOOST_CHECK_EQUAL(GetBalance(*spSerialCw, key), GetBalance(*spParallelCw, key));
+}
+
+// the qualified transfers list both accounts, the others list only the sender like the other tx types
+static CTxRescanner::Item MakeItem(const CTestTransfer &transfer, bool qualified) {
+    CTxRescanner::Item item;
+    item.qualified = qualified;
+    item.keyIds.insert(MakeKeyId(transfer.from));
+    if (qualified)
+        item.keyIds.insert(MakeKeyId(transfer.to));
+    return item;
+}
+
+BOOST_AUTO_TEST_SUITE(txrescan_tests)
+
+BOOST_AUTO_TEST_CASE(txrescan_dependent_test)
+{
+    CWorkerPool pool("test", 3);
+    CTestRescanner rescanner;
+    vector<CTxRescanner::Item> items;
+    auto add = [&](uint8_t from, uint8_t to, uint64_t amount, bool qualified) {
+        rescanner.transfers.push_back({from, to, amount, false});
+        items.push_back(MakeItem(rescanner.transfers.back(), qualified));
+    };
+
+    // an earlier tx not listing its receiver pays the sender of a group
+    add(3, 1, 100, false);
+    add(1, 2, 150, true);
+    // an earlier tx not listing its receiver changes what a group reads
+    add(5, 4, 60, false);
+    add(4, 6, 50, true);
+    // a tx in between the txs of a group reads what the group changed
+    add(7, 8, 10, true);
+    add(9, 8, 1, false);
+    add(8, 7, 100, true);
+    // independent groups
+    add(10, 11, 50, true);
+    add(12, 13, 50, true);
+    add(13, 12, 120, true);
+
+    CheckSameAsSerial(rescanner, items, pool);
+
+    vector<bool> passed;
+    rescanner.Rescan(items, &pool, passed);
+    BOOST_CHECK(passed[1]);
+    BOOST_CHECK(passed[3]);
+}
+
+BOOST_AUTO_TEST_CASE(txrescan_random_test)
+{
+    CWorkerPool pool("test", 3);
+    for (int32_t round = 0; round < 50; round++) {
+        CTestRescanner rescanner;
+        vector<CTxRescanner::Item> items;
+        for (int32_t i = 0; i < 100; i++) {
+            CTestTransfer transfer;
+            transfer.from         = 1 + GetRand(ACCOUNT_COUNT);
+            transfer.to           = 1 + GetRand(ACCOUNT_COUNT);
+            transfer.amount       = GetRand(INIT_BALANCE);
+            transfer.payHiddenFee = GetRand(20) == 0;
+            rescanner.transfers.push_back(transfer);
+            items.push_back(MakeItem(transfer, GetRand(4) != 0));
+        }
+        CheckSameAsSerial(rescanner, items, pool);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
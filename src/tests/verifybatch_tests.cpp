@@ -0,0 +1,175 @@
+// Copyright (c) 2017-2020 The DragonBallChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "entities/key.h"
+#include "crypto/hash.h"
+
+#include <secp256k1.h>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+// order of the secp256k1 group
+static const uint8_t CURVE_ORDER[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE,
+    0xBA, 0xAE, 0xDC, 0xE6, 0xAF, 0x48, 0xA0, 0x3B, 0xBF, 0xD2, 0x5E, 0x8C, 0xD0, 0x36, 0x41, 0x41};
+
+struct VerifyBatchSetup {
+    ECCVerifyHandle verifyHandle;
+    VerifyBatchSetup() { ECC_Start(); }
+    ~VerifyBatchSetup() { ECC_Stop(); }
+};
+
+static uint256 MakeHash(uint32_t n) {
+    return Hash(BEGIN(n), END(n));
+}
+
+static CKey MakeKey(bool fCompressed = true) {
+    CKey key;
+    key.MakeNewKey(fCompressed);
+    return key;
+}
+
+static vector<uint8_t> MakeSig(const CKey &key, const uint256 &hash) {
+    vector<uint8_t> sig;
+    BOOST_REQUIRE(key.Sign(hash, sig));
+    return sig;
+}
+
+// the same signature with s replaced by n - s
+static vector<uint8_t> MakeHighS(const vector<uint8_t> &sig) {
+    secp256k1_context *ctx = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
+    secp256k1_ecdsa_signature parsed;
+    BOOST_REQUIRE(secp256k1_ecdsa_signature_parse_der(ctx, &parsed, sig.data(), sig.size()));
+
+    uint8_t compact[64];
+    secp256k1_ecdsa_signature_serialize_compact(ctx, compact, &parsed);
+    int32_t borrow = 0;
+    for (int32_t i = 31; i >= 0; i--) {
+        int32_t diff = CURVE_ORDER[i] - compact[32 + i] - borrow;
+        borrow       = diff < 0 ? 1 : 0;
+        compact[32 + i] = (uint8_t)(diff + (borrow << 8));
+    }
+    BOOST_REQUIRE(secp256k1_ecdsa_signature_parse_compact(ctx, &parsed, compact));
+
+    vector<uint8_t> highS(72);
+    size_t len = highS.size();
+    BOOST_REQUIRE(secp256k1_ecdsa_signature_serialize_der(ctx, highS.data(), &len, &parsed));
+    highS.resize(len);
+    secp256k1_context_destroy(ctx);
+    return highS;
+}
+
+// VerifyBatch must give the same answer as CPubKey::Verify for every item
+static void CheckBatch(const vector<CSignatureCheck> &checks) {
+    vector<bool> results;
+    bool allValid = CPubKey::VerifyBatch(checks, results);
+    BOOST_REQUIRE_EQUAL(results.size(), checks.size());
+
+    bool expectAllValid = true;
+    for (size_t i = 0; i < checks.size(); i++) {
+        bool expected = checks[i].pubKey.Verify(checks[i].sigHash, checks[i].signature);
+        BOOST_CHECK_MESSAGE(results[i] == expected, "item " << i << " expected " << expected);
+        expectAllValid = expectAllValid && expected;
+    }
+    BOOST_CHECK_EQUAL(allValid, expectAllValid);
+}
+
+BOOST_FIXTURE_TEST_SUITE(verifybatch_tests, VerifyBatchSetup)
+
+BOOST_AUTO_TEST_CASE(verifybatch_empty_test)
+{
+    vector<bool> results(3, true);
+    BOOST_CHECK(CPubKey::VerifyBatch(vector<CSignatureCheck>(), results));
+    BOOST_CHECK(results.empty());
+}
+
+BOOST_AUTO_TEST_CASE(verifybatch_valid_test)
+{
+    vector<CSignatureCheck> checks;
+    for (uint32_t i = 0; i < 8; i++) {
+        CKey key = MakeKey(i % 2 == 0);
+        uint256 hash = MakeHash(i);
+        checks.emplace_back(hash, key.GetPubKey(), MakeSig(key, hash));
+    }
+    CheckBatch(checks);
+
+    vector<bool> results;
+    BOOST_CHECK(CPubKey::VerifyBatch(checks, results));
+}
+
+BOOST_AUTO_TEST_CASE(verifybatch_invalid_test)
+{
+    CKey key      = MakeKey();
+    CKey otherKey = MakeKey();
+    uint256 hash  = MakeHash(1);
+    vector<uint8_t> sig = MakeSig(key, hash);
+
+    vector<uint8_t> badSig = sig;
+    badSig[badSig.size() - 1] ^= 0x01;
+    vector<uint8_t> truncatedSig(sig.begin(), sig.begin() + sig.size() / 2);
+    vector<uint8_t> garbageSig(70, 0x30);
+
+    vector<CSignatureCheck> checks;
+    checks.emplace_back(hash, key.GetPubKey(), sig);                  // valid
+    checks.emplace_back(MakeHash(2), key.GetPubKey(), sig);           // wrong hash
+    checks.emplace_back(hash, otherKey.GetPubKey(), sig);             // wrong key
+    checks.emplace_back(hash, key.GetPubKey(), badSig);               // corrupted signature
+    checks.emplace_back(hash, key.GetPubKey(), truncatedSig);         // malformed DER
+    checks.emplace_back(hash, key.GetPubKey(), garbageSig);           // malformed DER
+    checks.emplace_back(hash, key.GetPubKey(), vector<uint8_t>());    // empty signature
+    checks.emplace_back(hash, CPubKey(), sig);                        // invalid public key
+    checks.emplace_back(hash, key.GetPubKey(), MakeHighS(sig));       // high-S
+    checks.emplace_back(hash, otherKey.GetPubKey(), MakeHighS(sig));  // high-S, wrong key
+    checks.emplace_back(hash, key.GetPubKey(), sig);                  // duplicate
+    checks.emplace_back(hash, otherKey.GetPubKey(), sig);             // duplicate wrong key
+    CheckBatch(checks);
+
+    vector<bool> results;
+    BOOST_CHECK(!CPubKey::VerifyBatch(checks, results));
+    BOOST_CHECK(results[0]);
+    BOOST_CHECK(results[8]);
+    BOOST_CHECK(results[10]);
+}
+
+BOOST_AUTO_TEST_CASE(verifybatch_multisig_test)
+{
+    // every signature is matched against all the keys, so the fan-out of each signature takes the recovery branch
+    const size_t keyCount = SIG_RECOVER_FANOUT_MIN + 2;
+    vector<CKey> keys;
+    for (size_t i = 0; i < keyCount; i++)
+        keys.push_back(MakeKey(i != 1));
+
+    uint256 hash = MakeHash(7);
+    vector<vector<uint8_t>> sigs;
+    for (size_t i = 0; i < keyCount; i++)
+        sigs.push_back(MakeSig(keys[i], hash));
+    sigs.push_back(MakeHighS(sigs[0]));
+    vector<uint8_t> badSig = sigs[2];
+    badSig[badSig.size() - 1] ^= 0x01;
+    sigs.push_back(badSig);
+
+    vector<CSignatureCheck> checks;
+    for (const auto &sig : sigs) {
+        for (const auto &key : keys)
+            checks.emplace_back(hash, key.GetPubKey(), sig);
+        // an uncompressed form of a compressed key is the same signer
+        CPubKey uncompressed = keys[0].GetPubKey();
+        BOOST_REQUIRE(uncompressed.Decompress());
+        checks.emplace_back(hash, uncompressed, sig);
+        checks.emplace_back(MakeHash(8), keys[0].GetPubKey(), sig);
+    }
+    CheckBatch(checks);
+
+    size_t validCount = 0;
+    vector<bool> results;
+    CPubKey::VerifyBatch(checks, results);
+    for (bool valid : results)
+        validCount += valid ? 1 : 0;
+    // each key signed once, the high-S copy of the first signature and the uncompressed first key
+    BOOST_CHECK_EQUAL(validCount, keyCount + 1 + 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
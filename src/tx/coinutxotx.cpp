@@ -17,23 +17,14 @@ static bool GetUtxoTxFromChain(CCacheWrapper &cw, TxID &txid, std::shared_ptr<CC
     CDiskTxPos txPos;
     if (cw.blockCache.ReadTxIndex(txid, txPos)) {
         LOCK(cs_main);
-        CAutoFile file(OpenBlockFile(txPos, true), SER_DISK, CLIENT_VERSION);
         CBlockHeader header;
+        if (!ReadBaseTxFromDisk(txPos, header, pBaseTx))
+            throw runtime_error(strprintf("%s : Deserialize or I/O error", __func__).c_str());
 
-        try {
-            file >> header;
-            fseek(file, txPos.nTxOffset, SEEK_CUR);
-            file >> pBaseTx;
-
-            assert(pBaseTx);
-            pPrevUtxoTx = dynamic_pointer_cast<CCoinUtxoTransferTx>(pBaseTx);
-            if (!pPrevUtxoTx) {
-                return ERRORMSG("The expected tx(%s) type is CCoinUtxoTransferTx, but read tx type is %s",
-                                txid.ToString(), typeid(*pBaseTx).name());
-            }
-
-        } catch (std::exception &e) {
-            throw runtime_error(strprintf("%s : Deserialize or I/O error - %s", __func__, e.what()).c_str());
+        pPrevUtxoTx = dynamic_pointer_cast<CCoinUtxoTransferTx>(pBaseTx);
+        if (!pPrevUtxoTx) {
+            return ERRORMSG("The expected tx(%s) type is CCoinUtxoTransferTx, but read tx type is %s",
+                            txid.ToString(), typeid(*pBaseTx).name());
         }
     } else {
         return ERRORMSG("utxo read preutxo tx index error");
@@ -91,14 +82,37 @@ bool VerifyMultiSig(CBaseTx &tx, CTxExecuteContext &context, const uint256 &utxo
     if (!ComputeRedeemScript(tx, context, p2maIn, redeemScript))
         return false;
 
-    int verifyPassNum = 0;
+    // Every signature is matched against the uids in order and counted for the first uid it is valid for.
+    // Resolve the uids which can be reached by the matching, and check all the (signature, uid) pairs in
+    // one batch so each signature costs a couple of key recoveries instead of one verify per uid.
+    vector<shared_ptr<CAccount>> accounts;
+    for (const auto &uid : p2maIn.uids) {
+        auto spAccount = tx.GetAccount(*context.pCw, uid);
+        if (!spAccount || !spAccount->HasOwnerPubKey())
+            break;
+
+        accounts.push_back(spAccount);
+    }
+
+    vector<CSignatureCheck> checks;
+    checks.reserve(p2maIn.signatures.size() * accounts.size());
     for (const auto &signature : p2maIn.signatures) {
-        for (const auto uid : p2maIn.uids) {
-            auto spAccount = tx.GetAccount(context, uid, "uid");
-            if (!spAccount || !spAccount->HasOwnerPubKey())
+        for (const auto &spAccount : accounts) {
+            checks.emplace_back(utxoMultiSignHash, spAccount->owner_pubkey, signature);
+        }
+    }
+    vector<bool> results;
+    VerifySignatures(checks, results);
+
+    int verifyPassNum = 0;
+    for (size_t i = 0; i < p2maIn.signatures.size(); i++) {
+        for (size_t j = 0; j < p2maIn.uids.size(); j++) {
+            if (j >= accounts.size()) {
+                tx.GetAccount(context, p2maIn.uids[j], "uid");  // report the missing account
                 return false;
+            }
 
-            if (VerifySignature(utxoMultiSignHash, signature, spAccount->owner_pubkey)) {
+            if (results[i * accounts.size() + j]) {
                 verifyPassNum++;
                 break;
             }
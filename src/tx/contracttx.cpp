@@ -149,8 +149,7 @@ bool CLuaContractInvokeTx::CheckTx(CTxExecuteContext &context) {
     if ((txUid.is<CPubKey>()) && !txUid.get<CPubKey>().IsFullyValid())
         return state.DoS(100, ERRORMSG("public key is invalid"), REJECT_INVALID, "bad-publickey");
 
-    CUniversalContractStore contractStore;
-    if (!cw.contractCache.GetContract(app_uid.get<CRegID>(), contractStore))
+    if (!cw.contractCache.GetContractMeta(app_uid.get<CRegID>())->exists)
         return state.DoS(100, ERRORMSG("read script failed, regId=%s",
                         app_uid.get<CRegID>().ToString()), REJECT_INVALID, "bad-read-script");
 
@@ -173,8 +172,9 @@ bool CLuaContractInvokeTx::ExecuteTx(CTxExecuteContext &context) {
         return state.DoS(100, ERRORMSG("txAccount has insufficient funds"),
                          UPDATE_ACCOUNT_FAIL, "operate-minus-account-failed");
 
-    CUniversalContractStore contractStore;
-    if (!cw.contractCache.GetContract(app_uid.get<CRegID>(), contractStore))
+    // the code is shared with the contract cache, not copied
+    auto spContractMeta = cw.contractCache.GetContractMeta(app_uid.get<CRegID>());
+    if (!spContractMeta->exists)
         return state.DoS(100, ERRORMSG("read script failed, regId=%s",
                         app_uid.get<CRegID>().ToString()), READ_ACCOUNT_FAIL, "bad-read-script");
 
@@ -191,7 +191,7 @@ bool CLuaContractInvokeTx::ExecuteTx(CTxExecuteContext &context) {
     luaContext.transfer_amount   = coin_amount;
     luaContext.sp_tx_account     = sp_tx_account;
     luaContext.sp_app_account    = spAppAccount;
-    luaContext.p_contract        = &contractStore;
+    luaContext.p_contract        = spContractMeta->spStore.get();
     luaContext.p_arguments       = &arguments;
 
     int64_t llTime = GetTimeMillis();
@@ -359,8 +359,7 @@ bool CUniversalContractInvokeTx::CheckTx(CTxExecuteContext &context) {
                                 REJECT_INVALID, "invalid-coin-symbol");
     }
 
-    CUniversalContractStore contractStore;
-    if (!cw.contractCache.GetContract(app_uid.get<CRegID>(), contractStore))
+    if (!cw.contractCache.GetContractMeta(app_uid.get<CRegID>())->exists)
         return state.DoS(100, ERRORMSG("read script failed, regId=%s",
                         app_uid.get<CRegID>().ToString()), REJECT_INVALID, "bad-read-script");
 
@@ -383,8 +382,9 @@ bool CUniversalContractInvokeTx::ExecuteTx(CTxExecuteContext &context) {
         return state.DoS(100, ERRORMSG("txAccount has insufficient funds"),
                          UPDATE_ACCOUNT_FAIL, "operate-minus-account-failed");
 
-    CUniversalContractStore contractStore;
-    if (!cw.contractCache.GetContract(app_uid.get<CRegID>(), contractStore))
+    // the code is shared with the contract cache, not copied
+    auto spContractMeta = cw.contractCache.GetContractMeta(app_uid.get<CRegID>());
+    if (!spContractMeta->exists)
         return state.DoS(100, ERRORMSG("read contract failed, regId=%s", app_uid.get<CRegID>().ToString()),
                         READ_ACCOUNT_FAIL, "bad-read-contract");
 
@@ -401,7 +401,7 @@ bool CUniversalContractInvokeTx::ExecuteTx(CTxExecuteContext &context) {
     luaContext.transfer_amount   = coin_amount;
     luaContext.sp_tx_account     = sp_tx_account;
     luaContext.sp_app_account    = spAppAccount;
-    luaContext.p_contract        = &contractStore;
+    luaContext.p_contract        = spContractMeta->spStore.get();
     luaContext.p_arguments       = &arguments;
 
     int64_t llTime = GetTimeMillis();
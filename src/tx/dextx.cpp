@@ -90,6 +90,16 @@ namespace dex {
     ///////////////////////////////////////////////////////////////////////////////
     // class CDEXOrderBaseTx
 
+    void CDEXOrderBaseTx::GetSignatureChecks(CCacheWrapper &cw, int32_t height, vector<CSignatureCheck> &checks) {
+        CBaseTx::GetSignatureChecks(cw, height, checks);
+
+        if (has_operator_config && operator_uid.is<CRegID>()) {
+            CAccount operatorAccount;
+            if (cw.accountCache.GetAccount(operator_uid, operatorAccount))
+                checks.emplace_back(GetHash(), operatorAccount.owner_pubkey, operator_signature);
+        }
+    }
+
     bool CDEXOrderBaseTx::CheckTx(CTxExecuteContext &context) {
         CValidationState &state = *context.pState;
 
@@ -51,6 +51,7 @@ namespace dex {
 
         using CBaseTx::CBaseTx;
     public:
+        virtual void GetSignatureChecks(CCacheWrapper &cw, int32_t height, vector<CSignatureCheck> &checks);
         virtual bool CheckTx(CTxExecuteContext &context);
 
         virtual bool ExecuteTx(CTxExecuteContext &context);
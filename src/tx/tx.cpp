@@ -91,11 +91,7 @@ bool CBaseTx::CheckBaseTx(CTxExecuteContext &context) {
     CValidationState &state = *context.pState;
     ClearMemData();
 
-    if(    nTxType == BLOCK_REWARD_TX
-        || nTxType == PRICE_MEDIAN_TX
-        || nTxType == UCOIN_MINT_TX
-        || nTxType == UCOIN_BLOCK_REWARD_TX
-        || nTxType == CDP_FORCE_SETTLE_INTEREST_TX )
+    if (IsUnsignedTx())
         return true;
 
     sp_tx_account = GetAccount(context, txUid, "txUid");
@@ -380,6 +376,24 @@ bool CBaseTx::CheckMinFee(CTxExecuteContext &context, uint64_t minFee) {
     return true;
 }
 
+void CBaseTx::GetSignatureChecks(CCacheWrapper &cw, int32_t height, vector<CSignatureCheck> &checks) {
+    if (IsUnsignedTx() || GetFeatureForkVersion(height) < MAJOR_VER_R2)
+        return;
+
+    CPubKey pubKey;
+    if (txUid.is<CPubKey>()) {
+        pubKey = txUid.get<CPubKey>();
+    } else {
+        CAccount account;
+        if (!cw.accountCache.GetAccount(txUid, account) || !account.IsRegistered())
+            return;
+
+        pubKey = account.owner_pubkey;
+    }
+
+    checks.emplace_back(GetHash(), pubKey, signature);
+}
+
 bool CBaseTx::CheckTxAvailableFromVer(CTxExecuteContext &context, FeatureForkVersionEnum ver) {
     if (GetFeatureForkVersion(context.height) < ver)
         return context.pState->DoS(100, ERRORMSG("[%d]tx type=%s is unavailable before height=%d",
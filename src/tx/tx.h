@@ -185,6 +185,10 @@ public:
     virtual bool GetInvolvedKeyIds(CCacheWrapper &cw, set<CKeyID> &keyIds);
 
     bool CheckBaseTx(CTxExecuteContext &context);
+    // Collect the signatures which will be verified by CheckBaseTx()/CheckTx() against the read-only state
+    // of cw, so they can be pre-verified in parallel before the tx is executed. Signatures that can not be
+    // resolved yet (eg. signer registered in the same block) are skipped and checked on execution.
+    virtual void GetSignatureChecks(CCacheWrapper &cw, int32_t height, vector<CSignatureCheck> &checks);
     virtual bool CheckTx(CTxExecuteContext &context) = 0;
     virtual bool ExecuteTx(CTxExecuteContext &context) = 0;
     bool ExecuteFullTx(CTxExecuteContext &context);
@@ -200,6 +204,11 @@ public:
     bool IsPriceFeedTx()    { return nTxType == PRICE_FEED_TX; }
     bool IsCoinMintTx()     { return nTxType == UCOIN_MINT_TX; }
     bool IsRelayForbidden() { return kForbidRelayTxSet.count(nTxType) > 0; }
+    // system txs produced by the block producer which carry no user signature
+    bool IsUnsignedTx() const {
+        return nTxType == BLOCK_REWARD_TX || nTxType == PRICE_MEDIAN_TX || nTxType == UCOIN_MINT_TX ||
+               nTxType == UCOIN_BLOCK_REWARD_TX || nTxType == CDP_FORCE_SETTLE_INTEREST_TX;
+    }
 
     const string& GetTxTypeName() const { return ::GetTxTypeName(nTxType); }
 
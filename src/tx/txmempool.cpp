@@ -5,8 +5,10 @@
 
 #include "txmempool.h"
 #include "commons/uint256.h"
+#include "commons/workerpool.h"
 #include "main.h"
 #include "persistence/txdb.h"
+#include "tx/cointransfertx.h"
 #include "tx/tx.h"
 #include "miner/miner.h"
 
@@ -44,13 +46,21 @@ CTxMemPool::CTxMemPool() {
     fSanityCheck         = false;
 }
 
+// estimated memory of an entry besides the serialized tx: the tx object, the entry and the index nodes
+static const uint64_t MEMPOOL_ENTRY_OVERHEAD = 512;
+
+static uint64_t GetEntryMemUsage(const CTxMemPoolEntry &entry) {
+    return entry.GetTxSize() + MEMPOOL_ENTRY_OVERHEAD;
+}
+
 void CTxMemPool::Remove(CBaseTx *pBaseTx, list<std::shared_ptr<CBaseTx> > &removed, bool fRecursive) {
     // Remove transaction from memory pool
     LOCK(cs);
     uint256 txid = pBaseTx->GetHash();
-    if (memPoolTxs.count(txid)) {
-        removed.push_front(std::shared_ptr<CBaseTx>(memPoolTxs[txid].GetTransaction()));
-        memPoolTxs.erase(txid);
+    auto it = memPoolTxs.find(txid);
+    if (it != memPoolTxs.end()) {
+        removed.push_front(std::shared_ptr<CBaseTx>(it->second.GetTransaction()));
+        EraseTx(it);
         EraseTransactionFromWallet(txid);
     }
 }
@@ -59,21 +69,70 @@ void CTxMemPool::Remove(const uint256 &txid) {
     LOCK(cs);
     auto it = memPoolTxs.find(txid);
     if (it != memPoolTxs.end()) {
-        memPoolTxs.erase(it);
+        EraseTx(it);
         EraseTransactionFromWallet(txid);
     }
 }
 
+void CTxMemPool::EraseConfirmedTx(const uint256 &txid) {
+    LOCK(cs);
+    auto it = memPoolTxs.find(txid);
+    if (it != memPoolTxs.end())
+        EraseTx(it);
+}
+
 bool CTxMemPool::AddUnchecked(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state) {
     // Add to memory pool without checking anything.
     // Used by main.cpp AcceptToMemoryPool(), which DOES
     // all the appropriate checks.
     LOCK(cs);
     {
-        if (!CheckTxInMemPool(txid, entry, state, memPoolTxs.size()))
+        static uint64_t maxMemUsage = SysCfg().GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
+
+        // The pool is full, reject the tx before executing it if it can not outbid the lowest fee rate in the pool
+        // even without burning any fuel
+        if (memUsage + GetEntryMemUsage(entry) > maxMemUsage && !txFeeRates.empty()) {
+            double maxFeePerKb = double(std::get<1>(entry.GetFees())) / entry.GetTxSize() * 1000.0;
+            if (maxFeePerKb <= txFeeRates.begin()->first) {
+                LogPrint(BCLog::INFO, "mempool is full, txid %s fee_per_kb=%.2f too low\n", txid.GetHex(), maxFeePerKb);
+                return state.Invalid(false, REJECT_INSUFFICIENTFEE, "mempool-full");
+            }
+        }
+
+        // cw still holds the changes of the txs evicted since the last rescan, the accounts they touched are
+        // refused until the next tip rescans the pool
+        if (!staleKeyIds.empty() && TouchesStaleKeyIds(*entry.GetTransaction())) {
+            LogPrint(BCLog::INFO, "txid %s touches the accounts of the evicted txs, retry after the next block\n",
+                     txid.GetHex());
+            return state.Invalid(false, REJECT_INSUFFICIENTFEE, "mempool-full");
+        }
+
+        // the changes of the tx reach cw only once it is sure to stay in the pool
+        std::shared_ptr<CCacheWrapper> spTxCW;
+        if (!CheckTxInMemPool(txid, entry, state, memPoolTxs.size(), true, &spTxCW))
             return false;
 
-        memPoolTxs.insert(make_pair(txid, entry));
+        auto ret = memPoolTxs.insert(make_pair(txid, entry));
+        if (ret.second) {
+            uint32_t fuelRate = GetTipFuelRate(chainActive.Tip());
+            if (fuelRate != priorityFuelRate)
+                RebuildPriorityTxs(fuelRate);
+
+            AddTxIndex(txid, ret.first->second);
+
+            // the new tx is executed but not flushed yet, its eviction leaves nothing stale in cw
+            TrimToMemUsage(maxMemUsage, txid);
+            if (!memPoolTxs.count(txid))
+                return state.Invalid(false, REJECT_INSUFFICIENTFEE, "mempool-full");
+
+            // the new tx was executed on the changes of the txs evicted now
+            if (!staleKeyIds.empty() && TouchesStaleKeyIds(*entry.GetTransaction())) {
+                EraseTx(memPoolTxs.find(txid));
+                return state.Invalid(false, REJECT_INSUFFICIENTFEE, "mempool-full");
+            }
+
+            spTxCW->Flush();
+        }
     }
     return true;
 }
@@ -88,8 +147,18 @@ void CTxMemPool::QueryHash(vector<uint256> &txids) {
     }
 }
 
+void CTxMemPool::QueryHashByPriority(vector<uint256> &txids) {
+    LOCK(cs);
+
+    txids.clear();
+    txids.reserve(memPoolTxs.size());
+    for (auto it = txPriorities.rbegin(); it != txPriorities.rend(); ++it) {
+        txids.push_back(it->baseTx->GetHash());
+    }
+}
+
 bool CTxMemPool::CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &memPoolEntry, CValidationState &state, int32_t index,
-                                  bool bRehearsalExecute) {
+                                  bool bRehearsalExecute, std::shared_ptr<CCacheWrapper> *pspTxCW) {
     auto bm = MAKE_BENCHMARK("execute tx in mempool");
     CBlockIndex *pTip =  chainActive.Tip();
     if (pTip == nullptr)
@@ -114,7 +183,7 @@ bool CTxMemPool::CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &me
 
     if (bRehearsalExecute) { //always true so far
         const auto &bpRegid = GetBlockBpRegid(*chainActive.TipBlock());
-        uint32_t fuelRate  = GetElementForBurn(pTip);
+        uint32_t fuelRate  = GetTipFuelRate(pTip);
         uint32_t blockTime = pTip->GetBlockTime();
         uint32_t prevBlockTime = pTip->pprev != nullptr ? pTip->pprev->GetBlockTime() : pTip->GetBlockTime();
         CTxExecuteContext context(newHeight, index, fuelRate, blockTime, prevBlockTime, bpRegid, spCW.get(), &state,
@@ -127,45 +196,596 @@ bool CTxMemPool::CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &me
         }
     }
 
-    spCW->Flush();
+    if (pspTxCW != nullptr)
+        *pspTxCW = spCW;
+    else
+        spCW->Flush();
 
     return true;
 }
 
+uint32_t CTxMemPool::GetTipFuelRate(CBlockIndex *pTip) {
+    if (pTip->GetBlockHash() != fuelRateTipHash) {
+        fuelRateTipHash = pTip->GetBlockHash();
+        tipFuelRate     = GetElementForBurn(pTip);
+    }
+    return tipFuelRate;
+}
+
 void CTxMemPool::SetMemPoolCache() {
     cw.reset(new CCacheWrapper(pCdMan));
 }
 
+// The accounts touched by a tx that qualifies for the parallel rescan: the sender and the receivers. Only the
+// coin transfers qualify, they read and change the accounts, the receipts and the dex orders by key only.
+static bool GetParallelRescanKeyIds(CBaseTx &tx, CCacheWrapper &cw, set<CKeyID> &keyIds) {
+    vector<CUserID> uids = {tx.txUid};
+    if (tx.nTxType == BCOIN_TRANSFER_TX) {
+        uids.push_back(((CBaseCoinTransferTx &)tx).toUid);
+    } else if (tx.nTxType == UCOIN_TRANSFER_TX) {
+        for (const auto &transfer : ((CCoinTransferTx &)tx).transfers)
+            uids.push_back(transfer.to_uid);
+    } else {
+        return false;
+    }
+
+    for (const auto &uid : uids) {
+        CKeyID keyId;
+        if (!cw.accountCache.GetKeyId(uid, keyId))
+            return false;
+
+        keyIds.insert(keyId);
+    }
+    return true;
+}
+
+namespace {
+    // re-execute the pool txs on the chain state of the new tip
+    class CMemPoolRescanner : public CTxRescanner {
+    public:
+        CMemPoolRescanner(const vector<CBaseTx *> &txsIn, CBlockIndex *pTip, uint32_t fuelRateIn)
+            : txs(txsIn), bpRegid(GetBlockBpRegid(*chainActive.TipBlock())) {
+            newHeight     = pTip->height + 1;
+            fuelRate      = fuelRateIn;
+            blockTime     = pTip->GetBlockTime();
+            prevBlockTime = pTip->pprev != nullptr ? pTip->pprev->GetBlockTime() : pTip->GetBlockTime();
+        }
+
+    protected:
+        std::shared_ptr<CCacheWrapper> NewView() { return std::make_shared<CCacheWrapper>(pCdMan); }
+
+        void SetSharedRead(bool sharedRead) { pCdMan->SetSharedRead(sharedRead); }
+
+        bool ExecuteTx(size_t index, CCacheWrapper &cw, bool parallel) {
+            static int validHeight = SysCfg().GetTxCacheHeight();
+            CBaseTx &tx = *txs[index];
+            // the qualified txs are checked before they are handed to the workers
+            if (!parallel) {
+                if (!tx.IsValidHeight(newHeight, validHeight)) {
+                    LogPrint(BCLog::INFO, "valid_height(%d) of txid %s is invalid! new_height=%d\n", tx.valid_height,
+                             tx.GetHash().GetHex(), newHeight);
+                    return false;
+                }
+                if (cw.txCache.HasTx(tx.GetHash())) {
+                    LogPrint(BCLog::INFO, "txid %s confirmed in block\n", tx.GetHash().GetHex());
+                    return false;
+                }
+            }
+
+            CValidationState state;
+            CTxExecuteContext context(newHeight, index, fuelRate, blockTime, prevBlockTime, bpRegid, &cw, &state,
+                                      TxExecuteContextType::VALIDATE_MEMPOOL);
+            if (!tx.ExecuteFullTx(context)) {
+                // a failed group is executed one by one again, the failure is logged then
+                if (!parallel)
+                    pCdMan->pLogCache->SetExecuteFail(newHeight, tx.GetHash(), state.GetRejectCode(),
+                                                      state.GetRejectReason());
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        const vector<CBaseTx *> &txs;
+        CRegID bpRegid;
+        HeightType newHeight;
+        uint32_t fuelRate;
+        uint32_t blockTime;
+        uint32_t prevBlockTime;
+    };
+}
+
 void CTxMemPool::ReScanMemPoolTx() {
     auto bm = MAKE_BENCHMARK("rescan all tx in mempool");
-    cw.reset(new CCacheWrapper(pCdMan));
+    CBlockIndex *pTip = chainActive.Tip();
+    if (pTip == nullptr)
+        throw runtime_error("ReScanMemPoolTx:: ChainActive.Tip() is null");
 
     LOCK(cs);
-    CValidationState state;
-    int index = 0;
-    for (map<uint256, CTxMemPoolEntry>::iterator iterTx = memPoolTxs.begin(); iterTx != memPoolTxs.end(); ++index) {
-        if (!CheckTxInMemPool(iterTx->first, iterTx->second, state, index, true)) {
-            uint256 txid = iterTx->first;
-            iterTx       = memPoolTxs.erase(iterTx++);
-            EraseTransactionFromWallet(txid);
+    staleKeyIds.clear();
+    // re-execute the txs in the order they entered the pool, the later txs may depend on the earlier ones
+    vector<uint256> txids;
+    vector<CBaseTx *> txs;
+    txids.reserve(txEntrySeqs.size());
+    txs.reserve(txEntrySeqs.size());
+    for (const auto &item : txEntrySeqs) {
+        txids.push_back(item.second);
+        txs.push_back(memPoolTxs[item.second].GetTransaction().get());
+    }
+
+    vector<CTxRescanner::Item> items(txs.size());
+    CWorkerPool *pPool = GetSigCheckPool();
+    if (pPool == nullptr || pPool->GetWorkerCount() == 0 || txs.size() < MEMPOOL_PARALLEL_RESCAN_MIN_TXS) {
+        pPool = nullptr;
+    } else {
+        static int validHeight = SysCfg().GetTxCacheHeight();
+        HeightType newHeight   = pTip->height + 1;
+        CCacheWrapper keyIdCw(pCdMan);
+        for (size_t index = 0; index < txs.size(); ++index) {
+            CBaseTx &tx = *txs[index];
+            items[index].qualified = tx.IsValidHeight(newHeight, validHeight) && !keyIdCw.txCache.HasTx(txids[index]) &&
+                                     GetParallelRescanKeyIds(tx, keyIdCw, items[index].keyIds);
+            if (!items[index].qualified)
+                tx.GetInvolvedKeyIds(keyIdCw, items[index].keyIds);
+        }
+    }
+
+    vector<bool> passed;
+    CMemPoolRescanner rescanner(txs, pTip, GetTipFuelRate(pTip));
+    cw = rescanner.Rescan(items, pPool, passed);
+    for (size_t index = 0; index < txids.size(); ++index) {
+        if (!passed[index]) {
+            EraseTx(memPoolTxs.find(txids[index]));
+            EraseTransactionFromWallet(txids[index]);
+        }
+    }
+
+    // the fuel of the txs is updated by the re-execution, and the fuel rate may change with the new tip
+    RebuildPriorityTxs(GetTipFuelRate(pTip));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class CTxRescanner
+
+// txs sharing accounts, re-executed one by one on a worker thread
+struct CTxRescanner::Group {
+    vector<size_t> txIndexes;  // positions in items
+    CDBOpLogMap dbOpLogMap;    // the redo logs and the reads
+    set<string> writtenKeys;   // db keys of the redo logs
+    bool passed = false;
+};
+
+static size_t FindRescanGroup(vector<size_t> &parents, size_t index) {
+    while (parents[index] != index) {
+        parents[index] = parents[parents[index]];
+        index          = parents[index];
+    }
+    return index;
+}
+
+static bool HasCommonKey(const set<string> &keys1, const set<string> &keys2) {
+    const set<string> &smaller = keys1.size() < keys2.size() ? keys1 : keys2;
+    const set<string> &larger  = keys1.size() < keys2.size() ? keys2 : keys1;
+    for (const auto &key : smaller) {
+        if (larger.count(key))
+            return true;
+    }
+    return false;
+}
+
+static bool HasPrefixedKey(const set<string> &keys, const set<string> &prefixes) {
+    for (const auto &prefix : prefixes) {
+        auto it = keys.lower_bound(prefix);
+        if (it != keys.end() && it->compare(0, prefix.size(), prefix) == 0)
+            return true;
+    }
+    return false;
+}
+
+// The keys of the applied groups map to the last tx of the groups, a key is open to the txs before that one.
+typedef map<string, size_t> RescanOpenKeys;
+
+static void AddOpenKeys(const set<string> &keys, size_t lastIndex, RescanOpenKeys &openKeys) {
+    for (const auto &key : keys) {
+        size_t &last = openKeys[key];
+        last         = std::max(last, lastIndex);
+    }
+}
+
+static bool HasOpenKey(const set<string> &keys, const RescanOpenKeys &openKeys, size_t index) {
+    for (const auto &key : keys) {
+        auto it = openKeys.find(key);
+        if (it != openKeys.end() && it->second > index)
+            return true;
+    }
+    return false;
+}
+
+static bool HasOpenPrefixedKey(const set<string> &prefixes, const RescanOpenKeys &openKeys, size_t index) {
+    for (const auto &prefix : prefixes) {
+        for (auto it = openKeys.lower_bound(prefix); it != openKeys.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            if (it->second > index)
+                return true;
+        }
+    }
+    return false;
+}
+
+std::shared_ptr<CCacheWrapper> CTxRescanner::Rescan(const vector<Item> &items, CWorkerPool *pPool,
+                                                    vector<bool> &passed) {
+    vector<Group> groups;
+    vector<int32_t> itemGroups(items.size(), -1);
+    if (pPool != nullptr)
+        ExecuteGroups(items, *pPool, groups, itemGroups);
+
+    if (std::find_if(itemGroups.begin(), itemGroups.end(), [](int32_t group) { return group >= 0; }) ==
+        itemGroups.end())
+        return RescanSerial(items.size(), passed);
+
+    passed.assign(items.size(), false);
+    auto spCw = NewView();
+    set<string> writtenKeys;  // changed on spCw so far
+    RescanOpenKeys openWrites, openReads, openReadPrefixes;
+    size_t parallelTxCount = 0;
+    for (size_t index = 0; index < items.size(); ++index) {
+        int32_t groupIndex = itemGroups[index];
+        if (groupIndex >= 0 && index == groups[groupIndex].txIndexes.front()) {
+            Group &group = groups[groupIndex];
+            const CDBOpLogMap &logs = group.dbOpLogMap;
+            if (HasCommonKey(logs.GetReadKeys(), writtenKeys) || HasCommonKey(group.writtenKeys, writtenKeys) ||
+                HasPrefixedKey(writtenKeys, logs.GetReadPrefixes())) {
+                // an earlier tx changed what the group was executed on
+                for (size_t txIndex : group.txIndexes)
+                    itemGroups[txIndex] = -1;
+            } else {
+                if (!spCw->ApplyRedoLogs(logs))
+                    return RescanSerial(items.size(), passed);
+
+                size_t lastIndex = group.txIndexes.back();
+                AddOpenKeys(group.writtenKeys, lastIndex, openWrites);
+                AddOpenKeys(logs.GetReadKeys(), lastIndex, openReads);
+                AddOpenKeys(logs.GetReadPrefixes(), lastIndex, openReadPrefixes);
+                writtenKeys.insert(group.writtenKeys.begin(), group.writtenKeys.end());
+                for (size_t txIndex : group.txIndexes)
+                    passed[txIndex] = true;
+                parallelTxCount += group.txIndexes.size();
+            }
+        }
+        if (itemGroups[index] >= 0)
             continue;
+
+        CDBOpLogMap dbOpLogMap;
+        dbOpLogMap.SetRecordRedo(true);
+        dbOpLogMap.SetRecordRead(true);
+        auto spTxCw = std::make_shared<CCacheWrapper>(spCw.get());
+        spTxCw->SetDbOpLogMap(&dbOpLogMap);
+        bool txPassed = ExecuteTx(index, *spTxCw, false);
+
+        // the changes of the groups with txs after this one are already in spCw
+        set<string> txWrittenKeys = dbOpLogMap.GetRedoKeys();
+        if (HasOpenKey(dbOpLogMap.GetReadKeys(), openWrites, index) || HasOpenKey(txWrittenKeys, openWrites, index) ||
+            HasOpenPrefixedKey(dbOpLogMap.GetReadPrefixes(), openWrites, index) ||
+            HasOpenKey(txWrittenKeys, openReads, index)) {
+            LogPrint(BCLog::INFO, "parallel rescan: tx %u depends on a later parallel tx, rescan one by one\n", index);
+            return RescanSerial(items.size(), passed);
+        }
+        for (const auto &item : openReadPrefixes) {
+            if (item.second > index && HasPrefixedKey(txWrittenKeys, {item.first})) {
+                LogPrint(BCLog::INFO, "parallel rescan: tx %u depends on a later parallel tx, rescan one by one\n",
+                         index);
+                return RescanSerial(items.size(), passed);
+            }
+        }
+
+        if (txPassed) {
+            spTxCw->Flush();
+            writtenKeys.insert(txWrittenKeys.begin(), txWrittenKeys.end());
+            passed[index] = true;
         }
-        ++iterTx;
     }
+
+    LogPrint(BCLog::INFO, "parallel rescan: %u of %u txs re-executed in %u groups\n", parallelTxCount, items.size(),
+             groups.size());
+    return spCw;
+}
+
+/**
+ * The qualified txs are partitioned by the accounts they touch, a partition sharing an account with a tx which
+ * does not qualify is left out. Every worker executes its share of the partitions on its own view, recording
+ * the reads and the changes of each partition. The partitions which failed, or read or changed a key changed by
+ * another partition, are left to the execution one by one.
+ */
+void CTxRescanner::ExecuteGroups(const vector<Item> &items, CWorkerPool &pool, vector<Group> &groups,
+                                 vector<int32_t> &itemGroups) {
+    // 1. group the qualified txs sharing accounts, union-find over the positions of the txs
+    vector<size_t> parents(items.size());
+    map<CKeyID, size_t> keyIdOwners;
+    set<CKeyID> serialKeyIds;  // accounts touched by the txs executed one by one
+    for (size_t index = 0; index < items.size(); ++index) {
+        parents[index] = index;
+        if (!items[index].qualified) {
+            serialKeyIds.insert(items[index].keyIds.begin(), items[index].keyIds.end());
+            continue;
+        }
+
+        for (const auto &keyId : items[index].keyIds) {
+            auto ret = keyIdOwners.emplace(keyId, index);
+            if (!ret.second)
+                parents[FindRescanGroup(parents, index)] = FindRescanGroup(parents, ret.first->second);
+        }
+    }
+
+    set<size_t> serialRoots;
+    for (const auto &keyId : serialKeyIds) {
+        auto it = keyIdOwners.find(keyId);
+        if (it != keyIdOwners.end())
+            serialRoots.insert(FindRescanGroup(parents, it->second));
+    }
+
+    map<size_t, size_t> rootGroups;  // root position -> group
+    for (size_t index = 0; index < items.size(); ++index) {
+        if (!items[index].qualified)
+            continue;
+
+        size_t root = FindRescanGroup(parents, index);
+        if (serialRoots.count(root))
+            continue;
+
+        auto ret = rootGroups.emplace(root, groups.size());
+        if (ret.second)
+            groups.emplace_back();
+        groups[ret.first->second].txIndexes.push_back(index);
+    }
+    if (groups.empty())
+        return;
+
+    // 2. spread the groups over the workers by tx count and execute them
+    vector<vector<size_t>> chunks(std::min<size_t>(pool.GetWorkerCount() + 1, groups.size()));
+    vector<size_t> chunkTxCounts(chunks.size(), 0);
+    vector<std::shared_ptr<CCacheWrapper>> chunkViews;
+    for (size_t groupIndex = 0; groupIndex < groups.size(); ++groupIndex) {
+        size_t chunk = std::min_element(chunkTxCounts.begin(), chunkTxCounts.end()) - chunkTxCounts.begin();
+        chunks[chunk].push_back(groupIndex);
+        chunkTxCounts[chunk] += groups[groupIndex].txIndexes.size();
+    }
+    for (size_t chunk = 0; chunk < chunks.size(); ++chunk)
+        chunkViews.push_back(NewView());
+
+    SetSharedRead(true);
+    pool.ParallelFor(chunks.size(), [&](size_t chunk) {
+        for (size_t groupIndex : chunks[chunk]) {
+            Group &group = groups[groupIndex];
+            group.dbOpLogMap.SetRecordRedo(true);
+            group.dbOpLogMap.SetRecordRead(true);
+            group.passed = true;
+
+            CCacheWrapper groupCw(chunkViews[chunk].get());
+            for (size_t index : group.txIndexes) {
+                auto spCW = std::make_shared<CCacheWrapper>(&groupCw);
+                spCW->SetDbOpLogMap(&group.dbOpLogMap);
+                if (!ExecuteTx(index, *spCW, true)) {
+                    group.passed = false;
+                    break;
+                }
+                spCW->Flush();
+            }
+            group.writtenKeys = group.dbOpLogMap.GetRedoKeys();
+        }
+    });
+    SetSharedRead(false);
+
+    // 3. a key changed by a group and read or changed by another means they were executed without seeing each
+    // other
+    vector<bool> conflicted(groups.size(), false);
+    map<string, size_t> keyWriters;  // db key -> group
+    for (size_t groupIndex = 0; groupIndex < groups.size(); ++groupIndex) {
+        if (!groups[groupIndex].passed)
+            continue;
+
+        for (const auto &key : groups[groupIndex].writtenKeys) {
+            auto ret = keyWriters.emplace(key, groupIndex);
+            if (!ret.second && ret.first->second != groupIndex) {
+                conflicted[groupIndex]        = true;
+                conflicted[ret.first->second] = true;
+            }
+        }
+    }
+    for (size_t groupIndex = 0; groupIndex < groups.size(); ++groupIndex) {
+        if (!groups[groupIndex].passed)
+            continue;
+
+        const CDBOpLogMap &logs = groups[groupIndex].dbOpLogMap;
+        for (const auto &key : logs.GetReadKeys()) {
+            auto it = keyWriters.find(key);
+            if (it != keyWriters.end() && it->second != groupIndex) {
+                conflicted[groupIndex] = true;
+                conflicted[it->second] = true;
+            }
+        }
+        for (const auto &prefix : logs.GetReadPrefixes()) {
+            for (auto it = keyWriters.lower_bound(prefix);
+                 it != keyWriters.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+                if (it->second != groupIndex) {
+                    conflicted[groupIndex] = true;
+                    conflicted[it->second] = true;
+                }
+            }
+        }
+    }
+
+    for (size_t groupIndex = 0; groupIndex < groups.size(); ++groupIndex) {
+        if (!groups[groupIndex].passed || conflicted[groupIndex])
+            continue;
+
+        for (size_t index : groups[groupIndex].txIndexes)
+            itemGroups[index] = groupIndex;
+    }
+}
+
+std::shared_ptr<CCacheWrapper> CTxRescanner::RescanSerial(size_t count, vector<bool> &passed) {
+    passed.assign(count, false);
+    auto spCw = NewView();
+    for (size_t index = 0; index < count; ++index) {
+        auto spTxCw = std::make_shared<CCacheWrapper>(spCw.get());
+        if (ExecuteTx(index, *spTxCw, false)) {
+            spTxCw->Flush();
+            passed[index] = true;
+        }
+    }
+    return spCw;
 }
 
 void CTxMemPool::Clear() {
     LOCK(cs);
 
     memPoolTxs.clear();
+    txIndexes.clear();
+    txPriorities.clear();
+    txFeeRates.clear();
+    txEntrySeqs.clear();
+    txSenders.clear();
+    staleKeyIds.clear();
+    memUsage = 0;
     cw.reset(new CCacheWrapper(pCdMan));
 }
 
+const set<TxPriority> *CTxMemPool::GetPriorityTxs(uint32_t fuelRate) const {
+    AssertLockHeld(cs);
+    if (fuelRate != priorityFuelRate || txPriorities.size() != memPoolTxs.size())
+        return nullptr;
+
+    return &txPriorities;
+}
+
+void CTxMemPool::AddTxIndex(const uint256 &txid, const CTxMemPoolEntry &entry) {
+    TxIndexEntry &indexEntry = txIndexes[txid];
+    indexEntry.entrySeq      = nextEntrySeq++;
+    indexEntry.memUsage      = GetEntryMemUsage(entry);
+    txEntrySeqs.emplace(indexEntry.entrySeq, txid);
+    memUsage += indexEntry.memUsage;
+
+    if (cw->accountCache.GetKeyId(entry.GetTransaction()->txUid, indexEntry.sender))
+        txSenders[indexEntry.sender].emplace(indexEntry.entrySeq, txid);
+
+    AddPriorityIndex(txid, entry, indexEntry);
+}
+
+void CTxMemPool::RemoveTxIndex(const uint256 &txid) {
+    auto it = txIndexes.find(txid);
+    if (it == txIndexes.end())
+        return;
+
+    TxIndexEntry &indexEntry = it->second;
+    RemovePriorityIndex(txid, indexEntry);
+    txEntrySeqs.erase(indexEntry.entrySeq);
+    memUsage -= indexEntry.memUsage;
+
+    auto senderIt = txSenders.find(indexEntry.sender);
+    if (senderIt != txSenders.end()) {
+        senderIt->second.erase(indexEntry.entrySeq);
+        if (senderIt->second.empty())
+            txSenders.erase(senderIt);
+    }
+    txIndexes.erase(it);
+}
+
+void CTxMemPool::AddPriorityIndex(const uint256 &txid, const CTxMemPoolEntry &entry, TxIndexEntry &indexEntry) {
+    auto spBaseTx = entry.GetTransaction();
+    if (spBaseTx->IsBlockRewardTx())
+        return;
+
+    HeightType height = chainActive.Height() + 1;
+    uint64_t fee      = std::get<1>(entry.GetFees());
+    double feePerKb   = double(fee - spBaseTx->GetFuelFee(*cw, height, priorityFuelRate)) / entry.GetTxSize() * 1000.0;
+
+    auto ret = txPriorities.emplace(TxPriority(entry.GetPriority(), feePerKb, spBaseTx));
+    if (ret.second) {
+        indexEntry.hasPriority = true;
+        indexEntry.priorityIt  = ret.first;
+        indexEntry.feePerKb    = feePerKb;
+        txFeeRates.emplace(feePerKb, txid);
+    }
+}
+
+void CTxMemPool::RemovePriorityIndex(const uint256 &txid, TxIndexEntry &indexEntry) {
+    if (indexEntry.hasPriority) {
+        txPriorities.erase(indexEntry.priorityIt);
+        txFeeRates.erase(make_pair(indexEntry.feePerKb, txid));
+        indexEntry.hasPriority = false;
+    }
+}
+
+void CTxMemPool::RebuildPriorityTxs(uint32_t fuelRate) {
+    txPriorities.clear();
+    txFeeRates.clear();
+    priorityFuelRate = fuelRate;
+    for (auto &item : txIndexes) {
+        item.second.hasPriority = false;
+        AddPriorityIndex(item.first, memPoolTxs[item.first], item.second);
+    }
+}
+
+void CTxMemPool::EraseTx(map<uint256, CTxMemPoolEntry>::iterator it) {
+    RemoveTxIndex(it->first);
+    memPoolTxs.erase(it);
+}
+
+bool CTxMemPool::TouchesStaleKeyIds(CBaseTx &tx) {
+    set<CKeyID> keyIds;
+    if (!tx.GetInvolvedKeyIds(*cw, keyIds))
+        return true;
+
+    for (const auto &keyId : keyIds) {
+        if (staleKeyIds.count(keyId))
+            return true;
+    }
+    return false;
+}
+
+uint32_t CTxMemPool::EvictTx(const uint256 &txid, const uint256 &unflushedTxid) {
+    // the later txs of the sender were executed on the changes of the tx, they go with it
+    const TxIndexEntry &indexEntry = txIndexes[txid];
+    vector<uint256> txids          = {txid};
+    auto senderIt                  = txSenders.find(indexEntry.sender);
+    if (senderIt != txSenders.end()) {
+        for (auto it = senderIt->second.upper_bound(indexEntry.entrySeq); it != senderIt->second.end(); ++it)
+            txids.push_back(it->second);
+    }
+
+    for (const auto &evictedTxid : txids) {
+        auto it = memPoolTxs.find(evictedTxid);
+        if (evictedTxid != unflushedTxid)
+            it->second.GetTransaction()->GetInvolvedKeyIds(*cw, staleKeyIds);
+
+        EraseTx(it);
+        EraseTransactionFromWallet(evictedTxid);
+    }
+    return txids.size();
+}
+
+uint32_t CTxMemPool::TrimToMemUsage(uint64_t maxMemUsage, const uint256 &unflushedTxid) {
+    uint32_t evictedCount = 0;
+    while (memUsage > maxMemUsage && !txFeeRates.empty()) {
+        evictedCount += EvictTx(txFeeRates.begin()->second, unflushedTxid);
+    }
+
+    if (evictedCount > 0)
+        LogPrint(BCLog::INFO, "mempool is full, evicted %u tx(s) with the lowest fee rate and their sender's later "
+                 "txs, mem_usage=%llu\n", evictedCount, memUsage);
+
+    return evictedCount;
+}
+
 uint64_t CTxMemPool::Size() {
     LOCK(cs);
     return memPoolTxs.size();
 }
 
+uint64_t CTxMemPool::GetMemUsage() {
+    LOCK(cs);
+    return memUsage;
+}
+
 bool CTxMemPool::Exists(const uint256 txid) {
     LOCK(cs);
     return ((memPoolTxs.count(txid) != 0));
@@ -10,17 +10,42 @@
 #include "entities/account.h"
 #include "persistence/cachewrapper.h"
 #include "sync.h"
+#include "tx/tx.h"
 
+#include <cmath>
 #include <list>
 #include <map>
 #include <memory>
+#include <set>
 
 using namespace std;
 
 class CValidationState;
 class CBaseTx;
+class CWorkerPool;
 class uint256;
 
+struct TxPriority {
+    double priority;
+    double feePerKb;
+    std::shared_ptr<CBaseTx> baseTx;
+
+    TxPriority(const double priorityIn, const double feePerKbIn, const std::shared_ptr<CBaseTx> &baseTxIn)
+        : priority(priorityIn), feePerKb(feePerKbIn), baseTx(baseTxIn) {}
+
+    bool operator<(const TxPriority &other) const {
+        if (fabs(this->priority - other.priority) <= 1000) {
+            if (fabs(this->feePerKb < other.feePerKb) <= 1e-8) {
+                return this->baseTx->GetHash() < other.baseTx->GetHash();
+            } else {
+                return this->feePerKb < other.feePerKb;
+            }
+        } else {
+            return this->priority < other.priority;
+        }
+    }
+};
+
 /*
  * CTxMemPool stores these:
  */
@@ -49,6 +74,48 @@ public:
     inline uint32_t GetHeight() const { return height; }
 };
 
+/**
+ * Re-executes a list of txs in order on a new cache view, with the same result as executing them one by one.
+ *
+ * The qualified txs are grouped by the accounts they share and the groups are executed on the worker threads,
+ * all of them on views over the same chain state. The db keys every group and every other tx reads and changes
+ * are recorded. Walking the list in order, a group is applied to the result at its first tx, and the other txs
+ * are executed in between. A group is executed one by one instead if it reads or changes a key changed by
+ * another group or by an earlier tx, and the whole list is executed one by one again if a tx reads or changes a
+ * key of a group which has txs after it. The recorded reads do not cover the memory-only caches and the
+ * metadata of the contracts, which the qualified txs must neither read nor change.
+ */
+class CTxRescanner {
+public:
+    struct Item {
+        bool qualified = false;  // may be executed on the worker threads
+        set<CKeyID> keyIds;      // the accounts the tx touches
+    };
+
+public:
+    virtual ~CTxRescanner() {}
+
+    /**
+     * Execute the txs of items, the qualified ones on pPool if it is not null. Returns the view holding the
+     * changes of the passed txs, passed[i] tells whether items[i] passed.
+     */
+    std::shared_ptr<CCacheWrapper> Rescan(const vector<Item> &items, CWorkerPool *pPool, vector<bool> &passed);
+
+protected:
+    // a new view over the chain state the txs are executed on
+    virtual std::shared_ptr<CCacheWrapper> NewView() = 0;
+    // the chain state under the views is read by the worker threads while set
+    virtual void SetSharedRead(bool sharedRead) {}
+    // execute the tx of items[index] on cw, parallel tells whether it runs on a worker thread
+    virtual bool ExecuteTx(size_t index, CCacheWrapper &cw, bool parallel) = 0;
+
+private:
+    struct Group;
+    void ExecuteGroups(const vector<Item> &items, CWorkerPool &pool, vector<Group> &groups,
+                       vector<int32_t> &itemGroups);
+    std::shared_ptr<CCacheWrapper> RescanSerial(size_t count, vector<bool> &passed);
+};
+
 /*
  * CTxMemPool stores valid-according-to-the-current-best-chain
  * transactions that may be included in the next block.
@@ -74,18 +141,68 @@ public:
     void Remove(CBaseTx *pBaseTx, list<std::shared_ptr<CBaseTx> > &removed, bool fRecursive = false);
     void Remove(const uint256 &txid);
     void QueryHash(vector<uint256> &txids);
+    /** txids ordered by block producing priority, the highest first */
+    void QueryHashByPriority(vector<uint256> &txids);
+    /** Execute the tx on cw, its changes are flushed into cw, or handed over in pspTxCW if it is set */
     bool CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state, int32_t index,
-                          bool bRehearsalExecute = true);
+                          bool bRehearsalExecute = true, std::shared_ptr<CCacheWrapper> *pspTxCW = nullptr);
     void SetMemPoolCache();
     void ReScanMemPoolTx();
+    void EraseConfirmedTx(const uint256 &txid);
     void Clear();
 
+    /** The pool txs ordered by block producing priority, nullptr if the index is built for another fuel rate */
+    const set<TxPriority> *GetPriorityTxs(uint32_t fuelRate) const;
+
     uint64_t Size();
+    /** Estimated memory usage of the pool txs, limited by -maxmempool */
+    uint64_t GetMemUsage();
     bool Exists(const uint256 txid);
     std::shared_ptr<CBaseTx> Lookup(const uint256 txid) const;
 
+private:
+    // position of a pool tx in the secondary indexes
+    struct TxIndexEntry {
+        uint64_t entrySeq  = 0;
+        CKeyID sender;
+        uint64_t memUsage  = 0;
+        double feePerKb    = 0;
+        bool hasPriority   = false;
+        set<TxPriority>::iterator priorityIt;
+    };
+
+    void AddTxIndex(const uint256 &txid, const CTxMemPoolEntry &entry);
+    void RemoveTxIndex(const uint256 &txid);
+    void AddPriorityIndex(const uint256 &txid, const CTxMemPoolEntry &entry, TxIndexEntry &indexEntry);
+    void RemovePriorityIndex(const uint256 &txid, TxIndexEntry &indexEntry);
+    void RebuildPriorityTxs(uint32_t fuelRate);
+    // the fuel rate of the block on top of pTip, computed once per tip, requires LOCK(cs)
+    uint32_t GetTipFuelRate(CBlockIndex *pTip);
+    void EraseTx(map<uint256, CTxMemPoolEntry>::iterator it);
+    // evict the tx and the later txs of its sender, the accounts they touched become stale in cw unless the tx
+    // is unflushedTxid, returns the evicted count
+    uint32_t EvictTx(const uint256 &txid, const uint256 &unflushedTxid);
+    // evict the txs with the lowest fee rate until the pool fits in maxMemUsage, returns the evicted count
+    uint32_t TrimToMemUsage(uint64_t maxMemUsage, const uint256 &unflushedTxid);
+    bool TouchesStaleKeyIds(CBaseTx &tx);
+
 private:
     bool fSanityCheck; // Normally false, true if -checkmempool or -regtest
+
+    // Secondary indexes of memPoolTxs, kept up to date on every add and remove so that nothing has to walk and sort
+    // the whole pool. The fee per kb is net of the fuel fee at priorityFuelRate, the fuel rate of the next block.
+    map<uint256, TxIndexEntry> txIndexes;
+    set<TxPriority> txPriorities;                      // block producing order
+    set<pair<double, uint256>> txFeeRates;             // eviction order, the lowest fee per kb first
+    map<uint64_t, uint256> txEntrySeqs;                // the order of entering the pool
+    map<CKeyID, map<uint64_t, uint256>> txSenders;     // the txs of every sender in entry order
+    // the accounts touched by the txs evicted since the last rescan, their changes are still in cw
+    set<CKeyID> staleKeyIds;
+    uint32_t priorityFuelRate = 0;
+    uint256 fuelRateTipHash;
+    uint32_t tipFuelRate      = 0;
+    uint64_t nextEntrySeq     = 0;
+    uint64_t memUsage         = 0;
 };
 
 
@@ -59,13 +59,13 @@ void CUniversalTx::validate_contracts(CTxExecuteContext& context) {
         auto contract = wasm::name(inline_trx.contract);
         if (is_native_contract(contract.value)) continue;
 
-        CUniversalContractStore contract_store;
-        CHAIN_ASSERT( database.contractCache.GetContract(CRegID(contract.value), contract_store),
+        auto spMeta = database.contractCache.GetContractMeta(CRegID(contract.value));
+        CHAIN_ASSERT( spMeta->exists,
                       wasm_chain::contract_exception,
                       "cannot get contract with regid '%s'",
                       contract.to_string() )
 
-        CHAIN_ASSERT( contract_store.code.size() > 0 && contract_store.abi.size() > 0,
+        CHAIN_ASSERT( spMeta->spStore->code.size() > 0 && spMeta->spStore->abi.size() > 0,
                       wasm_chain::contract_exception,
                       "contract '%s' abi or code  does not exist",
                       contract.to_string() )
@@ -97,6 +97,27 @@ void CUniversalTx::validate_authorization(const std::vector<uint64_t>& authoriza
 
 //bool CUniversalTx::validate_payer_signature(CTxExecuteContext &context)
 
+void CUniversalTx::GetSignatureChecks(CCacheWrapper &cw, int32_t height, vector<CSignatureCheck> &checks) {
+    CBaseTx::GetSignatureChecks(cw, height, checks);
+    get_signature_checks(cw, checks);
+}
+
+void CUniversalTx::get_signature_checks(CCacheWrapper &database, vector<CSignatureCheck> &checks) {
+
+    TxID signature_hash = GetHash();
+
+    for (const auto &s : signatures) {
+        CRegID regid(s.account);
+        if (regid.IsEmpty()) continue;
+
+        CAccount account;
+        if (!database.accountCache.GetAccount(regid, account) || !account.owner_pubkey.IsValid())
+            continue;
+
+        checks.emplace_back(signature_hash, account.owner_pubkey, s.signature);
+    }
+}
+
 void
 CUniversalTx::get_accounts_from_signatures(CCacheWrapper& database, std::vector <uint64_t>& authorization_accounts) {
 
@@ -106,6 +127,12 @@ CUniversalTx::get_accounts_from_signatures(CCacheWrapper& database, std::vector
 
     auto spPayer = sp_tx_account;
 
+    // verify all the signatures in one batch, the checks below are answered by the signature cache
+    vector<CSignatureCheck> checks;
+    vector<bool> results;
+    get_signature_checks(database, checks);
+    VerifySignatures(checks, results);
+
     for (auto s : signatures) {
         CRegID regid(s.account);
         CHAIN_ASSERT( !regid.IsEmpty(),
@@ -390,11 +417,11 @@ string CUniversalTx::ToString(CAccountDBCache &accountCache) {
 static bool get_contract_abi(CContractDBCache &contractCache, uint64_t contractId, vector<char> &abi) {
 
     if(!get_native_contract_abi(contractId, abi)){
-        CUniversalContractStore contract_store;
-        if (!contractCache.GetContract(CRegID(contractId), contract_store)) {
+        auto spMeta = contractCache.GetContractMeta(CRegID(contractId));
+        if (!spMeta->exists) {
             return false;
         }
-        abi.insert(abi.end(), contract_store.abi.begin(), contract_store.abi.end());
+        abi.insert(abi.end(), spMeta->spStore->abi.begin(), spMeta->spStore->abi.end());
     }
     return true;
 }
@@ -74,6 +74,7 @@ public:
     virtual Object ToJson(CCacheWrapper &cw) const;
 
 
+    virtual void GetSignatureChecks(CCacheWrapper &cw, int32_t height, vector<CSignatureCheck> &checks);
     virtual bool CheckTx(CTxExecuteContext &context);
     virtual bool ExecuteTx(CTxExecuteContext &context);
 
@@ -83,6 +84,7 @@ public:
     void validate_authorization(const std::vector<uint64_t> &authorization_accounts);
     void get_accounts_from_signatures(CCacheWrapper &database,
                                           std::vector<uint64_t> &authorization_accounts);
+    void get_signature_checks(CCacheWrapper &database, vector<CSignatureCheck> &checks);
     void execute_inline_transaction( wasm::inline_transaction_trace &trace,
                                       wasm::inline_transaction &trx,
                                       uint64_t receiver,
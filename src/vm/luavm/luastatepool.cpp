@@ -0,0 +1,156 @@
+// Copyright (c) 2017-2020 The DragonBallChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "luastatepool.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits>
+
+void vm_openlibs(lua_State *L);
+
+bool InitLuaLibsEx(lua_State *L);
+
+static size_t AlignSize(size_t size) {
+    return (size + CLuaArena::ALIGNMENT - 1) & ~(CLuaArena::ALIGNMENT - 1);
+}
+
+CLuaArena::~CLuaArena() { free(base); }
+
+bool CLuaArena::Init() {
+    if (base == nullptr)
+        base = (char *)malloc(ARENA_SIZE);
+
+    return base != nullptr;
+}
+
+void *CLuaArena::New(size_t nsize) {
+    size_t size = AlignSize(nsize);
+    if (size <= ARENA_SIZE - top) {
+        char *block = base + top;
+        top += size;
+        return block;
+    }
+
+    heapAllocs++;
+    return malloc(nsize);
+}
+
+void *CLuaArena::Alloc(void *ud, void *ptr, size_t osize, size_t nsize) {
+    CLuaArena *arena = (CLuaArena *)ud;
+    if (ptr != nullptr && !arena->Contains(ptr)) {
+        if (nsize == 0) {
+            free(ptr);
+            return nullptr;
+        }
+        return realloc(ptr, nsize);
+    }
+
+    if (ptr == nullptr)
+        return nsize == 0 ? nullptr : arena->New(nsize);
+
+    char *block = (char *)ptr;
+    size_t offset = block - arena->base;
+    bool onTop = (offset + AlignSize(osize) == arena->top);
+    if (nsize == 0) {
+        if (onTop)
+            arena->top = offset;
+        return nullptr;
+    }
+
+    if (onTop && AlignSize(nsize) <= ARENA_SIZE - offset) {
+        arena->top = offset + AlignSize(nsize);
+        return block;
+    }
+
+    if (nsize <= osize)
+        return block;  // shrink in place, the tail is wasted until the arena is released
+
+    void *newBlock = arena->New(nsize);
+    if (newBlock == nullptr)
+        return nullptr;
+
+    memcpy(newBlock, block, osize);
+    if (onTop)
+        arena->top = offset;  // the block did not fit in the arena and moved to the heap
+    return newBlock;
+}
+
+static int LuaPanic(lua_State *L) {
+    lua_writestringerror("PANIC: unprotected error in call to Lua API (%s)\n", lua_tostring(L, -1));
+    return 0;  // return to Lua to abort
+}
+
+CLuaStatePool &CLuaStatePool::GetThreadPool() {
+    static thread_local CLuaStatePool pool;
+    return pool;
+}
+
+lua_State *CLuaStatePool::Acquire(void *pContext, uint64_t fuelLimit, int burnVersion, lua_CFunction mylib) {
+    // a contract run inside another one of the same thread builds its own state
+    if (arena.inUse || !arena.Init())
+        return nullptr;
+
+    Image &image = images[std::make_pair(burnVersion, mylib)];
+    if (!image.built)
+        BuildImage(image, burnVersion, mylib);
+
+    // a fresh state would be burned-out while opening the libs
+    if (image.L == nullptr || image.burnedFuel > fuelLimit)
+        return nullptr;
+
+    memcpy(arena.base, image.bytes.data(), image.bytes.size());
+    arena.top   = image.bytes.size();
+    arena.inUse = true;
+
+    lua_burner_state *burnerState = lua_GetBurnerState(image.L);
+    burnerState->pContext  = pContext;
+    burnerState->fuelLimit = fuelLimit;
+    return image.L;
+}
+
+void CLuaStatePool::BuildImage(Image &image, int burnVersion, lua_CFunction mylib) {
+    image.built      = true;
+    arena.top        = 0;
+    arena.heapAllocs = 0;
+    arena.inUse      = true;
+
+    lua_State *L = lua_newstate(CLuaArena::Alloc, &arena);
+    if (L == nullptr) {
+        arena.Release();
+        return;
+    }
+    lua_atpanic(L, &LuaPanic);
+
+    bool ok = lua_StartBurner(L, nullptr, std::numeric_limits<uint64_t>::max(), burnVersion) &&
+              OpenContractLibs(L, mylib);
+    // the image is good only when all of the state lives in the arena
+    if (ok && arena.heapAllocs == 0) {
+        image.L          = L;
+        image.burnedFuel = lua_GetBurnedFuel(L);
+        image.bytes.assign(arena.base, arena.base + arena.top);
+    }
+
+    lua_close(L);
+    arena.Release();
+}
+
+bool OpenContractLibs(lua_State *L, lua_CFunction mylib) {
+    vm_openlibs(L);
+
+    if (!InitLuaLibsEx(L))
+        return false;
+
+    luaL_requiref(L, "mylib", mylib, 1);
+    return true;
+}
+
+void CloseLuaState(lua_State *L) {
+    void *ud;
+    lua_Alloc allocFunc = lua_getallocf(L, &ud);
+    lua_close(L);
+
+    if (allocFunc == CLuaArena::Alloc)
+        ((CLuaArena *)ud)->Release();
+}
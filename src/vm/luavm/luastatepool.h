@@ -0,0 +1,82 @@
+// Copyright (c) 2017-2020 The DragonBallChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LUA_STATE_POOL_H
+#define LUA_STATE_POOL_H
+
+#include "lua/lua.hpp"
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+/**
+ * Bump allocator of the lua states of one thread. The blocks are cut from one buffer and only the block on
+ * top is given back or resized in place, the others stay until the state is closed and the arena released.
+ * The blocks not fitting in the buffer fall back to the heap.
+ */
+class CLuaArena {
+public:
+    static const size_t ARENA_SIZE = 4 << 20;
+    static const size_t ALIGNMENT  = 16;
+
+public:
+    CLuaArena() {}
+    ~CLuaArena();
+
+    bool Init();
+    void Release() { top = 0; inUse = false; }
+
+    // the lua_Alloc function, ud is the arena
+    static void *Alloc(void *ud, void *ptr, size_t osize, size_t nsize);
+
+private:
+    bool Contains(const void *ptr) const { return ptr >= base && ptr < base + ARENA_SIZE; }
+    void *New(size_t nsize);
+
+public:
+    char *base          = nullptr;
+    size_t top          = 0;
+    uint64_t heapAllocs = 0;  // the blocks did not fit in the arena
+    bool inUse          = false;
+};
+
+/**
+ * Pre-initialised lua states of the running thread, one per burn version and mylib.
+ *
+ * The first state of a key is built in the arena with the burner started and the libs opened, and the arena
+ * bytes are kept as the image of the key. Later states are the image copied back to the same address, so they
+ * hold the same objects, GC state and burned fuel as a freshly built state, and nothing left by the previous
+ * contract (globals like contract, VmScriptRun or gCheckAccount) survives.
+ */
+class CLuaStatePool {
+public:
+    // a pooled state with the burner context and fuel limit set, null when the state must be built fresh
+    lua_State *Acquire(void *pContext, uint64_t fuelLimit, int burnVersion, lua_CFunction mylib);
+
+    static CLuaStatePool &GetThreadPool();
+
+private:
+    struct Image {
+        bool built          = false;
+        lua_State *L        = nullptr;  // null if the state can not be pooled
+        uint64_t burnedFuel = 0;
+        std::vector<char> bytes;
+    };
+
+    void BuildImage(Image &image, int burnVersion, lua_CFunction mylib);
+
+private:
+    CLuaArena arena;
+    std::map<std::pair<int, lua_CFunction>, Image> images;
+};
+
+// open the libs of the contract, done with the burner started
+bool OpenContractLibs(lua_State *L, lua_CFunction mylib);
+
+// close the state and give back its arena if it is pooled
+void CloseLuaState(lua_State *L);
+
+#endif  // LUA_STATE_POOL_H
@@ -18,6 +18,7 @@
 #include "main.h"
 #include "tx/tx.h"
 #include "luavmrunenv.h"
+#include "luastatepool.h"
 
 #if 0
 typedef struct NumArray{
@@ -255,33 +256,38 @@ tuple<uint64_t, string> CLuaVM::Run(uint64_t fuelLimit, CLuaVMRunEnv *pVmRunEnv)
         return std::make_tuple(-1, string("pVmRunEnv == NULL"));
     }
 
-    // 1.创建Lua运行环境
-    std::unique_ptr<lua_State, decltype(&lua_close)> lua_state_ptr(luaL_newstate(), &lua_close);
-    if (!lua_state_ptr) {
-        LogPrint(BCLog::LUAVM, "luaL_newstate() failed\n");
-        return std::make_tuple(-1, string("CLuaVM::Run luaL_newstate() failed\n"));
-    }
-    lua_State *lua_state = lua_state_ptr.get();
+    // 1.创建Lua运行环境, the pre-initialised state of the thread with the libs opened if possible
+    lua_CFunction mylib = GetLuaMylib(pVmRunEnv->GetContext().height);
+    std::unique_ptr<lua_State, decltype(&CloseLuaState)> lua_state_ptr(
+        CLuaStatePool::GetThreadPool().Acquire(pVmRunEnv, fuelLimit, pVmRunEnv->GetBurnVersion(), mylib),
+        &CloseLuaState);
+    if (lua_state_ptr) {
+#ifdef TRACE_LUA_VM_BURN
+        lua_SetBurnerTracer(lua_state_ptr.get(), TraceVmBurning);
+#endif//TRACE_LUA_VM_BURN
+    } else {
+        lua_state_ptr.reset(luaL_newstate());
+        if (!lua_state_ptr) {
+            LogPrint(BCLog::LUAVM, "luaL_newstate() failed\n");
+            return std::make_tuple(-1, string("CLuaVM::Run luaL_newstate() failed\n"));
+        }
 
-    if (!lua_StartBurner(lua_state, pVmRunEnv, fuelLimit, pVmRunEnv->GetBurnVersion())) {
-        LogPrint(BCLog::LUAVM, "lua_StartBurner() failed\n");
-        return std::make_tuple(-1, string("CLuaVM::Run lua_StartBurner() failed\n"));
-    }
+        if (!lua_StartBurner(lua_state_ptr.get(), pVmRunEnv, fuelLimit, pVmRunEnv->GetBurnVersion())) {
+            LogPrint(BCLog::LUAVM, "lua_StartBurner() failed\n");
+            return std::make_tuple(-1, string("CLuaVM::Run lua_StartBurner() failed\n"));
+        }
 
 #ifdef TRACE_LUA_VM_BURN
-    lua_SetBurnerTracer(lua_state, TraceVmBurning);
+        lua_SetBurnerTracer(lua_state_ptr.get(), TraceVmBurning);
 #endif//TRACE_LUA_VM_BURN
 
-    //打开需要的库
-    vm_openlibs(lua_state);
-
-    if (!InitLuaLibsEx(lua_state)) {
-        LogPrint(BCLog::LUAVM, "InitLuaLibsEx error\n");
-        return std::make_tuple(-1, string("InitLuaLibsEx error\n"));
+        //打开需要的库, 注册自定义模块
+        if (!OpenContractLibs(lua_state_ptr.get(), mylib)) {
+            LogPrint(BCLog::LUAVM, "InitLuaLibsEx error\n");
+            return std::make_tuple(-1, string("InitLuaLibsEx error\n"));
+        }
     }
-
-    // 3.注册自定义模块
-    luaL_requiref(lua_state, "mylib", GetLuaMylib(pVmRunEnv->GetContext().height), 1);
+    lua_State *lua_state = lua_state_ptr.get();
 
     // 4.往lua脚本传递合约内容
     lua_newtable(lua_state);  //新建一个表,压入栈顶
@@ -26,8 +26,9 @@ public:
     static std::tuple<bool, string> CheckScriptSyntax(const char *filePath, HeightType height);
 
 private:
-    // to hold contract call arguments
-    std::string code;
+    // not copied, the caller must keep the code string alive and unchanged until Run() returns
+    const std::string &code;
+    // the contract call arguments
     std::string arguments;
 };
 
@@ -80,24 +80,12 @@ namespace wasm {
         inline_transactions.push_back(t);
     }
 
-    bool wasm_context::get_code(const uint64_t& contract, std::vector <uint8_t> &code, uint256 &hash) {
-        CUniversalContractStore contract_store;
-        if (!database.contractCache.GetContract(CRegID(contract), contract_store))
-            return false;
-
-        code = vector <uint8_t>(contract_store.code.begin(), contract_store.code.end());
-        hash = contract_store.code_hash;
-        return true;
-    }
-
     uint64_t wasm_context::get_maintainer(const uint64_t& contract) {
-        CRegID   maintainer;
-        CUniversalContractStore contract_store;
-        if (!database.contractCache.GetContract(CRegID(contract), contract_store))
+        auto spMeta = database.contractCache.GetContractMeta(CRegID(contract));
+        if (!spMeta->exists)
             return false;
 
-        maintainer = contract_store.maintainer;
-        return maintainer.GetIntValue();
+        return spMeta->maintainer.GetIntValue();
     }
 
     void wasm_context::initialize() {
@@ -158,10 +146,10 @@ namespace wasm {
                 (*native)(*this, trx.action);
             } else {
                 auto bm_wasm = MAKE_BENCHMARK("execute wasm vm");
-                vector <uint8_t> code;
-                uint256 hash;
-                if (get_code(_receiver, code, hash) && code.size() > 0) {
-                    wasmif.execute(code, hash, this);
+                // execute by the code hash, the code is only read when the module is not instantiated yet
+                auto spMeta = database.contractCache.GetContractMeta(CRegID(_receiver));
+                if (spMeta->exists && spMeta->spStore->code.size() > 0) {
+                    wasmif.execute(spMeta->spStore->code, spMeta->code_hash, this);
                 }
             }
         }  catch (wasm_chain::exception &e) {
@@ -42,7 +42,6 @@ namespace wasm {
         void execute(inline_transaction_trace &trace);
         void execute_one(inline_transaction_trace &trace);
         bool has_permission_from_inline_transaction(const permission &p);
-        bool get_code(const uint64_t& contract, std::vector <uint8_t> &code, uint256 &hash);
 
 // Console methods:
     public:
@@ -75,8 +74,7 @@ namespace wasm {
         bool        get_system_asset_price(uint64_t base, uint64_t quote, std::vector<char>& price);
 
         bool set_data( const uint64_t& contract, const string& k, const string& v ) {
-            CUniversalContractStore contractStore;
-            CHAIN_ASSERT( database.contractCache.GetContract(CRegID(contract), contractStore),
+            CHAIN_ASSERT( database.contractCache.GetContractMeta(CRegID(contract))->exists,
                           contract_exception,
                           "contract '%s' does not exist",
                           wasm::regid(contract).to_string())
@@ -85,8 +83,7 @@ namespace wasm {
         }
 
         bool get_data( const uint64_t& contract, const string& k, string &v ) {
-            CUniversalContractStore contractStore;
-            CHAIN_ASSERT( database.contractCache.GetContract(CRegID(contract), contractStore),
+            CHAIN_ASSERT( database.contractCache.GetContractMeta(CRegID(contract))->exists,
                           contract_exception,
                           "contract '%s' does not exist",
                           wasm::regid(contract).to_string())
@@ -95,8 +92,7 @@ namespace wasm {
         }
 
         bool erase_data( const uint64_t& contract, const string& k ) {
-            CUniversalContractStore contractStore;
-            CHAIN_ASSERT( database.contractCache.GetContract(CRegID(contract), contractStore),
+            CHAIN_ASSERT( database.contractCache.GetContractMeta(CRegID(contract))->exists,
                           contract_exception,
                           "contract '%s' does not exist",
                           wasm::regid(contract).to_string())
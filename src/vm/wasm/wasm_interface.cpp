@@ -55,7 +55,7 @@ namespace wasm {
         get_runtime_interface()->immediately_exit_currently_running_module();
     }
 
-    std::shared_ptr <wasm_instantiated_module_interface> get_instantiated_backend(const vector <uint8_t> &code, const uint256 &hash) {
+    std::shared_ptr <wasm_instantiated_module_interface> get_instantiated_backend(const string &code, const uint256 &hash) {
 
         try {
             auto bm_wasm_hash = MAKE_BENCHMARK("load wasm vm -- load code hash");
@@ -77,7 +77,7 @@ namespace wasm {
 
     }
 
-    void wasm_interface::execute(const vector <uint8_t> &code, const uint256 &hash, wasm_context_interface *pWasmContext) {
+    void wasm_interface::execute(const string &code, const uint256 &hash, wasm_context_interface *pWasmContext) {
 
 
         auto bm_wasm_load = MAKE_BENCHMARK("load wasm vm with code");
@@ -23,9 +23,9 @@ static auto make(Api& api) {
 
         std::vector<char> abi;
         if (!get_native_contract_abi(account, abi)) {
-            CUniversalContractStore contract_store;
-            if (api.contractCache.GetContract(CRegID(account), contract_store)){
-                abi.insert(abi.end(), contract_store.abi.begin(), contract_store.abi.end());
+            auto spMeta = api.contractCache.GetContractMeta(CRegID(account));
+            if (spMeta->exists) {
+                abi.insert(abi.end(), spMeta->spStore->abi.begin(), spMeta->spStore->abi.end());
             }
         }
         return abi;